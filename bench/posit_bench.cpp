@@ -0,0 +1,141 @@
+// bench/posit_bench.cpp
+// Times the bit-manipulation posits (posit<>) against the table-driven
+// ones (tabulated<>): add, mul, div and sqrt over arrays of operands, then
+// a BasicSolver run of a small cluster in each format. Results must agree
+// bit for bit; the bench says so when they do not.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "physics/scalar_solver.hpp"
+#include "utils/posit_tables.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kOpRepeats = 20;
+
+enum class Op { Add, Mul, Div, Sqrt };
+
+const char* opName(Op op) {
+    switch (op) {
+        case Op::Add: return "add";
+        case Op::Mul: return "mul";
+        case Op::Div: return "div";
+        default:      return "sqrt";
+    }
+}
+
+// Operands spread over 2^-12..2^12 with random signs: the range a
+// normalized simulation visits.
+std::vector<double> operands(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<double> v(n);
+    for (double& x : v) {
+        const double frac = double(rng() >> 11) / 9007199254740992.0 + 0.5;
+        x = std::ldexp(frac, int(rng() % 24) - 12) * ((rng() & 1) ? -1.0 : 1.0);
+    }
+    return v;
+}
+
+// Nanoseconds per operation; the result bits go to `out`.
+template <typename T>
+double timeOp(Op op, const std::vector<double>& a, const std::vector<double>& b, std::vector<uint64_t>& out) {
+    const size_t n = a.size();
+    std::vector<T> x(n), y(n), r(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = T(a[i]);
+        y[i] = T(b[i]);
+    }
+    auto pass = [&] {
+        switch (op) {
+            case Op::Add: for (size_t i = 0; i < n; ++i) r[i] = x[i] + y[i]; break;
+            case Op::Mul: for (size_t i = 0; i < n; ++i) r[i] = x[i] * y[i]; break;
+            case Op::Div: for (size_t i = 0; i < n; ++i) r[i] = x[i] / y[i]; break;
+            case Op::Sqrt: for (size_t i = 0; i < n; ++i) r[i] = sqrt(x[i]); break;
+        }
+    };
+    pass();   // untimed: builds the tables and warms the caches
+
+    const auto start = Clock::now();
+    for (int rep = 0; rep < kOpRepeats; ++rep) pass();
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (kOpRepeats * double(n));
+
+    out.resize(n);
+    for (size_t i = 0; i < n; ++i) out[i] = r[i].bits();
+    return ns;
+}
+
+template <typename P>
+void benchOps(const char* name) {
+    const std::vector<double> a = operands(1 << 16, 1), b = operands(1 << 16, 2);
+    // sqrt of the magnitudes, as in the force kernel.
+    std::vector<double> absA(a.size());
+    for (size_t i = 0; i < a.size(); ++i) absA[i] = std::fabs(a[i]);
+
+    for (Op op : {Op::Add, Op::Mul, Op::Div, Op::Sqrt}) {
+        const std::vector<double>& lhs = op == Op::Sqrt ? absA : a;
+        std::vector<uint64_t> slow, fast;
+        const double tSlow = timeOp<P>(op, lhs, b, slow);
+        const double tFast = timeOp<tabulated<P>>(op, lhs, b, fast);
+        std::printf("%-9s %-4s  posit %7.2f ns  tabulated %7.2f ns  x%5.1f%s\n", name, opName(op), tSlow, tFast,
+                    tSlow / tFast, slow == fast ? "" : "  MISMATCH");
+    }
+}
+
+// A cold cluster of equal masses in units with G = 1, inside the range of
+// the 8- and 16-bit formats.
+template <typename Scalar>
+double runSolver(size_t bodies, size_t steps, std::vector<double>& state) {
+    BasicSolver<Scalar> solver(0.01, 1.0);
+    std::mt19937_64 rng(3);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    for (size_t i = 0; i < bodies; ++i) {
+        Body body;
+        body.mass = 1.0 / double(bodies);
+        body.position = {u(rng), u(rng), u(rng)};
+        body.velocity = {0.1 * u(rng), 0.1 * u(rng), 0.0};
+        solver.addBody(body);
+    }
+    solver.computeAccelerations();
+
+    const auto start = Clock::now();
+    solver.advance(steps);
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    state.clear();
+    for (size_t i = 0; i < bodies; ++i) {
+        const Body b = solver.toBody(i);
+        state.insert(state.end(), {b.position.x, b.position.y, b.position.z});
+    }
+    return ms;
+}
+
+template <typename P>
+void benchSolver(const char* name) {
+    constexpr size_t kBodies = 64, kSteps = 200;
+    std::vector<double> slow, fast;
+    const double tSlow = runSolver<P>(kBodies, kSteps, slow);
+    const double tFast = runSolver<tabulated<P>>(kBodies, kSteps, fast);
+    // NaN == NaN is false: compare the bits.
+    bool same = slow.size() == fast.size();
+    for (size_t i = 0; same && i < slow.size(); ++i)
+        same = std::memcmp(&slow[i], &fast[i], sizeof(double)) == 0;
+    std::printf("%-9s BasicSolver %zu bodies x %zu steps  posit %8.1f ms  tabulated %8.1f ms  x%5.1f%s\n", name,
+                kBodies, kSteps, tSlow, tFast, tSlow / tFast, same ? "" : "  MISMATCH");
+}
+
+}
+
+int main() {
+    benchOps<posit8>("posit8");
+    benchOps<posit16>("posit16");
+    benchOps<bposit16>("bposit16");
+    benchSolver<posit8>("posit8");
+    benchSolver<posit16>("posit16");
+    benchSolver<bposit16>("bposit16");
+    return 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "body_storage.hpp"
+#include "force_kernels.hpp"
+
+struct BarnesHutParams {
+    double theta = 0.5;        // opening angle: smaller is more accurate
+    bool quadrupole = true;    // add quadrupole moments to the monopole
+    size_t leafSize = 16;      // bodies per leaf before a cell is split
+};
+
+// Octree over one body set with monopole + quadrupole moments per cell.
+//
+// Forces are evaluated per leaf rather than per body: one walk builds the
+// interaction list for the whole leaf (cells accepted against the leaf's
+// bounding box, plus leaves too close to approximate), and the near-field
+// leaves are then summed with the SIMD pair kernel over bodies stored
+// contiguously in tree order.
+class BarnesHutTree {
+public:
+    // Per-worker interaction lists, reused between calls.
+    struct Scratch {
+        std::vector<int32_t> cells;
+        std::vector<int32_t> near;
+        std::vector<int32_t> stack;
+        AlignedVector<double> cx, cy, cz, cm, q;
+    };
+
+    // Builds the tree (serial, O(N log N)) and copies the bodies into tree
+    // order.
+    void build(const SourceSet& bodies, const BarnesHutParams& params);
+
+    size_t leafCount() const { return m_leaves.size(); }
+
+    // Evaluates every body of one leaf. Leaves are independent, so workers
+    // may evaluate different leaves concurrently. Results go to the
+    // tree-ordered acceleration columns.
+    void evaluateLeaf(size_t leaf, ForceKernel kernel, double G, Scratch& scratch);
+
+    // Copies tree-ordered accelerations of bodies [begin, end) (tree order)
+    // back to the caller's indexing.
+    void scatter(size_t begin, size_t end, const AccelSet& out) const;
+
+    size_t nodeCount() const { return m_nodes.size(); }
+
+private:
+    struct Node {
+        double cx, cy, cz;     // centre of mass
+        double mass;
+        double q[6];           // traceless quadrupole: xx, xy, xz, yy, yz, zz
+        double openR2;         // accepted when the target box is farther than sqrt(openR2)
+        double lo[3], hi[3];   // bounding box of the bodies inside
+        uint32_t begin, end;   // body range in tree order
+        int32_t child[8];
+        bool leaf;
+    };
+
+    int32_t buildNode(uint32_t begin, uint32_t end, double ox, double oy, double oz,
+                      double half, int depth);
+
+    SourceSet m_src{};
+    BarnesHutParams m_params;
+    std::vector<Node> m_nodes;
+    std::vector<int32_t> m_leaves;
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_scratch;
+
+    // Bodies and results in tree order.
+    AlignedVector<double> m_x, m_y, m_z, m_m;
+    AlignedVector<double> m_ax, m_ay, m_az;
+};
@@ -1,6 +1,7 @@
 
 #pragma once
 #include <glm/glm.hpp>  
+#include "utils/math.hpp"
 
 struct Body {
     double mass;
@@ -9,3 +10,12 @@ struct Body {
     glm::dvec3 acceleration;
     glm::vec3 color;     
 };
+
+// A body in another number format, for BasicSolver<Scalar>.
+template <typename Scalar>
+struct BasicBody {
+    Scalar mass{};
+    Vec3<Scalar> position;
+    Vec3<Scalar> velocity;
+    Vec3<Scalar> acceleration;
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <glm/glm.hpp>
+#include "body.hpp"
+
+// Cache-line aligned allocator so every SoA column starts on a 64-byte
+// boundary and vector loads in the force kernels never split a line.
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Structure-of-arrays body state. The hot fields used by the force pass
+// live in separate contiguous columns; render-only data sits in a side table.
+struct BodyStorage {
+    AlignedVector<double> x, y, z;
+    AlignedVector<double> mass;
+    AlignedVector<double> vx, vy, vz;
+    AlignedVector<double> ax, ay, az;
+    std::vector<glm::vec3> color;
+
+    size_t size() const { return mass.size(); }
+    bool empty() const { return mass.empty(); }
+
+    void reserve(size_t n) {
+        for (auto* col : {&x, &y, &z, &mass, &vx, &vy, &vz, &ax, &ay, &az}) col->reserve(n);
+        color.reserve(n);
+    }
+
+    void push(const Body& b) {
+        x.push_back(b.position.x);  y.push_back(b.position.y);  z.push_back(b.position.z);
+        mass.push_back(b.mass);
+        vx.push_back(b.velocity.x); vy.push_back(b.velocity.y); vz.push_back(b.velocity.z);
+        ax.push_back(b.acceleration.x); ay.push_back(b.acceleration.y); az.push_back(b.acceleration.z);
+        color.push_back(b.color);
+    }
+
+    glm::dvec3 position(size_t i) const { return {x[i], y[i], z[i]}; }
+    glm::dvec3 velocity(size_t i) const { return {vx[i], vy[i], vz[i]}; }
+    glm::dvec3 acceleration(size_t i) const { return {ax[i], ay[i], az[i]}; }
+
+    void setPosition(size_t i, const glm::dvec3& p) { x[i] = p.x; y[i] = p.y; z[i] = p.z; }
+    void setVelocity(size_t i, const glm::dvec3& v) { vx[i] = v.x; vy[i] = v.y; vz[i] = v.z; }
+    void setAcceleration(size_t i, const glm::dvec3& a) { ax[i] = a.x; ay[i] = a.y; az[i] = a.z; }
+
+    Body get(size_t i) const {
+        Body b;
+        b.mass = mass[i];
+        b.position = position(i);
+        b.velocity = velocity(i);
+        b.acceleration = acceleration(i);
+        b.color = color[i];
+        return b;
+    }
+};
+
+// Lightweight handle to one body inside a BodyStorage. Reads assemble
+// vectors straight from the columns; nothing is copied out of the solver.
+template <typename Storage>
+class BasicBodyRef {
+public:
+    BasicBodyRef(Storage* s, size_t i) : m_storage(s), m_index(i) {}
+
+    size_t index() const { return m_index; }
+
+    double mass() const { return m_storage->mass[m_index]; }
+    glm::dvec3 position() const { return m_storage->position(m_index); }
+    glm::dvec3 velocity() const { return m_storage->velocity(m_index); }
+    glm::dvec3 acceleration() const { return m_storage->acceleration(m_index); }
+    const glm::vec3& color() const { return m_storage->color[m_index]; }
+
+    void setMass(double m) const { m_storage->mass[m_index] = m; }
+    void setPosition(const glm::dvec3& p) const { m_storage->setPosition(m_index, p); }
+    void setVelocity(const glm::dvec3& v) const { m_storage->setVelocity(m_index, v); }
+    void setColor(const glm::vec3& c) const { m_storage->color[m_index] = c; }
+
+private:
+    Storage* m_storage;
+    size_t m_index;
+};
+
+template <typename Storage>
+class BasicBodyView {
+public:
+    using Ref = BasicBodyRef<Storage>;
+
+    class iterator {
+    public:
+        iterator(Storage* s, size_t i) : m_storage(s), m_index(i) {}
+        Ref operator*() const { return Ref(m_storage, m_index); }
+        iterator& operator++() { ++m_index; return *this; }
+        bool operator!=(const iterator& o) const { return m_index != o.m_index; }
+        bool operator==(const iterator& o) const { return m_index == o.m_index; }
+    private:
+        Storage* m_storage;
+        size_t m_index;
+    };
+
+    explicit BasicBodyView(Storage& s) : m_storage(&s) {}
+    template <typename Other>
+    BasicBodyView(const BasicBodyView<Other>& o) : m_storage(&o.storage()) {}
+
+    size_t size() const { return m_storage->size(); }
+    bool empty() const { return m_storage->empty(); }
+
+    Ref operator[](size_t i) const { return Ref(m_storage, i); }
+    iterator begin() const { return iterator(m_storage, 0); }
+    iterator end() const { return iterator(m_storage, m_storage->size()); }
+
+    Storage& storage() const { return *m_storage; }
+
+private:
+    Storage* m_storage;
+};
+
+using BodyRef = BasicBodyRef<BodyStorage>;
+using ConstBodyRef = BasicBodyRef<const BodyStorage>;
+using BodyView = BasicBodyView<BodyStorage>;
+using ConstBodyView = BasicBodyView<const BodyStorage>;
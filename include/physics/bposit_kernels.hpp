@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "force_kernels.hpp"
+
+// Batch kernels for bposit32 (posit<32, 5, 6>) arrays. The regime run is
+// capped at 6 bits, so decoding is a fixed sequence of shifts and compares
+// with no count-leading-zeros loop, and the AVX2 / AVX-512 paths run it on
+// 4 / 8 posits at once in 64-bit integer lanes.
+//
+// Inside the kernels a bposit32 travels as the double holding its exact
+// value (at most 25 significant bits, scale within +-192): decode widens to
+// that double, an operation runs in double and the result is rounded back
+// onto the bposit32 grid with integer ops on the double's bit pattern
+// (nearest even, saturating at minpos / maxpos, NaN for NaR). Double has
+// more than twice the precision plus two bits, so add and mul rounded this
+// way equal the correctly rounded posit result; fma carries the sticky bit
+// of the exact a * b + c with round-to-odd and is also rounded once. rsqrt
+// rounds 1 / sqrt(x) from double and can differ from a correctly rounded
+// posit rsqrt in the last bit on rare near-ties.
+//
+// Every entry point takes the ForceKernel to run (resolved as for the
+// force kernels); the SIMD paths give the same bits as the scalar one.
+namespace bposit {
+
+void decode(ForceKernel kernel, const uint32_t* in, double* out, size_t n);
+void encode(ForceKernel kernel, const double* in, uint32_t* out, size_t n);
+
+// Nearest bposit32 value of each double, kept as a double.
+void round(ForceKernel kernel, const double* in, double* out, size_t n);
+
+// Element-wise on encoded arrays; out may alias an input.
+void add(ForceKernel kernel, const uint32_t* a, const uint32_t* b, uint32_t* out, size_t n);
+void mul(ForceKernel kernel, const uint32_t* a, const uint32_t* b, uint32_t* out, size_t n);
+// a * b + c with a single rounding.
+void fma(ForceKernel kernel, const uint32_t* a, const uint32_t* b, const uint32_t* c, uint32_t* out, size_t n);
+// 1 / sqrt(a); NaR for a <= 0.
+void rsqrt(ForceKernel kernel, const uint32_t* a, uint32_t* out, size_t n);
+
+}
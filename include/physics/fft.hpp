@@ -0,0 +1,27 @@
+#pragma once
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// In-place radix-2 complex FFT of one fixed power-of-two length. Twiddles
+// and the bit-reversal permutation are computed once per plan, so a plan
+// can be shared read-only by every worker transforming its own lines.
+class Fft {
+public:
+    // n is rounded up to the next power of two.
+    explicit Fft(size_t n = 1);
+
+    size_t size() const { return m_n; }
+
+    // X_k = sum_j x_j exp(-2 pi i jk/n).
+    void forward(std::complex<double>* data) const;
+    // Unnormalised inverse: applying forward then inverse scales by n.
+    void inverse(std::complex<double>* data) const;
+
+private:
+    void transform(std::complex<double>* data, bool inverse) const;
+
+    size_t m_n;
+    std::vector<size_t> m_reverse;
+    std::vector<std::complex<double>> m_twiddle;   // exp(-2 pi i k/n), k < n/2
+};
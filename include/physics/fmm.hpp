@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "body_storage.hpp"
+#include "force_kernels.hpp"
+#include "thread_pool.hpp"
+
+struct FmmParams {
+    int order = 4;          // Cartesian expansion order p (accuracy vs. speed)
+    double theta = 0.5;     // cells interact by M2L when (rA + rB) < theta * |cA - cB|
+    size_t leafSize = 64;   // bodies per leaf before a cell is split
+};
+
+// Fast multipole method on an adaptive octree with Cartesian Taylor
+// expansions about each cell's centre of mass.
+//
+//   P2M  leaf bodies -> multipole moments
+//   M2M  children -> parent, bottom-up
+//   M2L  multipole of a well-separated cell -> local expansion of another
+//        (interaction lists from a dual tree walk, run in parallel by target)
+//   L2L  parent local -> children, top-down
+//   L2P  local expansion -> body accelerations, plus P2P for near leaves
+//
+// Positions are rescaled to the unit root box internally so the high
+// powers in the expansions stay well inside double range.
+class FmmSolver {
+public:
+    void evaluate(const SourceSet& bodies, const AccelSet& out, double G,
+                  const FmmParams& params, ForceKernel kernel, ThreadPool& pool);
+
+    size_t nodeCount() const { return m_nodes.size(); }
+    size_t m2lCount() const { return m_m2l.size(); }
+
+private:
+    struct Node {
+        double c[3];             // expansion centre (centre of mass)
+        double radius;           // max distance of a body from c
+        uint32_t begin, end;     // body range in tree order
+        int32_t child[8];
+        int level;
+        bool leaf;
+    };
+
+    // Multi-index bookkeeping for a given order, rebuilt when p changes.
+    struct Term {
+        int a, b, c;
+        int dec[3];   // term with one power fewer along x, y, z (-1 if none)
+    };
+    struct ShiftEntry { int target, source, offset; double coef; };
+
+    void prepareOrder(int order);
+    int termIndex(int a, int b, int c) const;
+
+    void buildTree(const SourceSet& bodies);
+    int32_t buildNode(uint32_t begin, uint32_t end, double ox, double oy, double oz,
+                      double half, int level);
+    void walk(int32_t a, int32_t b);
+
+    void p2m(int32_t node);
+    void m2m(int32_t node);
+    void m2l(int32_t target, int32_t source, double* local, double* deriv) const;
+    void l2l(int32_t node);
+    void l2p(int32_t leaf, double* mono);
+
+    FmmParams m_params;
+    int m_p = -1;
+    std::vector<Term> m_terms;
+    std::vector<int> m_index;          // (a, b, c) -> term, dense (p+1)^3 table
+    std::vector<double> m_invFact;     // 1 / (a! b! c!) per term
+    std::vector<ShiftEntry> m_m2m;     // M_target += M_child[source] * t^offset / offset!
+    std::vector<ShiftEntry> m_l2l;     // L_target += L_parent[source] * coef * s^offset / offset!
+    std::vector<ShiftEntry> m_m2lPairs;// L_target += Mneg[source] * D[offset] * coef
+
+    double m_origin[3] = {0.0, 0.0, 0.0};
+    double m_scale = 1.0;
+    std::vector<Node> m_nodes;
+    std::vector<std::vector<int32_t>> m_levels;
+    std::vector<int32_t> m_leaves;
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_sortScratch;
+    AlignedVector<double> m_x, m_y, m_z, m_m;
+    AlignedVector<double> m_ax, m_ay, m_az;
+    SourceSet m_src{};
+
+    std::vector<double> m_multipole;   // nodes * terms
+    std::vector<double> m_local;       // nodes * terms
+
+    // Interaction lists from the dual walk, grouped by target after sorting.
+    std::vector<std::pair<int32_t, int32_t>> m_m2l;
+    std::vector<std::pair<int32_t, int32_t>> m_p2p;
+    std::vector<size_t> m_m2lStart;
+    std::vector<int32_t> m_m2lTargets;
+    std::vector<std::vector<double>> m_workerScratch;
+};
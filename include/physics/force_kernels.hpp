@@ -0,0 +1,169 @@
+#pragma once
+#include <cstddef>
+
+// Direct-summation pair kernels. Sources and targets are plain SoA column
+// pointers so the same kernels serve the whole body set, a gathered
+// neighbour list, or a sub-range handed out to one worker.
+
+enum class ForceKernel {
+    Auto,     // widest SIMD kernel the CPU supports
+    Scalar,   // reference loop, one pair at a time
+    Avx2,     // 4 sources per instruction
+    Avx512    // 8 sources per instruction
+};
+
+// Arithmetic of the direct sum's pair interactions and their accumulation.
+enum class ForcePrecision {
+    Double,   // everything in double
+    Mixed,    // float32 pair terms on relative coordinates, double accumulation
+    Bposit32, // every pair operation and the sums rounded to bposit32
+    Exact     // double pair terms summed exactly, rounded once per body
+};
+
+struct SourceSet {
+    const double* x;
+    const double* y;
+    const double* z;
+    const double* m;
+    size_t n;
+};
+
+struct AccelSet {
+    double* ax;
+    double* ay;
+    double* az;
+};
+
+struct TargetSet {
+    const double* x;
+    const double* y;
+    const double* z;
+    double* ax;
+    double* ay;
+    double* az;
+};
+
+// Sources and targets with velocities, for the Hermite kernel that also
+// returns the jerk (time derivative of the acceleration).
+struct PhaseSourceSet {
+    const double* x;
+    const double* y;
+    const double* z;
+    const double* vx;
+    const double* vy;
+    const double* vz;
+    const double* m;
+    size_t n;
+};
+
+struct PhaseTargetSet {
+    const double* x;
+    const double* y;
+    const double* z;
+    const double* vx;
+    const double* vy;
+    const double* vz;
+    double* ax;
+    double* ay;
+    double* az;
+    double* jx;
+    double* jy;
+    double* jz;
+};
+
+// Optional radial factor applied on top of 1/r^3, tabulated uniformly in
+// r^2: pairs see f(r^2) = table[u] interpolated at u = r^2 * invStep, and
+// pairs with u >= size contribute nothing (table[size] and table[size + 1]
+// must be 0). Used for the short-range part of a force split.
+struct PairShape {
+    const double* table;   // size + 2 entries
+    size_t size;
+    double invStep;
+};
+
+#ifndef NBODY_TILE_I
+#define NBODY_TILE_I 64     // targets per tile of the blocked direct kernel
+#endif
+#ifndef NBODY_TILE_J
+#define NBODY_TILE_J 512    // sources per tile: 4 columns x 512 doubles = 16 KiB of L1
+#endif
+
+// Tile sizes of accumulateTiled. The defaults come from the build
+// (NBODY_TILE_I / NBODY_TILE_J) and can be changed at runtime.
+struct TileConfig {
+    size_t i = NBODY_TILE_I;
+    size_t j = NBODY_TILE_J;
+};
+
+namespace kernels {
+
+bool cpuHasAvx2();
+bool cpuHasAvx512();
+
+// Maps Auto to the best available kernel and downgrades a request the
+// running CPU (or the compiler) cannot honour.
+ForceKernel resolve(ForceKernel kernel);
+
+const char* name(ForceKernel kernel);
+
+// Adds G * sum_j m_j (r_j - r_i) / |r_j - r_i|^3 to the accelerations of
+// targets [begin, end). Coincident pairs (including i == j when targets
+// alias sources) contribute nothing. With a shape, each pair is further
+// scaled by the tabulated f(r^2).
+void accumulateDirect(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                      size_t begin, size_t end, double G, const PairShape* shape = nullptr);
+
+// Same sum as accumulateDirect, cache-blocked for large source sets: a
+// block of tiles.i targets is evaluated against one tile of tiles.j
+// sources at a time, so the source tile stays in L1 while it is reused.
+// Inside a tile a register-blocked micro-kernel runs four targets per
+// pass and loads each SIMD slice of sources once for all four.
+void accumulateTiled(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                     size_t begin, size_t end, double G, const TileConfig& tiles);
+
+// Mixed-precision direct sum. Targets are processed in blocks of
+// kMixedBlock at absolute indices; for each block the sources are converted
+// once to float32 offsets from the block's first target, so the float
+// separations lose no more than float rounding of the offsets. Pair terms
+// are float32 at twice the SIMD width, summed in float over short runs of
+// sources and then added into double accumulators. The reference points
+// and scales depend only on the target index, so the result does not
+// depend on the split of targets between calls (or threads); callers
+// should still cut at multiples of kMixedBlock to keep the blocks full.
+constexpr size_t kMixedBlock = 64;
+void accumulateMixed(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                     size_t begin, size_t end, double G);
+
+// The direct sum with each target's sums rounded once from their exact
+// values. Bitwise reproducible: the result does not depend on the kernel,
+// the source order or the split of targets between calls. Sums run
+// compensated with an error bound, which settles the rounding for almost
+// every target at a few times the plain sum's cost; the rest are summed
+// again in Kulisch accumulators (utils/quire.hpp).
+void accumulateExact(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                     size_t begin, size_t end, double G);
+
+// The direct sum run on the bposit32 grid (bposit_kernels.hpp): positions,
+// masses and G are rounded to bposit32 and so is every step of each pair
+// term and of the per-target sums; only the final add into dst is double.
+// Vectorized across targets, so all kernels return the same bits.
+void accumulateBposit(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                      size_t begin, size_t end, double G);
+
+// Accelerations as accumulateDirect plus the jerks
+// G * sum_j m_j [v_ij - 3 (r_ij . v_ij) r_ij / r^2] / r^3 of targets
+// [begin, end), with r_ij = r_j - r_i and v_ij = v_j - v_i, in one pass.
+void accumulateJerk(ForceKernel kernel, const PhaseSourceSet& src, const PhaseTargetSet& dst,
+                    size_t begin, size_t end, double G);
+
+// Newton's-third-law variant over a single body set: rows [begin, end) of
+// the upper triangle, each unordered pair (i, j > i) evaluated once and
+// applied with opposite signs to i and j in `out`.
+void accumulateSymmetric(ForceKernel kernel, const SourceSet& bodies, const AccelSet& out,
+                         size_t begin, size_t end, double G);
+
+// First row of part `k` when the upper-triangle rows of an n-body set are
+// split into `parts` ranges holding roughly equal numbers of pairs.
+size_t triangleRowSplit(size_t n, size_t parts, size_t k);
+
+}
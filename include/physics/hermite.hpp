@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "body_storage.hpp"
+#include "force_kernels.hpp"
+#include "integrator.hpp"
+#include "thread_pool.hpp"
+
+struct HermiteParams {
+    int maxLevel = 12;        // finest step is dt / 2^maxLevel (at most 30)
+    double eta = 0.02;        // Aarseth criterion accuracy
+    double etaStart = 0.01;   // first steps: etaStart |a| / |j|
+};
+
+// Fourth-order Hermite predictor-corrector (Makino & Aarseth 1992) on
+// power-of-two block timesteps. Every body is predicted to the current
+// tick with its acceleration and jerk. The due bodies get their
+// acceleration and jerk from one direct-sum pass (kernels::accumulateJerk)
+// against the predicted set. The corrector then fits snap and crackle
+// from the two endpoints. New steps follow the Aarseth criterion
+//
+//   dt = sqrt(eta (|a| |a''| + |a'|^2) / (|a'| |a'''| + |a''|^2)).
+//
+// Forces always come from the direct sum, whatever the solver backend.
+class HermiteIntegrator {
+public:
+    // Advances the bodies by dt (the coarsest level); stats receives the
+    // substep and target counts.
+    void step(BodyStorage& bodies, double dt, double G, const HermiteParams& params,
+              ForceKernel kernel, ThreadPool& pool, BlockTimestepStats& stats);
+
+    // Drops levels and jerks; the next step starts with a fresh evaluation.
+    void reset() { m_schedule.level.clear(); }
+
+private:
+    void start(BodyStorage& bodies, double dt, double G, ForceKernel kernel, ThreadPool& pool);
+    void predict(const BodyStorage& bodies, uint64_t tick, double tickLength, ThreadPool& pool);
+    // Acceleration and jerk of the first `count` bodies of the schedule
+    // order, at their predicted state, into m_ax.. m_jz (gathered order).
+    void evaluate(const BodyStorage& bodies, size_t count, double G, ForceKernel kernel, ThreadPool& pool);
+
+    HermiteParams m_params;
+    BlockSchedule m_schedule;
+    std::vector<uint64_t> m_time;                  // tick of each body's last correction
+    AlignedVector<double> m_jx, m_jy, m_jz;        // jerk at that tick
+    AlignedVector<double> m_px, m_py, m_pz;        // predicted state of every body
+    AlignedVector<double> m_pvx, m_pvy, m_pvz;
+    AlignedVector<double> m_tx, m_ty, m_tz;        // gathered due targets
+    AlignedVector<double> m_tvx, m_tvy, m_tvz;
+    AlignedVector<double> m_ax, m_ay, m_az;        // their new acceleration and jerk
+    AlignedVector<double> m_tjx, m_tjy, m_tjz;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "body_storage.hpp"
+#include "thread_pool.hpp"
+
+// Kepler-drift/kick map on a hierarchical Jacobi tree (Hamers-style
+// nested binaries). The tree is built by repeatedly pairing the two
+// bodies or subtrees with the shortest mutual two-body period, so
+// Sun-Earth-Moon becomes Sun -> (Earth-Moon barycentre) -> Moon and a
+// planetary system becomes the usual Jacobi chain. Each tree node stores
+// the separation and relative velocity of its two children's barycentres;
+// the root stores the overall barycentre.
+//
+//   kick(dt/2) kepler(dt) kick(dt/2)
+//
+// The drift moves every node on its exact Kepler orbit about
+// G (M_A + M_B); the kicks apply the rest of the gravity, from the
+// caller's inertial accelerations, as a_B - a_A minus the Kepler part.
+// One force pass per step.
+//
+// The state lives in relative coordinates between steps, so the Moon's
+// orbit keeps its digits instead of riding on the 1.5e11 m Earth orbit.
+// Bodies are only reconstructed in absolute coordinates for the force
+// pass and the output. Like WisdomHolman it reloads (and rebuilds the
+// tree) only when the bodies no longer match what the last step wrote.
+// Building the tree is O(N^3); the scheme is meant for few-body
+// hierarchies.
+class HierarchicalJacobi {
+public:
+    // forces() must fill bodies.ax/ay/az for the positions in bodies.x/y/z.
+    template <typename Forces>
+    void step(BodyStorage& bodies, double dt, double G, ThreadPool& pool, Forces&& forces) {
+        if (bodies.empty()) return;
+        if (!resume(bodies, G)) {
+            load(bodies, G);
+            writePositions(bodies);
+            forces();
+            interaction(bodies);
+        }
+        kick(0.5 * dt);
+        kepler(dt, pool);
+        writePositions(bodies);
+        forces();
+        interaction(bodies);
+        kick(0.5 * dt);
+        writeState(bodies);
+        record(bodies);
+    }
+
+    // Tree node: children are bodies (id < N) or nodes (id - N).
+    struct Node {
+        uint32_t a, b;          // a is the heavier child
+        double massA, massB;
+    };
+    const std::vector<Node>& tree() const { return m_nodes; }
+
+private:
+    struct State {
+        std::vector<double> qx, qy, qz;   // slot 0: barycentre, slot k + 1: node k
+        std::vector<double> vx, vy, vz;
+        std::vector<double> kx, ky, kz;   // interaction accelerations
+    };
+
+    bool resume(const BodyStorage& bodies, double G) const;
+    void load(const BodyStorage& bodies, double G);
+    void record(const BodyStorage& bodies);
+    void writePositions(BodyStorage& bodies);
+    void writeState(BodyStorage& bodies);
+
+    void kepler(double h, ThreadPool& pool);
+    void kick(double h);
+    void interaction(const BodyStorage& bodies);
+
+    // Per-body column <-> tree slots (barycentre, then B - A per node).
+    void toTree(const double* col, double* q);
+    void fromTree(const double* q, double* col);
+
+    size_t m_n = 0;
+    double m_G = 0.0;
+    std::vector<Node> m_nodes;       // bottom-up; the root is last
+    std::vector<double> m_mass;      // bodies, then nodes; the last entry is the root
+    std::vector<double> m_values;    // scratch, one per body and node
+    State m_state;
+
+    // Coordinates written by the last step, to detect outside edits.
+    std::vector<double> m_outX, m_outY, m_outZ, m_outVx, m_outVy, m_outVz;
+};
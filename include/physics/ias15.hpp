@@ -0,0 +1,123 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "body_storage.hpp"
+
+struct Ias15Params {
+    double epsilon = 1e-9;      // step control target for |b6| / |a|
+    double minStep = 0.0;       // floor on the internal step (0 = none)
+    int maxIterations = 12;     // predictor-corrector passes per step
+};
+
+// Work done by the last Solver::update with IAS15.
+struct Ias15Stats {
+    size_t steps = 0;
+    size_t rejected = 0;
+    size_t forceEvaluations = 0;
+    double stepSize = 0.0;      // internal step the next update starts with
+};
+
+// 15th-order Gauss-Radau integrator with adaptive steps (IAS15, Rein &
+// Spiegel 2015). Within a step the acceleration is a degree-7 polynomial
+// in time whose coefficients b0..b6 are refined by a predictor-corrector
+// iteration over the 7 Radau nodes until they stop changing. The next
+// step size follows from |b6| / |a|, so the truncation error stays below
+// double rounding. A step that would need to shrink by more than 4x is
+// rejected and redone. Positions and velocities are updated with
+// compensated summation.
+//
+// Forces are pluggable: forces() must fill bodies.ax/ay/az for the
+// positions in bodies.x/y/z, so any backend and kernel can drive it.
+// advance() covers exactly `interval` and clips its last internal step;
+// the internal step carries over to the next call.
+class Ias15 {
+public:
+    Ias15();
+
+    template <typename Forces>
+    void advance(BodyStorage& bodies, double interval, const Ias15Params& params, Forces&& forces) {
+        m_stats = Ias15Stats{};
+        if (bodies.size() != m_n) reset(bodies.size(), interval);
+        if (m_n == 0 || interval <= 0.0) return;
+
+        double done = 0.0;
+        bool fresh = false;   // accelerations match the current positions
+        while (done < interval) {
+            const double remaining = interval - done;
+            const bool clipped = m_dt >= remaining;
+            const double h = clipped ? remaining : m_dt;
+            if (!fresh) {
+                forces();
+                ++m_stats.forceEvaluations;
+            }
+            if (!step(bodies, h, clipped, params, forces)) {
+                fresh = true;
+                ++m_stats.rejected;
+                continue;
+            }
+            fresh = false;
+            ++m_stats.steps;
+            done = clipped ? interval : done + h;
+        }
+        m_stats.stepSize = m_dt;
+    }
+
+    // Forgets the internal step and the predicted coefficients.
+    void reset() { m_n = size_t(-1); }
+
+    const Ias15Stats& stats() const { return m_stats; }
+
+private:
+    using Coefficients = std::array<std::vector<double>, 7>;
+
+    void reset(size_t n, double interval);
+
+    template <typename Forces>
+    bool step(BodyStorage& bodies, double h, bool clipped, const Ias15Params& params, Forces& forces) {
+        begin(bodies);
+        double previous = HUGE_VAL;
+        for (int it = 0; it < params.maxIterations; ++it) {
+            for (int node = 1; node < 8; ++node) {
+                predict(bodies, node, h);
+                forces();
+                ++m_stats.forceEvaluations;
+                absorb(bodies, node);
+            }
+            // Converged to rounding, or the corrections started to grow.
+            if (m_correction < 1e-16) break;
+            if (it > 2 && m_correction > previous) break;
+            previous = m_correction;
+        }
+        return finish(bodies, h, clipped, params);
+    }
+
+    // Saves x0, v0, a0 and derives g from the predicted b.
+    void begin(const BodyStorage& bodies);
+    // Positions at Radau node `node` of a step of size h.
+    void predict(BodyStorage& bodies, int node, double h) const;
+    // Folds the accelerations at `node` into g and b.
+    void absorb(const BodyStorage& bodies, int node);
+    // Accepts (updates x, v) or rejects (restores x, v) the step and picks
+    // the next internal step.
+    bool finish(BodyStorage& bodies, double h, bool clipped, const Ias15Params& params);
+    // New b (and e) for a step `ratio` times the last, from the
+    // coefficients of that step.
+    void predictNext(double ratio, const Coefficients& e, const Coefficients& b);
+
+    size_t m_n = size_t(-1);
+    double m_dt = 0.0;
+    double m_lastAccepted = 0.0;
+    double m_correction = 0.0;   // max |delta b6| / max |a| of the last pass
+    Ias15Stats m_stats;
+
+    double m_rr[28];             // h_n - h_k for k < n
+    double m_c[21];              // b from g
+    double m_d[21];              // g from b
+
+    std::vector<double> m_x0, m_v0, m_a0;   // 3N, interleaved per body
+    std::vector<double> m_csx, m_csv;       // compensated-summation remainders
+    Coefficients m_b, m_g, m_e;
+    Coefficients m_bSaved, m_eSaved;        // coefficients of the last accepted step
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Time integrators for Solver::update. Velocity Verlet, leapfrog and the
+// Yoshida schemes are symmetric compositions of kick-drift-kick leapfrog
+// substeps, so that family runs through one loop driven by a weight
+// table; the others live in their own modules. Nothing in the step is
+// dispatched virtually.
+enum class Integrator {
+    VelocityVerlet,   // 2nd order, 1 force pass per step (original formulation)
+    Leapfrog,         // 2nd order kick-drift-kick, 1 force pass per step
+    Yoshida4,         // 4th order triple jump (Forest-Ruth), 3 force passes per step
+    Yoshida6,         // 6th order, Yoshida's solution A, 7 force passes per step
+    WisdomHolman,     // Kepler drift about the dominant body plus kicks (wisdom_holman.hpp)
+    BlockTimestep,    // KDK leapfrog with per-body power-of-two steps (see below)
+    Hermite,          // 4th-order Hermite predictor-corrector on block steps (hermite.hpp)
+    Ias15,            // 15th-order Gauss-Radau with adaptive steps (ias15.hpp)
+    Rkf78,            // Runge-Kutta-Fehlberg 7(8) with PI step control (rkf78.hpp)
+    Hierarchical,     // Kepler drifts on a Jacobi tree of nested pairs (hierarchical.hpp)
+    Parareal          // parallel-in-time coarse/fine iteration over slices of dt (parareal.hpp)
+};
+
+// Hierarchical block timesteps: each body steps with dt / 2^level, where
+// dt is the solver step. The level comes from the acceleration/jerk
+// criterion step = eta |a| / |da/dt|. The jerk is taken from the change in
+// acceleration over the body's last step (analytic on the first step).
+// A body may move to a finer level at any of its step boundaries. It may
+// move one level coarser only where the coarser grid lines up. Every
+// substep drifts all bodies and evaluates forces only on the active ones.
+struct BlockTimestepParams {
+    int maxLevel = 8;      // finest step is dt / 2^maxLevel (at most 30)
+    double eta = 0.02;
+};
+
+// Work done by the last Solver::update with block timesteps.
+struct BlockTimestepStats {
+    size_t substeps = 0;
+    size_t activeTargets = 0;   // force evaluations summed over substeps
+};
+
+// Bodies grouped by block-timestep level. A solver step of dt is
+// 2^maxLevel ticks and level l steps every 2^(maxLevel - l) ticks. `order`
+// lists the bodies finest level first, so the bodies whose steps end at a
+// tick are always a prefix of it.
+struct BlockSchedule {
+    int maxLevel = 0;
+    std::vector<uint8_t> level;
+    std::vector<uint32_t> order;
+    std::vector<size_t> count;   // bodies per level
+
+    // Counting sort of `level` into `order` and `count`.
+    void sort();
+
+    uint64_t ticks() const { return uint64_t(1) << maxLevel; }
+    uint64_t stepTicks(int l) const { return uint64_t(1) << (maxLevel - l); }
+    int finest() const;
+
+    // Number of bodies whose step ends at `tick` (0 < tick <= ticks()).
+    size_t dueAt(uint64_t tick) const;
+
+    // Finest level whose step dt / 2^level does not exceed `step`.
+    int levelFor(double step, double dt) const;
+
+    // Level after a step of a body at `current` ending at `tick`: finer
+    // whenever asked, coarser by one level and only onto a grid line.
+    int next(int current, double step, double dt, uint64_t tick) const;
+};
+
+// Substep weights w_k of a composition: one step of size dt runs a KDK
+// leapfrog of size w_k dt for each k. Adjacent half kicks are merged, and
+// the accelerations left by the last substep seed the next step, so a
+// step costs `stages` force passes.
+struct Composition {
+    const double* weights;
+    size_t stages;
+};
+
+namespace integrators {
+
+// Velocity Verlet, leapfrog and the Yoshida compositions: the schemes
+// composition() describes. It maps every other scheme to one leapfrog
+// stage, so callers that only run compositions clamp to this family.
+bool isComposition(Integrator integrator);
+Composition composition(Integrator integrator);
+int order(Integrator integrator);
+const char* name(Integrator integrator);
+
+}
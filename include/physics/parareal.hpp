@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "body_storage.hpp"
+#include "force_kernels.hpp"
+#include "integrator.hpp"
+#include "thread_pool.hpp"
+
+struct PararealParams {
+    size_t slices = 0;                         // time slices per step (0 = one per pool thread)
+    Integrator fine = Integrator::Yoshida4;    // leapfrog-family scheme run on each slice (others: Leapfrog)
+    int fineSteps = 64;                        // fine steps per slice
+    int coarseSteps = 1;                       // coarse Verlet steps per slice
+    double tolerance = 1e-12;                  // largest relative slice correction that counts as converged
+    int maxIterations = 0;                     // 0 = slices (where Parareal equals the fine solution)
+};
+
+// Iterations of the last Solver::update with Parareal.
+struct PararealStats {
+    int iterations = 0;
+    double correction = 0.0;   // largest relative change in the last iteration
+    size_t fineSlices = 0;     // fine slice integrations, summed over iterations
+};
+
+// Parareal (Lions, Maday & Turinici 2001): parallel in time instead of
+// across bodies, for systems too small to split. A step of dt is cut into
+// K slices with start states U_k. A coarse propagator G (velocity Verlet
+// with a few large steps) runs sequentially; the fine propagator F runs
+// every slice at once on the pool. Each iteration then corrects
+//
+//   U_{k+1} <- G(U_k new) + F(U_k old) - G(U_k old)
+//
+// until no slice start moves by more than the tolerance (relative to the
+// largest position and speed). After iteration j the first j slices match
+// the serial fine solution exactly, so at most K iterations are needed;
+// the speedup is about K / iterations.
+//
+// Forces always come from the direct sum, whatever the solver backend.
+class Parareal {
+public:
+    void step(BodyStorage& bodies, double dt, double G, const PararealParams& params,
+              ForceKernel kernel, ThreadPool& pool);
+
+    const PararealStats& stats() const { return m_stats; }
+
+private:
+    // One slice's propagation scratch.
+    struct Work {
+        AlignedVector<double> x, y, z, vx, vy, vz, ax, ay, az;
+    };
+
+    void resize(size_t n, size_t slices);
+    void force(Work& w) const;
+    // Runs `steps` composition steps of h from state `in` (x, y, z, vx,
+    // vy, vz columns of n) into `out`.
+    void propagate(Work& w, const double* in, double* out, double h, int steps,
+                   const Composition& scheme) const;
+
+    size_t m_n = 0;
+    double m_G = 0.0;
+    ForceKernel m_kernel = ForceKernel::Auto;
+    const double* m_mass = nullptr;
+    std::vector<std::vector<double>> m_u;    // slice start states, K + 1
+    std::vector<std::vector<double>> m_f;    // fine result of each slice
+    std::vector<std::vector<double>> m_g;    // coarse result of each slice
+    std::vector<double> m_coarse;            // coarse result of the current sweep
+    std::vector<Work> m_work;                // one per slice, plus one for the coarse sweep
+    PararealStats m_stats;
+};
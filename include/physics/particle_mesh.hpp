@@ -0,0 +1,64 @@
+#pragma once
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include "fft.hpp"
+#include "force_kernels.hpp"
+#include "thread_pool.hpp"
+
+enum class MassAssignment {
+    Cic,   // cloud-in-cell: 2 cells per axis, linear weights
+    Tsc    // triangular-shaped cloud: 3 cells per axis, quadratic weights
+};
+
+struct ParticleMeshParams {
+    size_t grid = 64;                              // cells per side, rounded up to a power of two
+    MassAssignment assignment = MassAssignment::Cic;
+    double splitRadius = 0.0;                      // r_s in cells; > 0 keeps only the long-range part
+};
+
+// Particle-mesh gravity: mass is deposited on a cubic mesh that spans the
+// bodies' bounding box, the potential comes from an FFT convolution with
+// the free-space Green's function -G/r on a mesh padded to twice the size
+// (so the periodic images of the FFT never see each other), and mesh
+// accelerations from a 4-point finite difference are interpolated back
+// with the same assignment scheme.
+//
+// Cost is O(N + M^3 log M) for an M^3 mesh; forces are smoothed on the
+// scale of one cell, so this suits collisionless runs rather than close
+// encounters. With a split radius the kernel becomes -G erf(r / 2r_s) / r,
+// the long-range half of a P3M force split.
+class ParticleMesh {
+public:
+    void evaluate(const SourceSet& bodies, const AccelSet& out, double G,
+                  const ParticleMeshParams& params, ThreadPool& pool);
+
+    size_t gridSize() const { return m_grid; }
+    double spacing() const { return m_h; }
+
+private:
+    // Plans the transforms and the Green's function for an M^3 mesh.
+    void prepare(const ParticleMeshParams& params, ThreadPool& pool);
+    void deposit(const SourceSet& bodies, ThreadPool& pool);
+    void convolve(double G, ThreadPool& pool);
+    void differentiate(ThreadPool& pool);
+    void interpolate(const SourceSet& bodies, const AccelSet& out, ThreadPool& pool) const;
+
+    // Runs `inverse ? inverse : forward` over every line of the padded
+    // mesh along `axis` whose other two indices are below the given bounds.
+    void transformLines(int axis, size_t boundA, size_t boundB, bool inverse, ThreadPool& pool);
+
+    MassAssignment m_assignment = MassAssignment::Cic;
+    size_t m_grid = 0;        // M
+    size_t m_padded = 0;      // 2M
+    double m_split = 0.0;
+    Fft m_fft;
+    double m_origin[3] = {0.0, 0.0, 0.0};
+    double m_h = 1.0;
+
+    std::vector<double> m_greenHat;                       // transform of -1/r for unit spacing, padded^3
+    std::vector<std::complex<double>> m_work;             // padded^3
+    std::vector<std::vector<double>> m_density;           // per-worker M^3 deposit grids
+    std::vector<std::vector<std::complex<double>>> m_lines;
+    std::vector<double> m_fx, m_fy, m_fz;                 // mesh accelerations, M^3
+};
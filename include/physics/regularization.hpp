@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "body_storage.hpp"
+
+struct RegularizationParams {
+    double radius = 0.0;          // pair separation that opens a subsystem (0 = off)
+    size_t maxMembers = 6;        // subsystems never grow past this many bodies
+    int chainStepsPerOrbit = 32;  // chain substeps per orbit of its tightest link
+};
+
+// Subsystems of the last Solver::update.
+struct RegularizationStats {
+    size_t pairs = 0;             // two-body subsystems (KS)
+    size_t chains = 0;            // larger subsystems (AR-chain)
+    size_t members = 0;
+    size_t chainSubsteps = 0;     // composed chain steps, including the ones spent landing on h
+};
+
+// Close-encounter regularization for the kick-drift-kick integrators.
+//
+// At the start of each step, pairs closer than `radius` that are bound or
+// still approaching are linked into subsystems (closest links first, up to
+// maxMembers bodies each). For that step the subsystems' internal forces
+// are taken out of the kicks, and the drift moves each subsystem's centre
+// of mass linearly and its internal motion by a regularized propagator:
+//
+//   2 bodies:  Kustaanheimo-Stiefel. In u space with dt = r ds the
+//              relative orbit is a harmonic oscillator, solved in closed
+//              form; only t(s) = h needs a Newton solve. Exact and
+//              regular through r -> 0.
+//   3+ bodies: algorithmic chain regularization (Mikkola & Tanikawa
+//              logH leapfrog) on chain vectors between nearest neighbours,
+//              composed to 6th order with the Yoshida weights. The step
+//              ds is tuned so the chain lands exactly on h.
+//
+// The outside bodies still act on members through the kicks, so this is
+// the same splitting the solver uses for everything else; only the
+// internal 1/r^2 no longer limits dt. The backend must resolve the pair
+// force exactly (true for Direct, Barnes-Hut, FMM and P3M near fields).
+class Regularization {
+public:
+    // Builds the subsystems for the next step; radius 0 clears them.
+    void select(const BodyStorage& bodies, double G, const RegularizationParams& params);
+    void clear();
+    bool active() const { return !m_systems.empty(); }
+
+    // Takes the internal forces back out of a kick of h from bodies.ax/ay/az.
+    void cancelInternal(BodyStorage& bodies, double h) const;
+    // Saves the member states; call before the solver's linear drift.
+    void gather(const BodyStorage& bodies);
+    // Moves the subsystems by h from the gathered states, overwriting the
+    // members' linear drift.
+    void drift(BodyStorage& bodies, double h);
+
+    const RegularizationStats& stats() const { return m_stats; }
+
+private:
+    struct Subsystem {
+        size_t first;   // into m_members
+        size_t count;
+    };
+
+    // Body in its cell of the radius-wide grid.
+    struct CellEntry {
+        int64_t cx, cy, cz;
+        uint32_t i;
+    };
+    // Close pair that may join a subsystem.
+    struct Link {
+        double r;
+        uint32_t i, j;
+    };
+    // Working columns of chainDrift, 3 per body or link.
+    struct ChainScratch {
+        std::vector<uint8_t> used;
+        std::vector<size_t> order;         // members along the chain
+        std::vector<double> mass;          // in chain order
+        std::vector<double> x0, v0, x, w;  // chain vectors
+        std::vector<double> acc, vel;
+        std::vector<double> oldPos, oldVel, newPos, newVel;
+    };
+
+    void chainDrift(const Subsystem& system, double h);
+
+    double m_G = 0.0;
+    int m_stepsPerOrbit = 32;
+    std::vector<uint32_t> m_members;   // body indices, grouped by subsystem
+    std::vector<Subsystem> m_systems;
+    std::vector<double> m_pos, m_vel;  // gathered states, 3 per member
+    std::vector<double> m_mass;
+    RegularizationStats m_stats;
+
+    // Scratch kept between steps, so a run allocates only while it grows.
+    std::vector<CellEntry> m_cells;
+    std::vector<Link> m_links;
+    std::vector<uint32_t> m_parent, m_size;
+    std::vector<std::pair<uint32_t, uint32_t>> m_grouped;   // (root, body)
+    ChainScratch m_chain;
+};
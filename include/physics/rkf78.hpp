@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "body_storage.hpp"
+#include "thread_pool.hpp"
+
+struct RkfParams {
+    double tolerance = 1e-10;   // local error per step, relative to each body's scale
+    double initialStep = 0.0;   // 0 = estimate from |v| / |a|
+    double minStep = 0.0;
+    double maxStep = 0.0;       // 0 = unlimited
+};
+
+// Work done by the last Solver::update with RKF 7(8).
+struct RkfStats {
+    size_t steps = 0;
+    size_t rejected = 0;
+    size_t forceEvaluations = 0;
+    double stepSize = 0.0;      // internal step the next update starts with
+};
+
+// Runge-Kutta-Fehlberg 7(8): 13 stages. The 8th-order solution is
+// propagated and the difference from the embedded 7th-order one is the
+// error estimate. The integrator is not symplectic, but it sets its own
+// step: a PI controller (Gustafsson) aims the estimate at the tolerance,
+// so steps grow in quiet phases and shrink through close approaches.
+//
+// The error of body i is |dr| / (tol (|r| + h|v|)) and
+// |dv| / (tol (|v| + h|a|)); the worst body controls the step.
+// forces() must fill bodies.ax/ay/az for the positions in bodies.x/y/z.
+// The stage combinations run on the pool. advance() covers exactly
+// `interval`, clipping its last internal step.
+class RungeKuttaFehlberg {
+public:
+    template <typename Forces>
+    void advance(BodyStorage& bodies, double interval, const RkfParams& params,
+                 ThreadPool& pool, Forces&& forces) {
+        m_stats = RkfStats{};
+        if (bodies.size() != m_n) reset(bodies.size());
+        if (m_n == 0 || interval <= 0.0) return;
+        if (m_dt <= 0.0) {
+            forces();
+            ++m_stats.forceEvaluations;
+            m_dt = params.initialStep > 0.0 ? params.initialStep : estimateStep(bodies, interval);
+        }
+
+        double done = 0.0;
+        while (done < interval) {
+            const double remaining = interval - done;
+            const bool clipped = m_dt >= remaining;
+            const double h = clipped ? remaining : m_dt;
+
+            save(bodies);
+            for (int s = 0; s < kStages; ++s) {
+                stage(bodies, s, h, pool);
+                forces();
+                ++m_stats.forceEvaluations;
+                store(bodies, s);
+            }
+            const double error = finish(bodies, h, pool);
+            if (!control(error, h, clipped, params)) {
+                restore(bodies);
+                ++m_stats.rejected;
+                continue;
+            }
+            ++m_stats.steps;
+            done = clipped ? interval : done + h;
+        }
+        m_stats.stepSize = m_dt;
+    }
+
+    // Forgets the step size and controller history.
+    void reset() { m_n = size_t(-1); }
+
+    const RkfStats& stats() const { return m_stats; }
+
+private:
+    static constexpr int kStages = 13;
+
+    void reset(size_t n);
+    double estimateStep(const BodyStorage& bodies, double interval) const;
+    void save(const BodyStorage& bodies);
+    void restore(BodyStorage& bodies) const;
+    // Stage positions and velocities y0 + h sum_j a_sj k_j into the bodies.
+    void stage(BodyStorage& bodies, int s, double h, ThreadPool& pool);
+    // Keeps the stage derivative (velocity and fresh acceleration).
+    void store(const BodyStorage& bodies, int s);
+    // Writes the 8th-order solution and returns the scaled error estimate.
+    double finish(BodyStorage& bodies, double h, ThreadPool& pool);
+    // Accepts or rejects the step and sets the next one.
+    bool control(double error, double h, bool clipped, const RkfParams& params);
+
+    size_t m_n = size_t(-1);
+    double m_dt = 0.0;
+    double m_prevError = 1.0;   // accepted error of the previous step, for the PI term
+    RkfStats m_stats;
+
+    // SoA columns of 3N: x, y, z blocks of N each.
+    std::vector<double> m_x0, m_v0;
+    std::vector<double> m_kx[kStages], m_kv[kStages];
+    std::vector<double> m_blockError;
+};
@@ -0,0 +1,328 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "body.hpp"
+#include "body_storage.hpp"
+#include "integrator.hpp"
+#include "utils/math.hpp"
+#include "utils/quire.hpp"
+
+namespace kernels {
+
+// Running sums per component in accumulateGeneric. A strict IEEE build
+// may not reorder one running sum, so float and double keep a block of
+// independent partial sums that the compiler maps onto SIMD lanes (this
+// needs -fno-math-errno for the sqrt, see CMakeLists.txt). Other formats
+// keep a single sum, i.e. the plain sequential order.
+template <typename Scalar>
+constexpr size_t kGenericLanes = std::is_same_v<Scalar, float> || std::is_same_v<Scalar, double> ? 16 : 1;
+
+// Direct sum in an arbitrary number format: adds G * sum_j m_j d / |d|^3
+// to targets [begin, end) of the set. Sources are the set itself; the self
+// term is skipped by splitting the j loop, so both halves stay branch-free.
+// Source j goes into partial sum j mod kGenericLanes (relative to the
+// start of its half), and the partial sums are added in lane order.
+template <typename Scalar>
+void accumulateGeneric(const Scalar* x, const Scalar* y, const Scalar* z, const Scalar* m, size_t n,
+                       Scalar* ax, Scalar* ay, Scalar* az, size_t begin, size_t end, const Scalar& G) {
+    using std::sqrt;
+    constexpr size_t W = kGenericLanes<Scalar>;
+    for (size_t i = begin; i < end; ++i) {
+        const Scalar xi = x[i], yi = y[i], zi = z[i];
+        Scalar px[W] = {}, py[W] = {}, pz[W] = {};
+        auto pairs = [&](size_t j0, size_t j1) {
+            size_t j = j0;
+            for (; j + W <= j1; j += W) {
+                for (size_t l = 0; l < W; ++l) {
+                    const Scalar dx = x[j + l] - xi;
+                    const Scalar dy = y[j + l] - yi;
+                    const Scalar dz = z[j + l] - zi;
+                    const Scalar distSqr = dx * dx + dy * dy + dz * dz;
+                    const Scalar f = m[j + l] / (distSqr * sqrt(distSqr));
+                    px[l] = px[l] + f * dx;
+                    py[l] = py[l] + f * dy;
+                    pz[l] = pz[l] + f * dz;
+                }
+            }
+            for (size_t l = 0; j < j1; ++j, ++l) {
+                const Scalar dx = x[j] - xi;
+                const Scalar dy = y[j] - yi;
+                const Scalar dz = z[j] - zi;
+                const Scalar distSqr = dx * dx + dy * dy + dz * dz;
+                const Scalar f = m[j] / (distSqr * sqrt(distSqr));
+                px[l] = px[l] + f * dx;
+                py[l] = py[l] + f * dy;
+                pz[l] = pz[l] + f * dz;
+            }
+        };
+        pairs(0, i);
+        pairs(i + 1, n);
+        Scalar axi = px[0], ayi = py[0], azi = pz[0];
+        for (size_t l = 1; l < W; ++l) {
+            axi = axi + px[l];
+            ayi = ayi + py[l];
+            azi = azi + pz[l];
+        }
+        ax[i] = ax[i] + G * axi;
+        ay[i] = ay[i] + G * ayi;
+        az[i] = az[i] + G * azi;
+    }
+}
+
+// accumulateGeneric with each target's sums in the format's exact
+// accumulator: the products f * d go in unrounded and each component is
+// rounded once per body, so the sum no longer depends on the source order.
+template <typename Scalar>
+void accumulateGenericExact(const Scalar* x, const Scalar* y, const Scalar* z, const Scalar* m, size_t n,
+                            Scalar* ax, Scalar* ay, Scalar* az, size_t begin, size_t end, const Scalar& G) {
+    using std::sqrt;
+    typename ExactAccumulator<Scalar>::type qx, qy, qz;
+    for (size_t i = begin; i < end; ++i) {
+        const Scalar xi = x[i], yi = y[i], zi = z[i];
+        qx.clear(); qy.clear(); qz.clear();
+        auto pairs = [&](size_t j0, size_t j1) {
+            for (size_t j = j0; j < j1; ++j) {
+                const Scalar dx = x[j] - xi;
+                const Scalar dy = y[j] - yi;
+                const Scalar dz = z[j] - zi;
+                const Scalar distSqr = dx * dx + dy * dy + dz * dz;
+                const Scalar f = m[j] / (distSqr * sqrt(distSqr));
+                qx.addProduct(f, dx);
+                qy.addProduct(f, dy);
+                qz.addProduct(f, dz);
+            }
+        };
+        pairs(0, i);
+        pairs(i + 1, n);
+        ax[i] = ax[i] + G * qx.value();
+        ay[i] = ay[i] + G * qy.value();
+        az[i] = az[i] + G * qz.value();
+    }
+}
+
+}
+
+// Direct-sum solver templated on the arithmetic, for rerunning the same
+// simulation in another number format. Positions, velocities, G, dt, the
+// force sum and the integrator all run in Scalar; only the diagnostics
+// convert to double. Scalar needs + - * /, construction from double,
+// explicit conversion to double, a value-initialized zero and a sqrt found
+// by argument-dependent lookup (std::sqrt for the built-in types).
+//
+// Integrates with the leapfrog family (velocity Verlet, leapfrog, Yoshida
+// 4/6); setIntegrator stores any other scheme as Leapfrog, so
+// getIntegrator reports what runs. Solver stays the double
+// production path with the tree and mesh backends and the SIMD kernels.
+// float, double and long double are instantiated once in scalar_solver.cpp;
+// other types instantiate from this header.
+template <typename Scalar>
+class BasicSolver {
+public:
+    explicit BasicSolver(double timestep, double gravity = 6.67430e-11)
+        : G(gravity), dt(timestep) {}
+
+    void setIntegrator(Integrator scheme) {
+        integrator = integrators::isComposition(scheme) ? scheme : Integrator::Leapfrog;
+    }
+    Integrator getIntegrator() const { return integrator; }
+
+    // Sums each body's forces in the format's exact accumulator (the quire
+    // for posits, KulischAccumulator for double) and rounds once per body.
+    // Formats without one keep the plain sum.
+    void setExactSums(bool exact) { exactSums = exact; }
+    bool getExactSums() const { return exactSums; }
+
+    // Rounds the double state into Scalar.
+    void addBody(const Body& body);
+    void addBody(const BasicBody<Scalar>& body);
+
+    void computeAccelerations();
+    void update();
+    void advance(size_t steps);
+
+    size_t size() const { return mass.size(); }
+    BasicBody<Scalar> getBody(size_t i) const;
+    // The state widened back to double, e.g. for the renderer or to
+    // compare against Solver.
+    Body toBody(size_t i) const;
+
+    double totalEnergy() const;
+    glm::dvec3 totalMomentum() const;
+
+private:
+    Scalar G;
+    Scalar dt;
+    Integrator integrator = Integrator::VelocityVerlet;
+    bool exactSums = false;
+    AlignedVector<Scalar> x, y, z, mass;
+    AlignedVector<Scalar> vx, vy, vz;
+    AlignedVector<Scalar> ax, ay, az;
+    AlignedVector<Scalar> prevAx, prevAy, prevAz;
+    std::vector<glm::vec3> color;
+
+    void stepVerlet();
+    void stepComposition(const Composition& scheme);
+    void drift(const Scalar& h);
+    void kick(const Scalar& h);
+};
+
+template <typename Scalar>
+void BasicSolver<Scalar>::addBody(const Body& body) {
+    BasicBody<Scalar> b;
+    b.mass = Scalar(body.mass);
+    b.position = {Scalar(body.position.x), Scalar(body.position.y), Scalar(body.position.z)};
+    b.velocity = {Scalar(body.velocity.x), Scalar(body.velocity.y), Scalar(body.velocity.z)};
+    b.acceleration = {Scalar(body.acceleration.x), Scalar(body.acceleration.y), Scalar(body.acceleration.z)};
+    addBody(b);
+    color.back() = body.color;
+}
+
+template <typename Scalar>
+void BasicSolver<Scalar>::addBody(const BasicBody<Scalar>& body) {
+    x.push_back(body.position.x);  y.push_back(body.position.y);  z.push_back(body.position.z);
+    mass.push_back(body.mass);
+    vx.push_back(body.velocity.x); vy.push_back(body.velocity.y); vz.push_back(body.velocity.z);
+    ax.push_back(body.acceleration.x); ay.push_back(body.acceleration.y); az.push_back(body.acceleration.z);
+    color.push_back(glm::vec3(1.0f));
+}
+
+template <typename Scalar>
+void BasicSolver<Scalar>::computeAccelerations() {
+    const size_t n = size();
+    std::fill(ax.begin(), ax.end(), Scalar{});
+    std::fill(ay.begin(), ay.end(), Scalar{});
+    std::fill(az.begin(), az.end(), Scalar{});
+    if constexpr (ExactAccumulator<Scalar>::available) {
+        if (exactSums) {
+            kernels::accumulateGenericExact(x.data(), y.data(), z.data(), mass.data(), n,
+                                            ax.data(), ay.data(), az.data(), 0, n, G);
+            return;
+        }
+    }
+    kernels::accumulateGeneric(x.data(), y.data(), z.data(), mass.data(), n,
+                               ax.data(), ay.data(), az.data(), 0, n, G);
+}
+
+template <typename Scalar>
+void BasicSolver<Scalar>::update() {
+    if (integrator == Integrator::VelocityVerlet)
+        stepVerlet();
+    else
+        stepComposition(integrators::composition(integrator));
+}
+
+template <typename Scalar>
+void BasicSolver<Scalar>::advance(size_t steps) {
+    for (size_t s = 0; s < steps; ++s) update();
+}
+
+template <typename Scalar>
+void BasicSolver<Scalar>::stepVerlet() {
+    const size_t n = size();
+    prevAx.assign(ax.begin(), ax.end());
+    prevAy.assign(ay.begin(), ay.end());
+    prevAz.assign(az.begin(), az.end());
+
+    const Scalar half(0.5);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = x[i] + vx[i] * dt + half * ax[i] * dt * dt;
+        y[i] = y[i] + vy[i] * dt + half * ay[i] * dt * dt;
+        z[i] = z[i] + vz[i] * dt + half * az[i] * dt * dt;
+    }
+
+    computeAccelerations();
+
+    for (size_t i = 0; i < n; ++i) {
+        vx[i] = vx[i] + half * (prevAx[i] + ax[i]) * dt;
+        vy[i] = vy[i] + half * (prevAy[i] + ay[i]) * dt;
+        vz[i] = vz[i] + half * (prevAz[i] + az[i]) * dt;
+    }
+}
+
+// Same merged-kick KDK loop as Solver::stepComposition, with the weights
+// rounded to Scalar.
+template <typename Scalar>
+void BasicSolver<Scalar>::stepComposition(const Composition& scheme) {
+    const double* w = scheme.weights;
+    const Scalar h = dt;
+    kick(Scalar(0.5 * w[0]) * h);
+    for (size_t k = 0; k < scheme.stages; ++k) {
+        drift(Scalar(w[k]) * h);
+        computeAccelerations();
+        const double next = k + 1 < scheme.stages ? w[k + 1] : 0.0;
+        kick(Scalar(0.5 * (w[k] + next)) * h);
+    }
+}
+
+template <typename Scalar>
+void BasicSolver<Scalar>::drift(const Scalar& h) {
+    for (size_t i = 0; i < size(); ++i) {
+        x[i] = x[i] + vx[i] * h;
+        y[i] = y[i] + vy[i] * h;
+        z[i] = z[i] + vz[i] * h;
+    }
+}
+
+template <typename Scalar>
+void BasicSolver<Scalar>::kick(const Scalar& h) {
+    for (size_t i = 0; i < size(); ++i) {
+        vx[i] = vx[i] + ax[i] * h;
+        vy[i] = vy[i] + ay[i] * h;
+        vz[i] = vz[i] + az[i] * h;
+    }
+}
+
+template <typename Scalar>
+BasicBody<Scalar> BasicSolver<Scalar>::getBody(size_t i) const {
+    BasicBody<Scalar> b;
+    b.mass = mass[i];
+    b.position = {x[i], y[i], z[i]};
+    b.velocity = {vx[i], vy[i], vz[i]};
+    b.acceleration = {ax[i], ay[i], az[i]};
+    return b;
+}
+
+template <typename Scalar>
+Body BasicSolver<Scalar>::toBody(size_t i) const {
+    Body b;
+    b.mass = static_cast<double>(mass[i]);
+    b.position = {static_cast<double>(x[i]), static_cast<double>(y[i]), static_cast<double>(z[i])};
+    b.velocity = {static_cast<double>(vx[i]), static_cast<double>(vy[i]), static_cast<double>(vz[i])};
+    b.acceleration = {static_cast<double>(ax[i]), static_cast<double>(ay[i]), static_cast<double>(az[i])};
+    b.color = color[i];
+    return b;
+}
+
+// Measured in double from the widened state, so formats compare on the
+// same yardstick.
+template <typename Scalar>
+double BasicSolver<Scalar>::totalEnergy() const {
+    const double g = static_cast<double>(G);
+    double KE = 0.0;
+    double PE = 0.0;
+    for (size_t i = 0; i < size(); ++i) {
+        const Body a = toBody(i);
+        KE += 0.5 * a.mass * glm::dot(a.velocity, a.velocity);
+        for (size_t j = i + 1; j < size(); ++j) {
+            const Body b = toBody(j);
+            PE -= g * a.mass * b.mass / glm::length(a.position - b.position);
+        }
+    }
+    return KE + PE;
+}
+
+template <typename Scalar>
+glm::dvec3 BasicSolver<Scalar>::totalMomentum() const {
+    glm::dvec3 P(0.0);
+    for (size_t i = 0; i < size(); ++i) {
+        const Body b = toBody(i);
+        P += b.mass * b.velocity;
+    }
+    return P;
+}
+
+extern template class BasicSolver<float>;
+extern template class BasicSolver<double>;
+extern template class BasicSolver<long double>;
@@ -1,19 +1,140 @@
 #pragma once
+#include <memory>
 #include <vector>
 #include "body.hpp"
+#include "barnes_hut.hpp"
+#include "body_storage.hpp"
+#include "fmm.hpp"
+#include "force_kernels.hpp"
+#include "hermite.hpp"
+#include "hierarchical.hpp"
+#include "ias15.hpp"
+#include "integrator.hpp"
+#include "p3m.hpp"
+#include "parareal.hpp"
+#include "particle_mesh.hpp"
+#include "regularization.hpp"
+#include "rkf78.hpp"
+#include "thread_pool.hpp"
+#include "wisdom_holman.hpp"
 #include <glm/glm.hpp>
 
+enum class GravityBackend {
+    Direct,        // O(N^2) pair summation through the selected ForceKernel
+    BarnesHut,     // octree with monopole + quadrupole cells, O(N log N)
+    FastMultipole, // octree with Cartesian multipole/local expansions, O(N)
+    ParticleMesh,  // FFT Poisson solve on a mesh, O(N + M^3 log M), smoothed on the cell scale
+    P3M            // mesh long range + cell-list direct short range (Gaussian split)
+};
+
+// Relative acceleration error of the active backend against the direct
+// sum, measured on a random sample of bodies.
+struct ForceErrorStats {
+    size_t samples = 0;
+    double maxRelError = 0.0;
+    double rmsRelError = 0.0;
+    double medianRelError = 0.0;
+};
+
 class Solver {
 public:
-    Solver(double timestep);
+    Solver(double timestep, GravityBackend backend = GravityBackend::Direct);
 
     void computeAccelerations();
 
+    // Selects the direct-summation kernel; Scalar stays available as the
+    // reference to check the SIMD paths against.
+    void setForceKernel(ForceKernel kernel);
+    ForceKernel getForceKernel() const;
+
+    // Mixed runs the direct sum's pair terms in float32 (double accumulation),
+    // Bposit32 runs the whole sum on the bposit32 grid. Every force pass in
+    // either mode then re-evaluates a few rotating sample bodies in double
+    // and records the relative error, so drift in accuracy shows up step by
+    // step. Exact keeps double pair terms but sums them without rounding,
+    // so the forces are bitwise reproducible across kernels and threads.
+    void setForcePrecision(ForcePrecision precision);
+    ForcePrecision getForcePrecision() const;
+    void setPrecisionSamples(size_t samples);
+    const ForceErrorStats& getPrecisionErrorEstimate() const;
+
+    // Tile sizes of the blocked direct sum (build defaults NBODY_TILE_I/J).
+    void setTileConfig(const TileConfig& tiles);
+    const TileConfig& getTileConfig() const;
+
+    // Evaluates each unordered pair once and applies equal and opposite
+    // contributions. With more than one thread, every worker accumulates
+    // into its own buffer and the buffers are reduced afterwards. Only
+    // applies to ForcePrecision::Double; the other precisions keep their
+    // per-target kernels (and Exact its reproducibility).
+    void setSymmetricForces(bool enabled);
+
+    // Size of the persistent worker pool used by the force pass and the
+    // drift/kick loops (0 = one per hardware thread, the default).
+    void setThreadCount(unsigned threads);
+    unsigned getThreadCount() const;
+
+    GravityBackend getBackend() const;
+    void setBarnesHutParams(const BarnesHutParams& params);
+    const BarnesHutParams& getBarnesHutParams() const;
+    void setFmmParams(const FmmParams& params);
+    const FmmParams& getFmmParams() const;
+    void setParticleMeshParams(const ParticleMeshParams& params);
+    const ParticleMeshParams& getParticleMeshParams() const;
+    void setP3mParams(const P3mParams& params);
+    const P3mParams& getP3mParams() const;
+
+    // Recomputes accelerations with the active backend and compares up to
+    // `samples` randomly chosen bodies with the direct-sum reference. Use it
+    // to pick theta (or other accuracy knobs) per scenario.
+    ForceErrorStats checkForceAccuracy(size_t samples, unsigned seed = 1);
+
+    // Scheme used by update(); the Yoshida compositions trade more force
+    // passes per step for a much larger usable dt.
+    void setIntegrator(Integrator integrator);
+    Integrator getIntegrator() const;
+    void setWisdomHolmanParams(const WisdomHolmanParams& params);
+    const WisdomHolmanParams& getWisdomHolmanParams() const;
+    void setBlockTimestepParams(const BlockTimestepParams& params);
+    const BlockTimestepParams& getBlockTimestepParams() const;
+    const BlockTimestepStats& getBlockTimestepStats() const;
+    void setHermiteParams(const HermiteParams& params);
+    const HermiteParams& getHermiteParams() const;
+    void setIas15Params(const Ias15Params& params);
+    const Ias15Params& getIas15Params() const;
+    const Ias15Stats& getIas15Stats() const;
+    void setRkfParams(const RkfParams& params);
+    const RkfParams& getRkfParams() const;
+    const RkfStats& getRkfStats() const;
+    // Each update() covers dt in Parareal slices, one per pool thread by
+    // default, so a long few-body run can use every core.
+    void setPararealParams(const PararealParams& params);
+    const PararealParams& getPararealParams() const;
+    const PararealStats& getPararealStats() const;
+
+    // Close encounters in the leapfrog family (velocity Verlet, leapfrog,
+    // Yoshida): subsystems within the radius move in KS or chain-regularized
+    // coordinates for each step. Velocity Verlet then runs as KDK leapfrog.
+    void setRegularizationParams(const RegularizationParams& params);
+    const RegularizationParams& getRegularizationParams() const;
+    const RegularizationStats& getRegularizationStats() const;
+
     void addBody(const Body& body);
     void update();
 
-    std::vector<Body>& getBodies();            
-    const std::vector<Body>& getBodies() const;  
+    // Same as `steps` calls to update(). Velocity Verlet and the
+    // unregularized compositions run fused: the kick closing one step and
+    // the drift opening the next share a pass, and the step keeps its
+    // scratch between calls, so after the first step nothing is allocated.
+    void advance(size_t steps);
+    // Heap allocations seen after the first step of the last advance()
+    // (only counted in NBODY_COUNT_ALLOCATIONS builds; 0 otherwise). The
+    // counter is process-wide, so other threads' allocations land here too;
+    // tools/alloc_check.cpp runs advance() alone and checks for 0.
+    size_t getSteadyStateAllocations() const;
+
+    BodyView getBodies();
+    ConstBodyView getBodies() const;
 
     glm::dvec3 getBarycenter() const;
     double totalEnergy() const;
@@ -22,7 +143,79 @@ public:
 private:
     double G = 6.67430e-11;
     double dt;
-    std::vector<Body> bodies;
+    Integrator integrator = Integrator::VelocityVerlet;
+    WisdomHolmanParams whParams;
+    WisdomHolman wh;
+    BlockTimestepParams blockParams;
+    BlockTimestepStats blockStats;
+    HermiteParams hermiteParams;
+    HermiteIntegrator hermite;
+    Ias15Params ias15Params;
+    Ias15 ias15;
+    RkfParams rkfParams;
+    RungeKuttaFehlberg rkf;
+    HierarchicalJacobi hierarchy;
+    PararealParams pararealParams;
+    Parareal parareal;
+    RegularizationParams regularizationParams;
+    Regularization regularization;
+    BodyStorage bodies;
+    ForceKernel forceKernel = ForceKernel::Auto;
+    TileConfig tiles;
+    ForcePrecision precision = ForcePrecision::Double;
+    size_t precisionSamples = 16;
+    size_t precisionOffset = 0;
+    ForceErrorStats precisionError;
+    GravityBackend backend;
+    BarnesHutParams bhParams;
+    BarnesHutTree bhTree;
+    std::vector<BarnesHutTree::Scratch> bhScratch;
+    FmmParams fmmParams;
+    FmmSolver fmm;
+    ParticleMeshParams pmParams;
+    ParticleMesh pm;
+    P3mParams p3mParams;
+    P3mSolver p3m;
+    bool symmetricForces = false;
+    std::unique_ptr<ThreadPool> pool;
+
+    struct AccelBuffer {
+        AlignedVector<double> ax, ay, az;
+    };
+    std::vector<AccelBuffer> threadAccels;
+
+    struct BlockState {
+        BlockSchedule schedule;
+        AlignedVector<double> prevAx, prevAy, prevAz; // acceleration at each body's last evaluation
+        AlignedVector<double> x, y, z, ax, ay, az;    // gathered active targets
+    };
+    BlockState block;
+
+    AlignedVector<double> prevAx, prevAy, prevAz; // accelerations before the Verlet force pass
+
+    struct SampleScratch {
+        std::vector<uint32_t> picks;            // bodies compared with the reference
+        AlignedVector<double> x, y, z, ax, ay, az;
+        std::vector<double> errors;
+    };
+    SampleScratch sample;
+    size_t steadyStateAllocations = 0;
+
+    void computeSymmetric();
+    void estimatePrecisionError();
+    ForceErrorStats compareWithReference(ForceKernel reference);
+    void computeBarnesHut();
+    void computeFmm();
+    void computeParticleMesh();
+    void computeP3m();
+    void stepVerlet(size_t steps);
+    void stepComposition(const Composition& scheme, size_t steps);
+    void drift(double h);
+    void kick(double h);
+    void kickDrift(double kickH, double driftH);
+    void stepBlock();
+    void initBlock();
+    void computeActive(size_t count);
+
 
-   
 };
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Persistent worker pool. Threads are started once and parked on a
+// condition variable between jobs. parallelFor hands out [begin, end) in
+// chunks of `grain` indices. The calling thread works as worker 0, and the
+// call returns once every chunk is done. The callable is passed by
+// reference and never copied or boxed, so dispatch does not allocate.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads taking part in a job, including the caller.
+    unsigned size() const { return unsigned(m_workers.size()) + 1; }
+
+    // body(size_t chunkBegin, size_t chunkEnd, unsigned worker). Nested
+    // calls from inside a job run inline on the calling worker.
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, size_t grain, F&& body) {
+        using Fn = std::remove_reference_t<F>;
+        dispatch(begin, end, grain,
+                 [](void* ctx, size_t b, size_t e, unsigned w) { (*static_cast<Fn*>(ctx))(b, e, w); },
+                 const_cast<void*>(static_cast<const void*>(&body)));
+    }
+
+private:
+    using Trampoline = void (*)(void*, size_t, size_t, unsigned);
+
+    void dispatch(size_t begin, size_t end, size_t grain, Trampoline fn, void* ctx);
+    void workerLoop(unsigned index);
+    void drain(unsigned worker);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    unsigned m_busy = 0;
+    bool m_stop = false;
+
+    Trampoline m_fn = nullptr;
+    void* m_ctx = nullptr;
+    size_t m_end = 0;
+    size_t m_grain = 1;
+    std::atomic<size_t> m_next{0};
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "body_storage.hpp"
+#include "thread_pool.hpp"
+
+enum class WhCoordinates {
+    Jacobi,                  // each body orbits the barycentre of the bodies before it
+    DemocraticHeliocentric   // heliocentric positions, barycentric velocities
+};
+
+struct WisdomHolmanParams {
+    WhCoordinates coordinates = WhCoordinates::Jacobi;
+    int correctorOrder = 0;    // symplectic corrector: 0 (off), 3 or 5; Jacobi only
+};
+
+// Advances the relative orbit (x, v) about mass parameter mu by h in
+// universal variables; any eccentricity, including unbound.
+void keplerDrift(double mu, double h, double& x, double& y, double& z,
+                 double& vx, double& vy, double& vz);
+
+// Wisdom-Holman mixed-variable symplectic map for one dominant mass plus
+// perturbers. The most massive body is the centre; every other body
+// follows an exact Kepler orbit about it (universal variables, Stumpff
+// functions) and the rest of the gravity is applied as kicks:
+//
+//   Jacobi:          kick(dt/2) kepler(dt) kick(dt/2)
+//   heliocentric:    kick(dt/2) jump(dt/2) kepler(dt) jump(dt/2) kick(dt/2)
+//
+// Kicks come from the full inertial accelerations of whatever backend the
+// caller uses, minus the Kepler part, so a step costs one force pass.
+//
+// The map keeps its own state between steps and only reloads it from the
+// bodies when they no longer match what the last step wrote (bodies were
+// added or edited, or dt, G or the parameters changed). With correctors
+// that state is in mapping variables; each step writes the corrected
+// coordinates to the bodies, which costs 4 (order 3) or 8 (order 5) extra
+// force passes.
+class WisdomHolman {
+public:
+    // forces() must fill bodies.ax/ay/az for the positions in bodies.x/y/z.
+    template <typename Forces>
+    void step(BodyStorage& bodies, double dt, double G, const WisdomHolmanParams& params,
+              ThreadPool& pool, Forces&& forces) {
+        if (!resume(bodies, dt, G, params)) {
+            load(bodies, dt, G, params);
+            writePositions(bodies);
+            forces();
+            interaction(bodies);
+            if (correcting()) {
+                correct(-1.0, bodies, pool, forces);
+                writePositions(bodies);
+                forces();
+                interaction(bodies);
+            }
+        }
+
+        kick(0.5 * dt);
+        if (m_params.coordinates == WhCoordinates::DemocraticHeliocentric) {
+            jump(0.5 * dt);
+            kepler(dt, pool);
+            jump(0.5 * dt);
+        } else {
+            kepler(dt, pool);
+        }
+        writePositions(bodies);
+        forces();
+        interaction(bodies);
+        kick(0.5 * dt);
+
+        if (correcting()) {
+            m_saved = m_state;
+            correct(1.0, bodies, pool, forces);
+            writeState(bodies);
+            m_state = m_saved;
+        } else {
+            writeState(bodies);
+        }
+        record(bodies);
+    }
+
+private:
+    struct State {
+        std::vector<double> qx, qy, qz;   // mapping positions (slot 0: barycentre)
+        std::vector<double> vx, vy, vz;   // mapping velocities
+        std::vector<double> kx, ky, kz;   // interaction accelerations
+    };
+
+    bool correcting() const {
+        return m_params.correctorOrder > 0 && m_params.coordinates == WhCoordinates::Jacobi;
+    }
+
+    bool resume(const BodyStorage& bodies, double dt, double G, const WisdomHolmanParams& params) const;
+    void load(const BodyStorage& bodies, double dt, double G, const WisdomHolmanParams& params);
+    void record(const BodyStorage& bodies);
+    void writePositions(BodyStorage& bodies) const;
+    void writeState(BodyStorage& bodies) const;
+
+    void kepler(double h, ThreadPool& pool);
+    void jump(double h);
+    void kick(double h);
+    // Interaction accelerations from the inertial ones in bodies.ax/ay/az.
+    void interaction(const BodyStorage& bodies);
+
+    // Wisdom, Holman & Touma (1996) correctors built from kernels
+    // Z(a, b) = K(a) I(-b) K(-2a) I(b) K(a); inv = -1 applies the inverse.
+    template <typename Forces>
+    void correct(double inv, BodyStorage& bodies, ThreadPool& pool, Forces& forces) {
+        const double a1 = kCorrectorA1 * m_dt, a2 = 2.0 * a1;
+        if (m_params.correctorOrder == 3) {
+            corrector(a1, -inv * kCorrectorB31 * m_dt, bodies, pool, forces);
+            corrector(-a1, inv * kCorrectorB31 * m_dt, bodies, pool, forces);
+        } else {
+            corrector(-a2, -inv * kCorrectorB51 * m_dt, bodies, pool, forces);
+            corrector(-a1, -inv * kCorrectorB52 * m_dt, bodies, pool, forces);
+            corrector(a1, inv * kCorrectorB52 * m_dt, bodies, pool, forces);
+            corrector(a2, inv * kCorrectorB51 * m_dt, bodies, pool, forces);
+        }
+    }
+
+    template <typename Forces>
+    void corrector(double a, double b, BodyStorage& bodies, ThreadPool& pool, Forces& forces) {
+        kepler(a, pool);
+        writePositions(bodies);
+        forces();
+        interaction(bodies);
+        kick(-b);
+        kepler(-2.0 * a, pool);
+        writePositions(bodies);
+        forces();
+        interaction(bodies);
+        kick(b);
+        kepler(a, pool);
+    }
+
+    // a1 = sqrt(7/40), b31 = -sqrt(10/7)/24, b51 = b31/3, b52 = -5 b51. The
+    // b weights are twice the published ones, which are for the drift-kick-
+    // drift kernel; the error term they cancel is twice as large for KDK.
+    static constexpr double kCorrectorA1 = 0.41833001326703777;
+    static constexpr double kCorrectorB31 = -0.049801192055599734;
+    static constexpr double kCorrectorB51 = -0.016600397351866577;
+    static constexpr double kCorrectorB52 = 0.08300198675933289;
+
+    WisdomHolmanParams m_params;
+    double m_dt = 0.0;
+    double m_G = 0.0;
+
+    std::vector<uint32_t> m_index;   // slot -> body; slot 0 is the central body
+    std::vector<double> m_mass;      // per slot
+    std::vector<double> m_eta;       // cumulative mass through each slot
+    State m_state;
+    State m_saved;
+
+    // Coordinates written by the last step, to detect outside edits.
+    std::vector<double> m_outX, m_outY, m_outZ, m_outVx, m_outVy, m_outVz;
+};
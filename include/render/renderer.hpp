@@ -2,7 +2,7 @@
 #include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
-#include "physics/body.hpp"
+#include "physics/body_storage.hpp"
 
 class Renderer {
 public:
@@ -16,7 +16,7 @@ public:
     void setScale(double metersPerUnit);
 
 
-    void draw(const std::vector<Body>& solverBodies);
+    void draw(ConstBodyView solverBodies);
 
 
     void resize(int width, int height);
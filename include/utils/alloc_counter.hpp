@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+
+// Global heap allocation counter for checking that hot loops stay off the
+// heap. Only live when built with NBODY_COUNT_ALLOCATIONS (CMake option of
+// the same name), which replaces the global operator new; otherwise
+// count() is always 0.
+namespace allocations {
+
+constexpr bool enabled() {
+#ifdef NBODY_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Calls to any global operator new since startup, on all threads.
+size_t count();
+
+} // namespace allocations
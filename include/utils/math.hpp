@@ -0,0 +1,59 @@
+#pragma once
+#include <cmath>
+
+// Stumpff functions c0..c3 of z. |z| is quartered into the range where the
+// series converges quickly, then scaled back with the doubling identities.
+inline void stumpff(double z, double c[4]) {
+    int halvings = 0;
+    while (std::fabs(z) > 0.1) {
+        z *= 0.25;
+        ++halvings;
+    }
+    c[3] = (1.0 - z / 20.0 * (1.0 - z / 42.0 * (1.0 - z / 72.0 * (1.0 - z / 110.0 *
+           (1.0 - z / 156.0 * (1.0 - z / 210.0)))))) / 6.0;
+    c[2] = (1.0 - z / 12.0 * (1.0 - z / 30.0 * (1.0 - z / 56.0 * (1.0 - z / 90.0 *
+           (1.0 - z / 132.0 * (1.0 - z / 182.0)))))) / 2.0;
+    c[1] = 1.0 - z * c[3];
+    c[0] = 1.0 - z * c[2];
+    for (; halvings > 0; --halvings) {
+        c[3] = 0.25 * (c[2] + c[0] * c[3]);
+        c[2] = 0.5 * c[1] * c[1];
+        c[1] = c[0] * c[1];
+        c[0] = 2.0 * c[0] * c[0] - 1.0;
+    }
+}
+
+// 3-vector over any number type, including user-defined formats that glm
+// cannot hold. T needs + - * / and a value-initialized zero; length()
+// finds sqrt by argument-dependent lookup, falling back to std::sqrt.
+template <typename T>
+struct Vec3 {
+    T x{}, y{}, z{};
+
+    Vec3() = default;
+    Vec3(T x, T y, T z) : x(x), y(y), z(z) {}
+
+    Vec3& operator+=(const Vec3& o) { x = x + o.x; y = y + o.y; z = z + o.z; return *this; }
+    Vec3& operator-=(const Vec3& o) { x = x - o.x; y = y - o.y; z = z - o.z; return *this; }
+    Vec3& operator*=(const T& s) { x = x * s; y = y * s; z = z * s; return *this; }
+};
+
+template <typename T>
+Vec3<T> operator+(Vec3<T> a, const Vec3<T>& b) { return a += b; }
+template <typename T>
+Vec3<T> operator-(Vec3<T> a, const Vec3<T>& b) { return a -= b; }
+template <typename T>
+Vec3<T> operator*(Vec3<T> a, const T& s) { return a *= s; }
+template <typename T>
+Vec3<T> operator*(const T& s, Vec3<T> a) { return a *= s; }
+
+template <typename T>
+T dot(const Vec3<T>& a, const Vec3<T>& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template <typename T>
+T length(const Vec3<T>& v) {
+    using std::sqrt;
+    return sqrt(dot(v, v));
+}
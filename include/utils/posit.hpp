@@ -0,0 +1,332 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+// Software posit<nbits, es> (Gustafson & Yonemoto; 2022 standard layout:
+// sign, regime run, es exponent bits, fraction). A third parameter bounds
+// the regime run at rs bits, which gives the b-posits: once the run hits rs
+// it needs no terminating bit, the precision never drops below
+// nbits - 1 - rs - es fraction bits and decoding has a fixed latency.
+//
+// Every operation decodes to (sign, scale, 64-bit significand) with one
+// count-leading-zeros for the regime, works on integers and re-encodes
+// with round to nearest even on the bit string, so there is never a round
+// trip through double. Up to 32 bits the significands fit in 32 bits and
+// mul/div/sqrt stay in 64-bit arithmetic; wider formats use unsigned
+// __int128.
+//
+// Posits never overflow or underflow: results saturate at maxpos / minpos.
+// The one exception value, NaR (not a real), comes from x / 0, sqrt(x < 0)
+// and NaN inputs, and propagates. NaR orders below every real, so the
+// comparisons are plain signed-integer compares of the bit patterns.
+//
+// The type has everything BasicSolver<Scalar> needs: arithmetic, explicit
+// conversions to and from double and sqrt found by argument-dependent
+// lookup.
+template <unsigned nbits, unsigned es, unsigned rs = nbits - 1>
+class posit {
+    static_assert(nbits >= 3 && nbits <= 64, "posit width must be 3..64 bits");
+    static_assert(rs >= 1 && rs <= nbits - 1, "regime bound must be 1..nbits - 1");
+    static_assert(((rs + 1) << es) <= 1022, "scale range exceeds the exponent range of double");
+#ifndef __SIZEOF_INT128__
+    static_assert(nbits <= 32, "posits wider than 32 bits need unsigned __int128");
+#endif
+
+public:
+    using bits_type = std::conditional_t<(nbits <= 8), uint8_t,
+                      std::conditional_t<(nbits <= 16), uint16_t,
+                      std::conditional_t<(nbits <= 32), uint32_t, uint64_t>>>;
+
+    posit() = default;
+    explicit posit(double value) : m_bits(bits_type(fromDouble(value))) {}
+    explicit operator double() const { return toDouble(m_bits); }
+
+    static posit fromBits(uint64_t bits) { posit p; p.m_bits = bits_type(bits & kMask); return p; }
+    bits_type bits() const { return m_bits; }
+
+    static posit zero() { return fromBits(0); }
+    static posit nar() { return fromBits(kNaR); }
+    static posit maxpos() { return fromBits(kNaR - 1); }
+    static posit minpos() { return fromBits(1); }
+
+    bool isZero() const { return m_bits == 0; }
+    bool isNaR() const { return m_bits == kNaR; }
+    bool isNegative() const { return (m_bits >> (nbits - 1)) & 1; }
+
+    posit operator-() const { return fromBits(0 - uint64_t(m_bits)); }
+
+    friend posit operator+(posit a, posit b) { return fromBits(add(a.m_bits, b.m_bits)); }
+    friend posit operator-(posit a, posit b) { return fromBits(add(a.m_bits, (0 - uint64_t(b.m_bits)) & kMask)); }
+    friend posit operator*(posit a, posit b) { return fromBits(mul(a.m_bits, b.m_bits)); }
+    friend posit operator/(posit a, posit b) { return fromBits(div(a.m_bits, b.m_bits)); }
+    posit& operator+=(posit o) { return *this = *this + o; }
+    posit& operator-=(posit o) { return *this = *this - o; }
+    posit& operator*=(posit o) { return *this = *this * o; }
+    posit& operator/=(posit o) { return *this = *this / o; }
+
+    friend bool operator==(posit a, posit b) { return a.m_bits == b.m_bits; }
+    friend bool operator!=(posit a, posit b) { return a.m_bits != b.m_bits; }
+    friend bool operator<(posit a, posit b) { return a.ordered() < b.ordered(); }
+    friend bool operator>(posit a, posit b) { return a.ordered() > b.ordered(); }
+    friend bool operator<=(posit a, posit b) { return a.ordered() <= b.ordered(); }
+    friend bool operator>=(posit a, posit b) { return a.ordered() >= b.ordered(); }
+
+    friend posit sqrt(posit a) { return fromBits(root(a.m_bits)); }
+    friend posit abs(posit a) { return a.isNegative() && !a.isNaR() ? -a : a; }
+
+    // Unpacked value: (-1)^neg * sig / 2^63 * 2^scale, top bit of sig set.
+    struct Unpacked {
+        bool neg;
+        int scale;
+        uint64_t sig;
+    };
+
+    static constexpr uint64_t kMask = nbits == 64 ? ~uint64_t(0) : (uint64_t(1) << nbits) - 1;
+    static constexpr uint64_t kNaR = uint64_t(1) << (nbits - 1);
+    // Largest scale: a run of rs ones, then as many exponent ones as fit.
+    static constexpr unsigned kTailBits = nbits - 1 - rs < es ? nbits - 1 - rs : es;
+    static constexpr int kMaxScale = (int(rs - 1) << es) + int(((1u << kTailBits) - 1) << (es - kTailBits));
+    static constexpr int kMinScale = -(int(rs) << es);
+
+    // Bit patterns other than zero and NaR.
+    static Unpacked decode(uint64_t bits) {
+        const bool neg = (bits >> (nbits - 1)) & 1;
+        const uint64_t u = neg ? (0 - bits) & kMask : bits;
+        uint64_t x = u << (65 - nbits);   // drop the sign
+        const bool ones = x >> 63;
+        int run = clz(ones ? ~x : x);
+        if (run > int(rs)) run = int(rs);
+        const int k = ones ? run - 1 : -run;
+        x = shl(x, run + (run < int(rs)));
+        const int e = es ? int(x >> (64 - es)) : 0;
+        x = shl(x, es);
+        return {neg, k * (1 << es) + e, (x >> 1) | (uint64_t(1) << 63)};
+    }
+
+    // Rounds (-1)^neg * sig / 2^63 * 2^scale (plus a nonzero tail below
+    // sig when sticky) to the nearest posit, ties to even.
+    static uint64_t encode(bool neg, int scale, uint64_t sig, bool sticky) {
+        uint64_t p;
+        if (scale > kMaxScale) {
+            p = kNaR - 1;
+        } else if (scale < kMinScale) {
+            p = 1;
+        } else {
+            const int k = scale >= 0 ? scale >> es : -((-scale + (1 << es) - 1) >> es);
+            const uint64_t e = uint64_t(scale - k * (1 << es));
+            const uint64_t frac = sig << 1;
+            uint64_t body = frac;
+            if (es) {
+                body = (e << (64 - es)) | (frac >> es);
+                sticky |= (frac & ((uint64_t(1) << es) - 1)) != 0;
+            }
+            const int run = k >= 0 ? k + 1 : -k;
+            const int rlen = run + (run < int(rs));
+            uint64_t regime;
+            if (k >= 0) regime = ~uint64_t(0) << (64 - run);
+            else regime = run < int(rs) ? uint64_t(1) << (64 - rlen) : 0;
+            sticky |= rlen >= 64 ? body != 0 : (body & ((uint64_t(1) << rlen) - 1)) != 0;
+            const uint64_t full = regime | shr(body, rlen);
+
+            constexpr int keep = int(nbits) - 1;
+            p = full >> (64 - keep);
+            const uint64_t rest = full << keep;
+            const bool guard = rest >> 63;
+            sticky |= (rest << 1) != 0;
+            if (guard && (sticky || (p & 1))) ++p;
+            // Never round to zero or past maxpos into NaR.
+            if (p == 0) p = 1;
+            if (p == kNaR) p = kNaR - 1;
+        }
+        return neg ? (0 - p) & kMask : p;
+    }
+
+private:
+    bits_type m_bits = 0;
+
+    int64_t ordered() const { return int64_t(uint64_t(m_bits) << (64 - nbits)); }
+
+    static int clz(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+        return x ? __builtin_clzll(x) : 64;
+#else
+        int n = 0;
+        for (uint64_t bit = uint64_t(1) << 63; bit && !(x & bit); bit >>= 1) ++n;
+        return n;
+#endif
+    }
+    static uint64_t shl(uint64_t x, int s) { return s >= 64 ? 0 : x << s; }
+    static uint64_t shr(uint64_t x, int s) { return s >= 64 ? 0 : x >> s; }
+
+    static uint64_t fromDouble(double value) {
+        uint64_t b;
+        std::memcpy(&b, &value, sizeof b);
+        const bool neg = b >> 63;
+        const int ex = int((b >> 52) & 0x7ff);
+        const uint64_t man = b & ((uint64_t(1) << 52) - 1);
+        if (ex == 0x7ff) return kNaR;
+        if (ex == 0 && man == 0) return 0;
+        if (ex == 0) {
+            const int lz = clz(man);
+            return encode(neg, -1011 - lz, man << lz, false);
+        }
+        return encode(neg, ex - 1023, (man << 11) | (uint64_t(1) << 63), false);
+    }
+
+    static double toDouble(uint64_t bits) {
+        if (bits == 0) return 0.0;
+        if (bits == kNaR) return std::numeric_limits<double>::quiet_NaN();
+        const Unpacked v = decode(bits);
+        // The scale stays in the normal range (see the static_assert);
+        // round the 63 fraction bits to 52.
+        uint64_t man = (v.sig >> 11) & ((uint64_t(1) << 52) - 1);
+        int scale = v.scale;
+        const bool guard = (v.sig >> 10) & 1;
+        const bool sticky = (v.sig & 0x3ff) != 0;
+        if (guard && (sticky || (man & 1)) && ++man == (uint64_t(1) << 52)) {
+            man = 0;
+            ++scale;
+        }
+        const uint64_t b = (uint64_t(v.neg) << 63) | (uint64_t(scale + 1023) << 52) | man;
+        double out;
+        std::memcpy(&out, &b, sizeof out);
+        return out;
+    }
+
+    static uint64_t add(uint64_t a, uint64_t b) {
+        if (a == kNaR || b == kNaR) return kNaR;
+        if (a == 0) return b;
+        if (b == 0) return a;
+        Unpacked x = decode(a), y = decode(b);
+        if (x.scale < y.scale || (x.scale == y.scale && x.sig < y.sig)) std::swap(x, y);
+
+        // Hidden bit at 62 leaves room for the carry.
+        const int d = x.scale - y.scale;
+        uint64_t big = x.sig >> 1, small = y.sig >> 1;
+        bool sticky;
+        if (d >= 63) {
+            sticky = small != 0;
+            small = 0;
+        } else {
+            sticky = (small & ((uint64_t(1) << d) - 1)) != 0;
+            small >>= d;
+        }
+
+        int scale = x.scale;
+        uint64_t sum;
+        if (x.neg == y.neg) {
+            sum = big + small;
+            if (sum >> 63) ++scale;
+            else sum <<= 1;
+        } else {
+            // A nonzero tail below `small` borrows one unit and stays sticky.
+            sum = big - small - uint64_t(sticky);
+            if (sum == 0) return 0;
+            const int lz = clz(sum);
+            sum <<= lz;
+            scale += 1 - lz;
+        }
+        return encode(x.neg, scale, sum, sticky);
+    }
+
+    static uint64_t mul(uint64_t a, uint64_t b) {
+        if (a == kNaR || b == kNaR) return kNaR;
+        if (a == 0 || b == 0) return 0;
+        const Unpacked x = decode(a), y = decode(b);
+        int scale = x.scale + y.scale;
+        if constexpr (nbits <= 32) {
+            // At most 29 fraction bits: the product is exact in 64 bits.
+            uint64_t sig = (x.sig >> 32) * (y.sig >> 32);
+            if (sig >> 63) ++scale;
+            else sig <<= 1;
+            return encode(x.neg != y.neg, scale, sig, false);
+        } else {
+#ifdef __SIZEOF_INT128__
+            const unsigned __int128 wide = (unsigned __int128)x.sig * y.sig;
+            const uint64_t hi = uint64_t(wide >> 64), lo = uint64_t(wide);
+            if (hi >> 63) {
+                return encode(x.neg != y.neg, scale + 1, hi, lo != 0);
+            }
+            return encode(x.neg != y.neg, scale, (hi << 1) | (lo >> 63), (lo << 1) != 0);
+#endif
+        }
+    }
+
+    static uint64_t div(uint64_t a, uint64_t b) {
+        if (a == kNaR || b == kNaR || b == 0) return kNaR;
+        if (a == 0) return 0;
+        const Unpacked x = decode(a), y = decode(b);
+        int scale = x.scale - y.scale;
+        uint64_t q = 0;
+        bool sticky = false;
+        if constexpr (nbits <= 32) {
+            // q = x / y * 2^31 in (2^30, 2^32), at least 31 significant bits.
+            const uint64_t n = (x.sig >> 32) << 31, d = y.sig >> 32;
+            q = n / d;
+            sticky = n % d != 0;
+            const int lz = clz(q);
+            q <<= lz;
+            scale += 32 - lz;
+        } else {
+#ifdef __SIZEOF_INT128__
+            const unsigned __int128 n = (unsigned __int128)x.sig << 63;
+            q = uint64_t(n / y.sig);
+            sticky = n % y.sig != 0;
+            const int lz = clz(q);
+            q <<= lz;
+            scale -= lz;
+#endif
+        }
+        return encode(x.neg != y.neg, scale, q, sticky);
+    }
+
+    static uint64_t root(uint64_t a) {
+        if (a == 0) return 0;
+        if (a == kNaR || (a >> (nbits - 1))) return kNaR;
+        const Unpacked x = decode(a);
+        // Even scale: sqrt(sig * 2^63) / 2^63; odd: sqrt(sig * 2^64) / 2^63
+        // with the scale lowered by one first.
+        const int odd = x.scale & 1;
+        const int scale = (x.scale - odd) / 2;
+        if constexpr (nbits <= 32) {
+            uint64_t rem;
+            const uint64_t r = isqrt<uint64_t>((x.sig >> 32) << (31 + odd), rem);
+            return encode(false, scale, r << 32, rem != 0);
+        } else {
+#ifdef __SIZEOF_INT128__
+            unsigned __int128 rem;
+            const unsigned __int128 r = isqrt<unsigned __int128>((unsigned __int128)x.sig << (63 + odd), rem);
+            return encode(false, scale, uint64_t(r), rem != 0);
+#endif
+        }
+    }
+
+    // Digit-by-digit integer square root; rem = n - root^2.
+    template <typename U>
+    static U isqrt(U n, U& rem) {
+        U res = 0;
+        for (U one = U(1) << (sizeof(U) * 8 - 2); one != 0; one >>= 2) {
+            const U trial = res + one;
+            const U take = U(0) - U(n >= trial);
+            n -= trial & take;
+            res = (res >> 1) + (one & take);
+        }
+        rem = n;
+        return res;
+    }
+};
+
+// 2022 standard formats (es = 2 at every width).
+using posit8 = posit<8, 2>;
+using posit16 = posit<16, 2>;
+using posit32 = posit<32, 2>;
+using posit64 = posit<64, 2>;
+
+// b-posits: regime of at most 6 bits and 5 exponent bits, so every value
+// keeps at least nbits - 12 fraction bits over a scale range of +-192.
+using bposit16 = posit<16, 5, 6>;
+using bposit32 = posit<32, 5, 6>;
+using bposit64 = posit<64, 5, 6>;
@@ -0,0 +1,262 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "posit.hpp"
+#include "quire.hpp"
+
+// Table-driven arithmetic for posits of up to 16 bits, bit-identical to
+// posit<> (which builds the tables) and a drop-in Scalar for BasicSolver.
+//
+// Up to 8 bits every two-operand result is one load: add, mul and div each
+// have a table of all operand pairs (64 KiB apiece for posit8), and
+// a - b reads the add table with -b.
+//
+// Up to 16 bits the tables are factored instead. A value table widens each
+// pattern to its exact double (the positive half is stored, as float where
+// the scales allow: 128 KiB for posit16), the operation runs in double, and
+// a table indexed by the result's scale holds the regime and exponent bits
+// and the fraction's shift, so rounding back is an or, a shift and the
+// round-to-nearest-even step with no regime decoding on either side.
+// sqrt is tabulated over the positive patterns at both widths.
+//
+// The tables are built on first use and live in static storage.
+template <typename P>
+class tabulated;
+
+template <unsigned nbits, unsigned es, unsigned rs>
+class tabulated<posit<nbits, es, rs>> {
+    static_assert(nbits <= 16, "tabulated posits are limited to 16 bits");
+    static_assert(2 * posit<nbits, es, rs>::kMaxScale + 2 < 1024 && 2 * posit<nbits, es, rs>::kMinScale - 2 > -1022,
+                  "products and quotients must stay in double's normal range");
+
+public:
+    using posit_type = posit<nbits, es, rs>;
+    using bits_type = typename posit_type::bits_type;
+
+    tabulated() = default;
+    explicit tabulated(double value) : m_bits(bits_type(fromDouble(value))) {}
+    explicit tabulated(posit_type p) : m_bits(p.bits()) {}
+    explicit operator double() const { return toDouble(m_bits); }
+    explicit operator posit_type() const { return posit_type::fromBits(m_bits); }
+
+    static tabulated fromBits(uint64_t bits) { tabulated p; p.m_bits = bits_type(bits & kMask); return p; }
+    bits_type bits() const { return m_bits; }
+
+    static tabulated zero() { return fromBits(0); }
+    static tabulated nar() { return fromBits(kNaR); }
+    static tabulated maxpos() { return fromBits(kNaR - 1); }
+    static tabulated minpos() { return fromBits(1); }
+
+    bool isZero() const { return m_bits == 0; }
+    bool isNaR() const { return m_bits == kNaR; }
+    bool isNegative() const { return (m_bits >> (nbits - 1)) & 1; }
+
+    tabulated operator-() const { return fromBits(0 - uint64_t(m_bits)); }
+
+    friend tabulated operator+(tabulated a, tabulated b) { return fromBits(add(a.m_bits, b.m_bits)); }
+    friend tabulated operator-(tabulated a, tabulated b) { return fromBits(add(a.m_bits, (0 - uint64_t(b.m_bits)) & kMask)); }
+    friend tabulated operator*(tabulated a, tabulated b) { return fromBits(mul(a.m_bits, b.m_bits)); }
+    friend tabulated operator/(tabulated a, tabulated b) { return fromBits(div(a.m_bits, b.m_bits)); }
+    tabulated& operator+=(tabulated o) { return *this = *this + o; }
+    tabulated& operator-=(tabulated o) { return *this = *this - o; }
+    tabulated& operator*=(tabulated o) { return *this = *this * o; }
+    tabulated& operator/=(tabulated o) { return *this = *this / o; }
+
+    friend bool operator==(tabulated a, tabulated b) { return a.m_bits == b.m_bits; }
+    friend bool operator!=(tabulated a, tabulated b) { return a.m_bits != b.m_bits; }
+    friend bool operator<(tabulated a, tabulated b) { return a.ordered() < b.ordered(); }
+    friend bool operator>(tabulated a, tabulated b) { return a.ordered() > b.ordered(); }
+    friend bool operator<=(tabulated a, tabulated b) { return a.ordered() <= b.ordered(); }
+    friend bool operator>=(tabulated a, tabulated b) { return a.ordered() >= b.ordered(); }
+
+    friend tabulated sqrt(tabulated a) {
+        if (a.isNegative()) return nar();
+        return fromBits(tables().root[a.m_bits]);
+    }
+    friend tabulated abs(tabulated a) { return a.isNegative() && !a.isNaR() ? -a : a; }
+
+private:
+    static constexpr uint64_t kMask = posit_type::kMask;
+    static constexpr uint64_t kNaR = posit_type::kNaR;
+    static constexpr int kMinScale = posit_type::kMinScale;
+    static constexpr int kMaxScale = posit_type::kMaxScale;
+    static constexpr bool kPairTables = nbits <= 8;
+    static constexpr size_t kPositive = size_t(1) << (nbits - 1);
+    static constexpr size_t kPairs = kPairTables ? size_t(1) << (2 * nbits) : 1;
+
+    // Exact values of the positive patterns fit a float when the scales
+    // do (posit16), else a double (bposit16).
+    using value_type = std::conditional_t<(kMinScale >= -126 && kMaxScale <= 127), float, double>;
+
+    // Regime and exponent bits of a scale, left-aligned below the sign,
+    // and how far the fraction is shifted to follow them.
+    struct Head {
+        uint64_t bits;
+        unsigned len;
+    };
+
+    struct Tables {
+        value_type value[kPositive + 1];   // the last entry, at kNaR, is NaN
+        Head head[kMaxScale - kMinScale + 1];
+        bits_type root[kPositive];
+        bits_type sum[kPairs];
+        bits_type product[kPairs];
+        bits_type quotient[kPairs];
+
+        Tables() {
+            for (size_t u = 0; u <= kPositive; ++u) value[u] = value_type(double(posit_type::fromBits(u)));
+            for (int scale = kMinScale; scale <= kMaxScale; ++scale) {
+                const int k = scale >= 0 ? scale >> es : -((-scale + (1 << es) - 1) >> es);
+                const uint64_t e = uint64_t(scale - k * (1 << es));
+                const int run = k >= 0 ? k + 1 : -k;
+                const unsigned rlen = unsigned(run + (run < int(rs)));
+                uint64_t regime;
+                if (k >= 0) regime = ~uint64_t(0) << (64 - run);
+                else regime = run < int(rs) ? uint64_t(1) << (64 - rlen) : 0;
+                const uint64_t exponent = es ? (e << (64 - es)) >> rlen : 0;
+                head[scale - kMinScale] = {regime | exponent, rlen + es};
+            }
+            for (size_t u = 0; u < kPositive; ++u) root[u] = sqrt(posit_type::fromBits(u)).bits();
+            if constexpr (kPairTables) {
+                for (size_t a = 0; a <= kMask; ++a) {
+                    for (size_t b = 0; b <= kMask; ++b) {
+                        const posit_type x = posit_type::fromBits(a), y = posit_type::fromBits(b);
+                        sum[(a << nbits) | b] = (x + y).bits();
+                        product[(a << nbits) | b] = (x * y).bits();
+                        quotient[(a << nbits) | b] = (x / y).bits();
+                    }
+                }
+            }
+        }
+    };
+
+    bits_type m_bits = 0;
+
+    static const Tables& tables() {
+        static const Tables t;
+        return t;
+    }
+
+    int64_t ordered() const { return int64_t(uint64_t(m_bits) << (64 - nbits)); }
+
+    // Exact value: the magnitude's entry with the sign bit set for negative
+    // patterns; NaR is NaN.
+    static double widen(const Tables& t, uint64_t bits) {
+        const uint64_t neg = (bits >> (nbits - 1)) & 1;
+        const uint64_t m = 0 - neg;
+        const double v = t.value[((bits ^ m) - m) & kMask];
+        uint64_t b;
+        std::memcpy(&b, &v, sizeof b);
+        b ^= neg << 63;
+        double out;
+        std::memcpy(&out, &b, sizeof out);
+        return out;
+    }
+
+    // Rounds (-1)^neg * (1 + frac / 2^64) * 2^scale, plus a nonzero tail
+    // when sticky, to nearest even; same rounding as posit::encode.
+    static uint64_t pack(const Tables& t, bool neg, int scale, uint64_t frac, bool sticky) {
+        uint64_t p;
+        if (scale > kMaxScale) {
+            p = kNaR - 1;
+        } else if (scale < kMinScale) {
+            p = 1;
+        } else {
+            const Head h = t.head[scale - kMinScale];
+            const uint64_t full = h.bits | (frac >> h.len);
+            sticky |= (frac << (64 - h.len)) != 0;
+            constexpr int keep = int(nbits) - 1;
+            p = full >> (64 - keep);
+            const uint64_t rest = full << keep;
+            const bool guard = rest >> 63;
+            sticky |= (rest << 1) != 0;
+            p += uint64_t(guard & (sticky | (p & 1)));
+            if (p == 0) p = 1;
+            if (p == kNaR) p = kNaR - 1;
+        }
+        const uint64_t m = 0 - uint64_t(neg);
+        return ((p ^ m) - m) & kMask;
+    }
+
+    // Rounds the double result of an operation on widened operands. Such
+    // results are zero, NaN or normal: sums, products and quotients of
+    // these posits stay far inside double's exponent range.
+    static uint64_t narrow(const Tables& t, double value) {
+        uint64_t b;
+        std::memcpy(&b, &value, sizeof b);
+        const unsigned ex = unsigned(b >> 52) & 0x7ff;
+        if (ex == 0) return 0;
+        if (ex == 0x7ff) return kNaR;
+        return pack(t, b >> 63, int(ex) - 1023, b << 12, false);
+    }
+
+    static uint64_t fromDouble(double value) {
+        uint64_t b;
+        std::memcpy(&b, &value, sizeof b);
+        const bool neg = b >> 63;
+        const int ex = int((b >> 52) & 0x7ff);
+        const uint64_t man = b & ((uint64_t(1) << 52) - 1);
+        if (ex == 0x7ff) return kNaR;
+        if (ex == 0) {
+            // Subnormals lie far below minpos.
+            if (man == 0) return 0;
+            return neg ? kMask : 1;
+        }
+        return pack(tables(), neg, ex - 1023, man << 12, false);
+    }
+
+    static double toDouble(uint64_t bits) { return widen(tables(), bits); }
+
+    // Double carries more than twice the precision of these formats plus
+    // two bits, so rounding its correctly rounded sum, product or quotient
+    // once more gives the correctly rounded posit result.
+    static uint64_t add(uint64_t a, uint64_t b) {
+        const Tables& t = tables();
+        if constexpr (kPairTables) return t.sum[(a << nbits) | b];
+        else return narrow(t, widen(t, a) + widen(t, b));
+    }
+
+    static uint64_t mul(uint64_t a, uint64_t b) {
+        const Tables& t = tables();
+        if constexpr (kPairTables) return t.product[(a << nbits) | b];
+        else return narrow(t, widen(t, a) * widen(t, b));
+    }
+
+    static uint64_t div(uint64_t a, uint64_t b) {
+        const Tables& t = tables();
+        if constexpr (kPairTables) return t.quotient[(a << nbits) | b];
+        else return narrow(t, widen(t, a) / widen(t, b));   // x / 0 is infinite: NaR
+    }
+};
+
+using posit8_table = tabulated<posit8>;
+using posit16_table = tabulated<posit16>;
+using bposit16_table = tabulated<bposit16>;
+
+// The quire of the underlying format, so BasicSolver's exact sums work
+// with tabulated scalars too.
+template <typename P>
+class quire<tabulated<P>> {
+    using T = tabulated<P>;
+
+public:
+    void clear() { m_quire.clear(); }
+    void add(T v) { m_quire.add(P(v)); }
+    void addProduct(T a, T b) { m_quire.addProduct(P(a), P(b)); }
+    quire& operator+=(T v) {
+        add(v);
+        return *this;
+    }
+    T value() const { return T(m_quire.value()); }
+
+private:
+    quire<P> m_quire;
+};
+
+template <typename P>
+struct ExactAccumulator<tabulated<P>> {
+    static constexpr bool available = ExactAccumulator<P>::available;
+    using type = quire<tabulated<P>>;
+};
@@ -0,0 +1,364 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "posit.hpp"
+
+// Exact accumulators (Kulisch): a fixed-point register wide enough for any
+// sum of a format's values and products, so a dot product or force sum is
+// rounded once at the end and no longer depends on the order of its terms.
+
+// Two's complement fixed-point number of Digits 32-bit digits, digit 0
+// weighing 2^Lsb. Each digit sits in an int64_t lane. Adding a value of up
+// to 53 bits splits it at the digit boundary below its shifted position:
+// 32 bits go to one lane, the rest (up to 53 bits) to the next, two plain
+// adds with no carry handling. The upper bits of every lane collect
+// carries; they are propagated every 512 adds, before any lane can
+// overflow, and before reading.
+template <int Lsb, size_t Digits>
+class FixedPointAccumulator {
+public:
+    // Rounding input in posit::encode's form: (-1)^neg * sig / 2^63 *
+    // 2^scale with the top bit of sig set, sticky for a nonzero tail.
+    struct Rounding {
+        bool neg;
+        int scale;
+        uint64_t sig;
+        bool sticky;
+    };
+
+    void clear() {
+        std::fill(m_limbs, m_limbs + Digits, int64_t(0));
+        m_pending = 0;
+    }
+
+    // Adds (-1)^neg * sig * 2^exp, exp >= Lsb. Wider than 53 bits, sig goes
+    // in as two halves.
+    void add(bool neg, uint64_t sig, int exp) {
+        if (sig >> 53) {
+            addNarrow(neg, sig & 0xffffffff, exp);
+            addNarrow(neg, sig >> 32, exp + 32);
+        } else {
+            addNarrow(neg, sig, exp);
+        }
+    }
+
+    // False when the sum is exactly zero.
+    bool read(Rounding& out) const {
+        normalize();
+        const bool neg = m_limbs[Digits - 1] < 0;
+        uint64_t mag[Digits];
+        uint64_t borrow = 1;
+        for (size_t i = 0; i + 1 < Digits; ++i) {
+            if (neg) {
+                const uint64_t v = (~uint64_t(m_limbs[i]) & 0xffffffff) + borrow;
+                mag[i] = v & 0xffffffff;
+                borrow = v >> 32;
+            } else {
+                mag[i] = uint64_t(m_limbs[i]);
+            }
+        }
+        mag[Digits - 1] = neg ? ~uint64_t(m_limbs[Digits - 1]) + borrow : uint64_t(m_limbs[Digits - 1]);
+
+        size_t h = Digits;
+        while (h > 0 && mag[h - 1] == 0) --h;
+        if (h == 0) return false;
+        --h;
+
+        // Top 64 bits from the leading digit down; the top lane may be
+        // wider than 32 bits.
+        const int topBits = 64 - clz(mag[h]);
+        uint64_t sig = mag[h] << (64 - topBits);
+        int filled = topBits;
+        bool sticky = false;
+        for (size_t i = h; i-- > 0;) {
+            const int take = 64 - filled;
+            if (take >= 32) {
+                sig |= mag[i] << (take - 32);
+                filled += 32;
+            } else if (take > 0) {
+                sig |= mag[i] >> (32 - take);
+                sticky |= (mag[i] & ((uint64_t(1) << (32 - take)) - 1)) != 0;
+                filled = 64;
+            } else {
+                sticky |= mag[i] != 0;
+            }
+        }
+        out = {neg, Lsb + int(32 * h) + topBits - 1, sig, sticky};
+        return true;
+    }
+
+private:
+    // A normalized lane is below 2^32 and each add brings less than 2^53.
+    static constexpr uint32_t kCarryInterval = 512;
+
+    mutable int64_t m_limbs[Digits] = {};
+    mutable uint32_t m_pending = 0;
+
+    void addNarrow(bool neg, uint64_t sig, int exp) {
+        assert(exp >= Lsb);
+        const unsigned shift = unsigned(exp - Lsb);
+        const size_t d = shift >> 5;
+        const unsigned off = shift & 31;
+        const int64_t s = -int64_t(neg);
+        const int64_t lo = int64_t((sig << off) & 0xffffffff);
+        const int64_t hi = int64_t((sig >> 1) >> (31 - off));
+        m_limbs[d] += (lo ^ s) - s;
+        m_limbs[d + 1] += (hi ^ s) - s;
+        if (++m_pending == kCarryInterval) normalize();
+    }
+
+    // Carries move up and every lane but the top returns to [0, 2^32).
+    void normalize() const {
+        for (size_t i = 0; i + 1 < Digits; ++i) {
+            const int64_t carry = m_limbs[i] >> 32;
+            m_limbs[i] &= 0xffffffff;
+            m_limbs[i + 1] += carry;
+        }
+        m_pending = 0;
+    }
+
+    static int clz(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(x);
+#else
+        int n = 0;
+        for (uint64_t bit = uint64_t(1) << 63; !(x & bit); bit >>= 1) ++n;
+        return n;
+#endif
+    }
+};
+
+// Kulisch accumulator for doubles: 67 digits (536 bytes) from 2^-1074,
+// which leaves over 40 bits of headroom above DBL_MAX. Every finite double
+// adds exactly; addProduct adds a * b exactly as the TwoProduct pair
+// p + fma(a, b, -p) (a product tail below 2^-1074 is lost with it). value()
+// rounds once to nearest even, through the subnormal range. Infinities and
+// NaNs are summed apart in double and take over the result.
+class KulischAccumulator {
+public:
+    void clear() {
+        m_acc.clear();
+        m_special = 0.0;
+    }
+
+    void add(double v) {
+        uint64_t b;
+        std::memcpy(&b, &v, sizeof b);
+        const unsigned ex = unsigned(b >> 52) & 0x7ff;
+        if (ex == 0x7ff) {
+            m_special += v;
+            return;
+        }
+        const uint64_t man = b & ((uint64_t(1) << 52) - 1);
+        if (ex == 0) {
+            m_acc.add(b >> 63, man, -1074);
+            return;
+        }
+        m_acc.add(b >> 63, man | (uint64_t(1) << 52), int(ex) - 1075);
+    }
+
+    void addProduct(double a, double b) {
+        const double p = a * b;
+        add(p);
+        if (std::isfinite(p)) add(std::fma(a, b, -p));
+    }
+
+    KulischAccumulator& operator+=(double v) {
+        add(v);
+        return *this;
+    }
+
+    // Adds sig * 2^exp exactly, exp >= -1074.
+    void addSignificand(int64_t sig, int exp) {
+        m_acc.add(sig < 0, sig < 0 ? 0 - uint64_t(sig) : uint64_t(sig), exp);
+    }
+
+    double value() const {
+        if (m_special != 0.0) return m_special;
+        Accumulator::Rounding r;
+        if (!m_acc.read(r)) return 0.0;
+
+        // Keep 53 bits, fewer below 2^-1022; ldexp of the rounded integer
+        // is then exact (or overflows to infinity).
+        const int keep = r.scale >= -1022 ? 53 : 53 - (-1022 - r.scale);
+        double out = 0.0;
+        if (keep > 0) {
+            uint64_t m = r.sig >> (64 - keep);
+            const uint64_t rest = r.sig << keep;
+            const bool guard = rest >> 63;
+            if (guard && (r.sticky || (rest << 1) != 0 || (m & 1))) ++m;
+            out = std::ldexp(double(m), r.scale - keep + 1);
+        } else if (keep == 0 && (r.sticky || (r.sig << 1) != 0)) {
+            out = std::ldexp(1.0, -1074);
+        }
+        return r.neg ? -out : out;
+    }
+
+private:
+    using Accumulator = FixedPointAccumulator<-1074, 67>;
+    Accumulator m_acc;
+    double m_special = 0.0;
+};
+
+// A KulischAccumulator behind one int64 bin per double exponent, for long
+// runs of adds. A finite term's signed significand is added to the bin of
+// its biased exponent (bin 0, the subnormals, weighs the same as bin 1):
+// one integer add, no shifts and no carries. Up to kFlushInterval
+// significands below 2^53 fit a bin, so the bins in use are folded into
+// the register every kFlushInterval adds and before reading. value() is
+// KulischAccumulator's, bit for bit.
+//
+// SIMD callers split terms themselves, add into bins() directly and
+// call flushBins() with the range they touched at least every
+// kFlushInterval terms.
+class BinnedKulischAccumulator {
+public:
+    static constexpr unsigned kBins = 0x7ff;   // biased exponents of finite doubles
+    static constexpr uint32_t kFlushInterval = 1024;
+
+    void clear() {
+        flush();
+        m_acc.clear();
+    }
+
+    void add(double v) {
+        uint64_t b;
+        std::memcpy(&b, &v, sizeof b);
+        const unsigned ex = unsigned(b >> 52) & 0x7ff;
+        if (ex == kBins) {
+            m_acc.add(v);
+            return;
+        }
+        const int64_t s = -int64_t(b >> 63);
+        const int64_t sig = int64_t((b & ((uint64_t(1) << 52) - 1)) | (uint64_t(ex != 0) << 52));
+        m_bins[ex] += (sig ^ s) - s;
+        m_lo = std::min(m_lo, ex);
+        m_hi = std::max(m_hi, ex);
+        if (++m_count == kFlushInterval) flush();
+    }
+
+    BinnedKulischAccumulator& operator+=(double v) {
+        add(v);
+        return *this;
+    }
+
+    int64_t* bins() { return m_bins; }
+
+    // Folds bins [lo, hi] and those add() touched into the register.
+    void flushBins(unsigned lo, unsigned hi) {
+        m_lo = std::min(m_lo, lo);
+        m_hi = std::max(m_hi, std::min(hi, kBins - 1));   // an infinite or NaN term reports kBins
+        flush();
+    }
+
+    double value() const {
+        flush();
+        return m_acc.value();
+    }
+
+private:
+    mutable int64_t m_bins[kBins] = {};
+    mutable KulischAccumulator m_acc;
+    mutable unsigned m_lo = kBins, m_hi = 0;
+    mutable uint32_t m_count = 0;
+
+    void flush() const {
+        for (unsigned e = m_lo; e <= m_hi; ++e) {
+            if (m_bins[e] == 0) continue;
+            m_acc.addSignificand(m_bins[e], int(std::max(e, 1u)) - 1075);
+            m_bins[e] = 0;
+        }
+        m_lo = kBins;
+        m_hi = 0;
+        m_count = 0;
+    }
+};
+
+// The quire of a posit format: LSB below the square of minpos's last
+// fraction bit, top digits past maxpos^2 with guard bits, so any sum of
+// posits and exact posit products fits. value() rounds once (saturating
+// like every posit operation); a NaR term makes the result NaR.
+template <typename P>
+class quire;
+
+template <unsigned nbits, unsigned es, unsigned rs>
+class quire<posit<nbits, es, rs>> {
+    using P = posit<nbits, es, rs>;
+
+public:
+    void clear() {
+        m_acc.clear();
+        m_nar = false;
+    }
+
+    void add(P p) {
+        if (p.isZero()) return;
+        if (p.isNaR()) {
+            m_nar = true;
+            return;
+        }
+        const typename P::Unpacked u = P::decode(p.bits());
+        m_acc.add(u.neg, u.sig >> (64 - nbits), u.scale + 1 - int(nbits));
+    }
+
+    void addProduct(P a, P b) {
+        if (a.isNaR() || b.isNaR()) {
+            m_nar = true;
+            return;
+        }
+        if (a.isZero() || b.isZero()) return;
+        const typename P::Unpacked ua = P::decode(a.bits()), ub = P::decode(b.bits());
+        const bool neg = ua.neg != ub.neg;
+        const int exp = ua.scale + ub.scale + 2 - 2 * int(nbits);
+        const uint64_t ma = ua.sig >> (64 - nbits), mb = ub.sig >> (64 - nbits);
+        if constexpr (nbits <= 32) {
+            m_acc.add(neg, ma * mb, exp);
+        } else {
+            const unsigned __int128 prod = (unsigned __int128)ma * mb;
+            m_acc.add(neg, uint64_t(prod), exp);
+            m_acc.add(neg, uint64_t(prod >> 64), exp + 64);
+        }
+    }
+
+    quire& operator+=(P p) {
+        add(p);
+        return *this;
+    }
+
+    P value() const {
+        if (m_nar) return P::nar();
+        typename Accumulator::Rounding r;
+        if (!m_acc.read(r)) return P::zero();
+        return P::fromBits(P::encode(r.neg, r.scale, r.sig, r.sticky));
+    }
+
+private:
+    static constexpr int kLsb = 2 * (P::kMinScale - int(nbits));
+    static constexpr int kTop = 2 * P::kMaxScale + 2;
+    using Accumulator = FixedPointAccumulator<kLsb, size_t(kTop - kLsb) / 32 + 3>;
+    Accumulator m_acc;
+    bool m_nar = false;
+};
+
+// The exact accumulator of a scalar type, where there is one: the quire
+// for posits, KulischAccumulator for double.
+template <typename Scalar>
+struct ExactAccumulator {
+    static constexpr bool available = false;
+};
+
+template <>
+struct ExactAccumulator<double> {
+    static constexpr bool available = true;
+    using type = KulischAccumulator;
+};
+
+template <unsigned nbits, unsigned es, unsigned rs>
+struct ExactAccumulator<posit<nbits, es, rs>> {
+    static constexpr bool available = true;
+    using type = quire<posit<nbits, es, rs>>;
+};
@@ -0,0 +1,233 @@
+// src/barnes_hut.cpp
+#include "physics/barnes_hut.hpp"
+#include <algorithm>
+#include <cmath>
+
+static constexpr int kMaxDepth = 48;
+
+void BarnesHutTree::build(const SourceSet& bodies, const BarnesHutParams& params) {
+    m_src = bodies;
+    m_params = params;
+    m_nodes.clear();
+    m_leaves.clear();
+    m_order.resize(bodies.n);
+    m_scratch.resize(bodies.n);
+    if (bodies.n == 0) return;
+
+    double lo[3] = {bodies.x[0], bodies.y[0], bodies.z[0]};
+    double hi[3] = {lo[0], lo[1], lo[2]};
+    for (size_t i = 0; i < bodies.n; ++i) {
+        m_order[i] = uint32_t(i);
+        lo[0] = std::min(lo[0], bodies.x[i]); hi[0] = std::max(hi[0], bodies.x[i]);
+        lo[1] = std::min(lo[1], bodies.y[i]); hi[1] = std::max(hi[1], bodies.y[i]);
+        lo[2] = std::min(lo[2], bodies.z[i]); hi[2] = std::max(hi[2], bodies.z[i]);
+    }
+    double half = 0.5 * std::max({hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]});
+    half = half > 0.0 ? half * (1.0 + 1e-9) : 1.0;
+
+    m_nodes.reserve(2 * bodies.n / std::max<size_t>(params.leafSize, 1) + 1);
+    buildNode(0, uint32_t(bodies.n), 0.5 * (lo[0] + hi[0]), 0.5 * (lo[1] + hi[1]),
+              0.5 * (lo[2] + hi[2]), half, 0);
+
+    m_x.resize(bodies.n); m_y.resize(bodies.n); m_z.resize(bodies.n); m_m.resize(bodies.n);
+    m_ax.resize(bodies.n); m_ay.resize(bodies.n); m_az.resize(bodies.n);
+    for (size_t k = 0; k < bodies.n; ++k) {
+        uint32_t i = m_order[k];
+        m_x[k] = bodies.x[i]; m_y[k] = bodies.y[i]; m_z[k] = bodies.z[i]; m_m[k] = bodies.m[i];
+    }
+}
+
+int32_t BarnesHutTree::buildNode(uint32_t begin, uint32_t end, double ox, double oy, double oz,
+                                 double half, int depth) {
+    const int32_t index = int32_t(m_nodes.size());
+    m_nodes.emplace_back();
+    {
+        Node& node = m_nodes[index];
+        node.begin = begin;
+        node.end = end;
+        std::fill(std::begin(node.child), std::end(node.child), -1);
+        node.leaf = (end - begin) <= m_params.leafSize || depth >= kMaxDepth;
+    }
+
+    if (m_nodes[index].leaf) {
+        m_leaves.push_back(index);
+    } else {
+        // Counting sort of the range into the eight octants.
+        uint32_t count[8] = {};
+        for (uint32_t k = begin; k < end; ++k) {
+            uint32_t i = m_order[k];
+            int oct = (m_src.x[i] >= ox) | ((m_src.y[i] >= oy) << 1) | ((m_src.z[i] >= oz) << 2);
+            ++count[oct];
+        }
+        uint32_t start[8];
+        uint32_t offset = begin;
+        for (int o = 0; o < 8; ++o) { start[o] = offset; offset += count[o]; }
+        uint32_t fill[8];
+        std::copy(std::begin(start), std::end(start), fill);
+        for (uint32_t k = begin; k < end; ++k) {
+            uint32_t i = m_order[k];
+            int oct = (m_src.x[i] >= ox) | ((m_src.y[i] >= oy) << 1) | ((m_src.z[i] >= oz) << 2);
+            m_scratch[fill[oct]++] = i;
+        }
+        std::copy(m_scratch.begin() + begin, m_scratch.begin() + end, m_order.begin() + begin);
+
+        const double h = 0.5 * half;
+        for (int o = 0; o < 8; ++o) {
+            if (count[o] == 0) continue;
+            int32_t c = buildNode(start[o], start[o] + count[o],
+                                  ox + ((o & 1) ? h : -h), oy + ((o & 2) ? h : -h),
+                                  oz + ((o & 4) ? h : -h), h, depth + 1);
+            m_nodes[index].child[o] = c;
+        }
+    }
+
+    // Moments. Leaves sum their bodies; internal cells combine children
+    // with the parallel-axis shift of each child's quadrupole.
+    Node& node = m_nodes[index];
+    double m = 0.0, mx = 0.0, my = 0.0, mz = 0.0;
+    for (int a = 0; a < 3; ++a) { node.lo[a] = HUGE_VAL; node.hi[a] = -HUGE_VAL; }
+    for (uint32_t k = begin; k < end; ++k) {
+        uint32_t i = m_order[k];
+        const double p[3] = {m_src.x[i], m_src.y[i], m_src.z[i]};
+        m += m_src.m[i];
+        mx += m_src.m[i] * p[0];
+        my += m_src.m[i] * p[1];
+        mz += m_src.m[i] * p[2];
+        for (int a = 0; a < 3; ++a) {
+            node.lo[a] = std::min(node.lo[a], p[a]);
+            node.hi[a] = std::max(node.hi[a], p[a]);
+        }
+    }
+    node.mass = m;
+    if (m > 0.0) {
+        node.cx = mx / m; node.cy = my / m; node.cz = mz / m;
+    } else {
+        node.cx = ox; node.cy = oy; node.cz = oz;
+    }
+
+    std::fill(std::begin(node.q), std::end(node.q), 0.0);
+    auto addPoint = [&node](double mass, double dx, double dy, double dz) {
+        double d2 = dx * dx + dy * dy + dz * dz;
+        node.q[0] += mass * (3.0 * dx * dx - d2);
+        node.q[1] += mass * 3.0 * dx * dy;
+        node.q[2] += mass * 3.0 * dx * dz;
+        node.q[3] += mass * (3.0 * dy * dy - d2);
+        node.q[4] += mass * 3.0 * dy * dz;
+        node.q[5] += mass * (3.0 * dz * dz - d2);
+    };
+    if (node.leaf) {
+        for (uint32_t k = begin; k < end; ++k) {
+            uint32_t i = m_order[k];
+            addPoint(m_src.m[i], m_src.x[i] - node.cx, m_src.y[i] - node.cy, m_src.z[i] - node.cz);
+        }
+    } else {
+        for (int o = 0; o < 8; ++o) {
+            if (node.child[o] < 0) continue;
+            const Node& c = m_nodes[node.child[o]];
+            for (int t = 0; t < 6; ++t) node.q[t] += c.q[t];
+            addPoint(c.mass, c.cx - node.cx, c.cy - node.cy, c.cz - node.cz);
+        }
+    }
+
+    // Accept the cell when d > s/theta + delta, where delta is the offset of
+    // the centre of mass from the geometric centre (Barnes 1994).
+    double delta = std::sqrt((node.cx - ox) * (node.cx - ox) + (node.cy - oy) * (node.cy - oy) +
+                             (node.cz - oz) * (node.cz - oz));
+    double r = 2.0 * half / m_params.theta + delta;
+    node.openR2 = r * r;
+    return index;
+}
+
+void BarnesHutTree::evaluateLeaf(size_t leaf, ForceKernel kernel, double G, Scratch& scratch) {
+    const Node& target = m_nodes[m_leaves[leaf]];
+
+    // One walk for the whole leaf: a cell is accepted only if it is far
+    // enough from every point of the leaf's bounding box.
+    scratch.cells.clear();
+    scratch.near.clear();
+    scratch.stack.clear();
+    scratch.stack.push_back(0);
+    while (!scratch.stack.empty()) {
+        int32_t index = scratch.stack.back();
+        scratch.stack.pop_back();
+        const Node& node = m_nodes[index];
+        double dx = std::max({target.lo[0] - node.cx, 0.0, node.cx - target.hi[0]});
+        double dy = std::max({target.lo[1] - node.cy, 0.0, node.cy - target.hi[1]});
+        double dz = std::max({target.lo[2] - node.cz, 0.0, node.cz - target.hi[2]});
+        if (dx * dx + dy * dy + dz * dz > node.openR2) {
+            scratch.cells.push_back(index);
+        } else if (node.leaf) {
+            scratch.near.push_back(index);
+        } else {
+            for (int o = 0; o < 8; ++o)
+                if (node.child[o] >= 0) scratch.stack.push_back(node.child[o]);
+        }
+    }
+
+    // Far field. Accepted cells are packed into SoA columns so their
+    // monopoles go through the same SIMD pair kernel as the near field;
+    // the quadrupole correction is added on top.
+    const uint32_t tb = target.begin, te = target.end;
+    const size_t nc = scratch.cells.size();
+    scratch.cx.resize(nc); scratch.cy.resize(nc); scratch.cz.resize(nc); scratch.cm.resize(nc);
+    scratch.q.resize(6 * nc);
+    for (size_t c = 0; c < nc; ++c) {
+        const Node& node = m_nodes[scratch.cells[c]];
+        scratch.cx[c] = node.cx; scratch.cy[c] = node.cy; scratch.cz[c] = node.cz; scratch.cm[c] = node.mass;
+        std::copy(std::begin(node.q), std::end(node.q), scratch.q.begin() + 6 * c);
+    }
+    std::fill(m_ax.begin() + tb, m_ax.begin() + te, 0.0);
+    std::fill(m_ay.begin() + tb, m_ay.begin() + te, 0.0);
+    std::fill(m_az.begin() + tb, m_az.begin() + te, 0.0);
+    TargetSet dst{m_x.data(), m_y.data(), m_z.data(), m_ax.data(), m_ay.data(), m_az.data()};
+    SourceSet far{scratch.cx.data(), scratch.cy.data(), scratch.cz.data(), scratch.cm.data(), nc};
+    kernels::accumulateDirect(kernel, far, dst, tb, te, G);
+
+    if (m_params.quadrupole) {
+        for (uint32_t t = tb; t < te; ++t) {
+            const double xi = m_x[t], yi = m_y[t], zi = m_z[t];
+            double ax = 0.0, ay = 0.0, az = 0.0;
+            for (size_t c = 0; c < nc; ++c) {
+                const double* q = scratch.q.data() + 6 * c;
+                double dx = scratch.cx[c] - xi;
+                double dy = scratch.cy[c] - yi;
+                double dz = scratch.cz[c] - zi;
+                double invR2 = 1.0 / (dx * dx + dy * dy + dz * dz);
+                double invR5 = invR2 * invR2 * std::sqrt(invR2);
+                double qdx = q[0] * dx + q[1] * dy + q[2] * dz;
+                double qdy = q[1] * dx + q[3] * dy + q[4] * dz;
+                double qdz = q[2] * dx + q[4] * dy + q[5] * dz;
+                double s = 2.5 * (dx * qdx + dy * qdy + dz * qdz) * invR5 * invR2;
+                ax += s * dx - qdx * invR5;
+                ay += s * dy - qdy * invR5;
+                az += s * dz - qdz * invR5;
+            }
+            m_ax[t] += G * ax;
+            m_ay[t] += G * ay;
+            m_az[t] += G * az;
+        }
+    }
+
+    // Near field: sibling leaves sit next to each other in tree order, so
+    // merge adjacent ranges before handing them to the pair kernel.
+    std::sort(scratch.near.begin(), scratch.near.end(),
+              [this](int32_t a, int32_t b) { return m_nodes[a].begin < m_nodes[b].begin; });
+    size_t k = 0;
+    while (k < scratch.near.size()) {
+        uint32_t b = m_nodes[scratch.near[k]].begin;
+        uint32_t e = m_nodes[scratch.near[k]].end;
+        while (++k < scratch.near.size() && m_nodes[scratch.near[k]].begin == e)
+            e = m_nodes[scratch.near[k]].end;
+        SourceSet src{m_x.data() + b, m_y.data() + b, m_z.data() + b, m_m.data() + b, e - b};
+        kernels::accumulateDirect(kernel, src, dst, tb, te, G);
+    }
+}
+
+void BarnesHutTree::scatter(size_t begin, size_t end, const AccelSet& out) const {
+    for (size_t k = begin; k < end; ++k) {
+        uint32_t i = m_order[k];
+        out.ax[i] = m_ax[k];
+        out.ay[i] = m_ay[k];
+        out.az[i] = m_az[k];
+    }
+}
@@ -0,0 +1,604 @@
+// src/bposit_kernels.cpp
+#include "physics/bposit_kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NBODY_X86_SIMD 1
+#include <immintrin.h>
+#define NBODY_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NBODY_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#define NBODY_X86_SIMD 0
+#endif
+
+// Target vectors per pass of the SIMD kernels; the row loops are unrolled
+// so every accumulator stays in a register.
+static constexpr size_t kRows = 4;
+#if defined(__clang__)
+#define NBODY_UNROLL_ROWS _Pragma("unroll")
+#else
+#define NBODY_UNROLL_ROWS _Pragma("GCC unroll 4")
+#endif
+
+// bposit32 on the double grid: scales -192..191 are the biased exponents
+// 831..1214, and every 32 of them share one regime k = (ex - 831) / 32 - 6.
+// A regime of run bits (capped at 6) plus a terminator, 5 exponent bits
+// and 26 - rlen fraction bits, so 26 + rlen of the double's 52 are dropped.
+static constexpr uint64_t kSign = uint64_t(1) << 63;
+static constexpr uint64_t kManMask = (uint64_t(1) << 52) - 1;
+static constexpr int64_t kExpLo = 831;
+static constexpr int64_t kExpHi = 1214;
+static constexpr uint64_t kMinPos = (uint64_t(kExpLo) << 52) | (uint64_t(1) << 32);               // (1 + 2^-20) 2^-192
+static constexpr uint64_t kMaxPos = (uint64_t(kExpHi) << 52) | (((uint64_t(1) << 20) - 1) << 32);   // (2 - 2^-20) 2^191
+static constexpr uint64_t kInf = uint64_t(0x7ff) << 52;
+static constexpr uint64_t kQNaN = uint64_t(0xfff) << 51;
+static constexpr uint32_t kNaR = 0x80000000u;
+
+static inline uint64_t toBits(double v) {
+    uint64_t b;
+    std::memcpy(&b, &v, sizeof b);
+    return b;
+}
+
+static inline double fromBits(uint64_t b) {
+    double v;
+    std::memcpy(&v, &b, sizeof v);
+    return v;
+}
+
+// Nearest even on the bit string: integer rounding of the magnitude at the
+// regime's fraction width, then saturation; zero stays zero, NaN and inf
+// become NaR.
+static inline double roundScalar(double v) {
+    const uint64_t b = toBits(v);
+    const uint64_t mag = b & ~kSign;
+    if (mag == 0) return 0.0;
+    if (mag >= kInf) return fromBits(kQNaN);
+    const int64_t ex = std::clamp(int64_t(mag >> 52), kExpLo, kExpHi);
+    const int64_t kb = (ex - kExpLo) >> 5;
+    const int64_t run = std::max(kb - 5, 6 - kb);
+    const int64_t drop = 26 + std::min<int64_t>(run + 1, 6);
+    const uint64_t unit = uint64_t(1) << drop;
+    uint64_t r = (mag + (unit / 2 - 1) + ((mag >> drop) & 1)) & ~(unit - 1);
+    r = std::clamp(r, kMinPos, kMaxPos);
+    return fromBits((b & kSign) | r);
+}
+
+static inline double decodeScalar(uint32_t p) {
+    if (p == 0) return 0.0;
+    if (p == kNaR) return fromBits(kQNaN);
+    const uint64_t neg = p >> 31;
+    const uint64_t x = uint64_t(neg ? 0u - p : p) << 33;
+    const bool ones = x >> 63;
+    const uint64_t t = (ones ? ~x : x) >> 57;
+    int64_t run = 0;
+    for (int j = 1; j <= 6; ++j) run += t < (uint64_t(1) << (7 - j));
+    const int64_t k = ones ? run - 1 : -run;
+    const int64_t rlen = std::min<int64_t>(run + 1, 6);
+    const uint64_t z = x << rlen;
+    const uint64_t ex = uint64_t(k * 32 + int64_t(z >> 59) + 1023);
+    return fromBits((neg << 63) | (ex << 52) | ((z << 5) >> 12));
+}
+
+static inline uint32_t encodeScalar(double v) {
+    const uint64_t b = toBits(roundScalar(v));
+    const uint64_t mag = b & ~kSign;
+    if (mag == 0) return 0;
+    if (mag >= kInf) return kNaR;
+    const int64_t d = int64_t(mag >> 52) - kExpLo;
+    const int64_t kb = d >> 5;
+    const int64_t run = std::max(kb - 5, 6 - kb);
+    const int64_t rlen = std::min<int64_t>(run + 1, 6);
+    const uint64_t regime = kb >= 6 ? ((uint64_t(1) << run) - 1) << (rlen - run) : uint64_t(rlen - run);
+    const uint64_t body = regime << (31 - rlen) | uint64_t(d & 31) << (26 - rlen) | (mag & kManMask) >> (26 + rlen);
+    return uint32_t(b >> 63 ? 0 - body : body);
+}
+
+// a * b + c rounded to odd in double, so the final rounding onto the
+// bposit32 grid sees the sticky bit of the exact result. The product of
+// two grid values is exact in double; TwoSum gives the sum's error.
+static inline double fmaToOddScalar(double a, double b, double c) {
+    const double s = a * b;
+    const double hi = s + c;
+    const double bb = hi - s;
+    const double lo = (s - (hi - bb)) + (c - bb);
+    uint64_t h = toBits(hi);
+    if (lo != 0.0 && !(h & 1)) h += ((toBits(lo) ^ h) >> 63) ? ~uint64_t(0) : 1;
+    return fromBits(h);
+}
+
+enum class Op { Add, Mul, Fma, Rsqrt };
+
+static inline double applyScalar(Op op, const uint32_t* a, const uint32_t* b, const uint32_t* c, size_t i) {
+    const double x = decodeScalar(a[i]);
+    switch (op) {
+        case Op::Add: return x + decodeScalar(b[i]);
+        case Op::Mul: return x * decodeScalar(b[i]);
+        case Op::Fma: return fmaToOddScalar(x, decodeScalar(b[i]), decodeScalar(c[i]));
+        default:      return 1.0 / std::sqrt(x);
+    }
+}
+
+// Sources rounded onto the bposit32 grid once per call.
+struct BpositSources {
+    std::vector<double> x, y, z, m;
+    size_t n = 0;
+};
+
+static thread_local BpositSources t_bposit;
+
+static void roundSources(ForceKernel kernel, const SourceSet& s, BpositSources& out) {
+    out.x.resize(s.n); out.y.resize(s.n); out.z.resize(s.n); out.m.resize(s.n);
+    bposit::round(kernel, s.x, out.x.data(), s.n);
+    bposit::round(kernel, s.y, out.y.data(), s.n);
+    bposit::round(kernel, s.z, out.z.data(), s.n);
+    bposit::round(kernel, s.m, out.m.data(), s.n);
+    out.n = s.n;
+}
+
+// Every step of the pair term is rounded onto the grid:
+//   d = R(x_j - x_i), r2 = R(R(R(dx dx) + dy dy) + dz dz),
+//   inv = R(1 / sqrt(r2)), f = R(m_j R(R(inv inv) inv)), a = R(a + f d)
+// with the sums of products as single-rounding fma.
+static void bpositScalar(const BpositSources& s, const TargetSet& t, size_t begin, size_t end, double g) {
+    for (size_t i = begin; i < end; ++i) {
+        const double xi = roundScalar(t.x[i]), yi = roundScalar(t.y[i]), zi = roundScalar(t.z[i]);
+        double ax = 0.0, ay = 0.0, az = 0.0;
+        for (size_t j = 0; j < s.n; ++j) {
+            const double dx = roundScalar(s.x[j] - xi);
+            const double dy = roundScalar(s.y[j] - yi);
+            const double dz = roundScalar(s.z[j] - zi);
+            double r2 = roundScalar(dx * dx);
+            r2 = roundScalar(fmaToOddScalar(dy, dy, r2));
+            r2 = roundScalar(fmaToOddScalar(dz, dz, r2));
+            if (r2 == 0.0) continue;
+
+            const double inv = roundScalar(1.0 / std::sqrt(r2));
+            const double f = roundScalar(s.m[j] * roundScalar(roundScalar(inv * inv) * inv));
+            ax = roundScalar(fmaToOddScalar(f, dx, ax));
+            ay = roundScalar(fmaToOddScalar(f, dy, ay));
+            az = roundScalar(fmaToOddScalar(f, dz, az));
+        }
+        t.ax[i] += roundScalar(g * ax);
+        t.ay[i] += roundScalar(g * ay);
+        t.az[i] += roundScalar(g * az);
+    }
+}
+
+#if NBODY_X86_SIMD
+
+// AVX2 has no 64-bit min/max; every operand here is below 2^63, so the
+// signed compare does.
+NBODY_TARGET_AVX2 static inline __m256i k256(uint64_t v) { return _mm256_set1_epi64x((long long)v); }
+NBODY_TARGET_AVX2 static inline __m256i min256(__m256i a, __m256i b) {
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+NBODY_TARGET_AVX2 static inline __m256i max256(__m256i a, __m256i b) {
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a));
+}
+
+NBODY_TARGET_AVX2 static inline __m256d roundAvx2(__m256d v) {
+    const __m256i one = k256(1);
+    const __m256i b = _mm256_castpd_si256(v);
+    const __m256i mag = _mm256_andnot_si256(k256(kSign), b);
+    const __m256i ex = min256(max256(_mm256_srli_epi64(mag, 52), k256(kExpLo)), k256(kExpHi));
+    const __m256i kb = _mm256_srli_epi64(_mm256_sub_epi64(ex, k256(kExpLo)), 5);
+    const __m256i run = max256(_mm256_sub_epi64(kb, k256(5)), _mm256_sub_epi64(k256(6), kb));
+    const __m256i drop = _mm256_add_epi64(min256(_mm256_add_epi64(run, one), k256(6)), k256(26));
+    const __m256i unit = _mm256_sllv_epi64(one, drop);
+    const __m256i lsb = _mm256_and_si256(_mm256_srlv_epi64(mag, drop), one);
+    __m256i r = _mm256_add_epi64(mag, _mm256_add_epi64(_mm256_sub_epi64(_mm256_srli_epi64(unit, 1), one), lsb));
+    r = _mm256_andnot_si256(_mm256_sub_epi64(unit, one), r);
+    r = min256(max256(r, k256(kMinPos)), k256(kMaxPos));
+    r = _mm256_or_si256(r, _mm256_and_si256(b, k256(kSign)));
+    r = _mm256_andnot_si256(_mm256_cmpeq_epi64(mag, _mm256_setzero_si256()), r);
+    r = _mm256_blendv_epi8(r, k256(kQNaN), _mm256_cmpgt_epi64(mag, k256(kInf - 1)));
+    return _mm256_castsi256_pd(r);
+}
+
+NBODY_TARGET_AVX2 static inline __m256d decodeAvx2(const uint32_t* in) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = k256(1);
+    const __m256i p = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)));
+    const __m256i neg = _mm256_srli_epi64(p, 31);
+    const __m256i negMask = _mm256_sub_epi64(zero, neg);
+    const __m256i mag = _mm256_sub_epi64(_mm256_xor_si256(p, negMask), negMask);
+    const __m256i x = _mm256_slli_epi64(mag, 33);
+    const __m256i ones = _mm256_cmpgt_epi64(zero, x);
+    const __m256i t = _mm256_srli_epi64(_mm256_xor_si256(x, ones), 57);
+    // t < 2^(7 - j) <=> the run is at least j bits; the compares give -1.
+    __m256i run = zero;
+    for (int j = 1; j <= 6; ++j) run = _mm256_sub_epi64(run, _mm256_cmpgt_epi64(k256(uint64_t(1) << (7 - j)), t));
+    const __m256i k = _mm256_blendv_epi8(_mm256_sub_epi64(zero, run), _mm256_sub_epi64(run, one), ones);
+    const __m256i z = _mm256_sllv_epi64(x, min256(_mm256_add_epi64(run, one), k256(6)));
+    const __m256i ex = _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(k, 5), _mm256_srli_epi64(z, 59)), k256(1023));
+    __m256i r = _mm256_or_si256(_mm256_slli_epi64(neg, 63), _mm256_slli_epi64(ex, 52));
+    r = _mm256_or_si256(r, _mm256_srli_epi64(_mm256_slli_epi64(z, 5), 12));
+    r = _mm256_andnot_si256(_mm256_cmpeq_epi64(p, zero), r);
+    r = _mm256_blendv_epi8(r, k256(kQNaN), _mm256_cmpeq_epi64(p, k256(kNaR)));
+    return _mm256_castsi256_pd(r);
+}
+
+NBODY_TARGET_AVX2 static inline void encodeAvx2(__m256d v, uint32_t* out) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = k256(1);
+    const __m256i b = _mm256_castpd_si256(roundAvx2(v));
+    const __m256i mag = _mm256_andnot_si256(k256(kSign), b);
+    const __m256i d = _mm256_sub_epi64(_mm256_srli_epi64(mag, 52), k256(kExpLo));
+    const __m256i kb = _mm256_srli_epi64(d, 5);
+    const __m256i run = max256(_mm256_sub_epi64(kb, k256(5)), _mm256_sub_epi64(k256(6), kb));
+    const __m256i rlen = min256(_mm256_add_epi64(run, one), k256(6));
+    const __m256i up = _mm256_sllv_epi64(_mm256_sub_epi64(_mm256_sllv_epi64(one, run), one), _mm256_sub_epi64(rlen, run));
+    const __m256i regime = _mm256_blendv_epi8(_mm256_sub_epi64(rlen, run), up, _mm256_cmpgt_epi64(kb, k256(5)));
+    __m256i body = _mm256_sllv_epi64(regime, _mm256_sub_epi64(k256(31), rlen));
+    body = _mm256_or_si256(body, _mm256_sllv_epi64(_mm256_and_si256(d, k256(31)), _mm256_sub_epi64(k256(26), rlen)));
+    body = _mm256_or_si256(body, _mm256_srlv_epi64(_mm256_and_si256(mag, k256(kManMask)), _mm256_add_epi64(rlen, k256(26))));
+    body = _mm256_blendv_epi8(body, _mm256_sub_epi64(zero, body), _mm256_cmpgt_epi64(zero, b));
+    body = _mm256_andnot_si256(_mm256_cmpeq_epi64(mag, zero), body);
+    body = _mm256_blendv_epi8(body, k256(kNaR), _mm256_cmpgt_epi64(mag, k256(kInf - 1)));
+    const __m256i packed = _mm256_permutevar8x32_epi32(body, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(packed));
+}
+
+NBODY_TARGET_AVX2 static inline __m256d fmaToOddAvx2(__m256d a, __m256d b, __m256d c) {
+    const __m256i one = k256(1);
+    const __m256d s = _mm256_mul_pd(a, b);
+    const __m256d hi = _mm256_add_pd(s, c);
+    const __m256d bb = _mm256_sub_pd(hi, s);
+    const __m256d lo = _mm256_add_pd(_mm256_sub_pd(s, _mm256_sub_pd(hi, bb)), _mm256_sub_pd(c, bb));
+    const __m256i h = _mm256_castpd_si256(hi);
+    // +1 moves away from zero when lo has the sign of hi, -1 towards it.
+    const __m256i step = _mm256_sub_epi64(one, _mm256_slli_epi64(_mm256_srli_epi64(_mm256_xor_si256(_mm256_castpd_si256(lo), h), 63), 1));
+    const __m256i inexact = _mm256_and_si256(_mm256_castpd_si256(_mm256_cmp_pd(lo, _mm256_setzero_pd(), _CMP_NEQ_UQ)),
+                                             _mm256_cmpeq_epi64(_mm256_and_si256(h, one), _mm256_setzero_si256()));
+    return _mm256_castsi256_pd(_mm256_add_epi64(h, _mm256_and_si256(inexact, step)));
+}
+
+NBODY_TARGET_AVX2 static size_t decodeArrayAvx2(const uint32_t* in, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, decodeAvx2(in + i));
+    return i;
+}
+
+NBODY_TARGET_AVX2 static size_t encodeArrayAvx2(const double* in, uint32_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) encodeAvx2(_mm256_loadu_pd(in + i), out + i);
+    return i;
+}
+
+NBODY_TARGET_AVX2 static size_t roundArrayAvx2(const double* in, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, roundAvx2(_mm256_loadu_pd(in + i)));
+    return i;
+}
+
+NBODY_TARGET_AVX2 static size_t applyAvx2(Op op, const uint32_t* a, const uint32_t* b, const uint32_t* c,
+                                          uint32_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d x = decodeAvx2(a + i);
+        __m256d r;
+        switch (op) {
+            case Op::Add: r = _mm256_add_pd(x, decodeAvx2(b + i)); break;
+            case Op::Mul: r = _mm256_mul_pd(x, decodeAvx2(b + i)); break;
+            case Op::Fma: r = fmaToOddAvx2(x, decodeAvx2(b + i), decodeAvx2(c + i)); break;
+            default:      r = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(x)); break;
+        }
+        encodeAvx2(r, out + i);
+    }
+    return i;
+}
+
+// R target vectors per pass against one broadcast source at a time, so
+// each lane runs exactly the scalar sequence and the R rounding chains
+// overlap instead of waiting on each other.
+template <size_t R>
+NBODY_TARGET_AVX2 static void bpositRowsAvx2(const BpositSources& s, const TargetSet& t, size_t i, double g) {
+    const __m256d zero = _mm256_setzero_pd();
+    __m256d xi[R], yi[R], zi[R], ax[R], ay[R], az[R];
+    NBODY_UNROLL_ROWS
+    for (size_t r = 0; r < R; ++r) {
+        xi[r] = roundAvx2(_mm256_loadu_pd(t.x + i + 4 * r));
+        yi[r] = roundAvx2(_mm256_loadu_pd(t.y + i + 4 * r));
+        zi[r] = roundAvx2(_mm256_loadu_pd(t.z + i + 4 * r));
+        ax[r] = ay[r] = az[r] = zero;
+    }
+    for (size_t j = 0; j < s.n; ++j) {
+        const __m256d xj = _mm256_set1_pd(s.x[j]), yj = _mm256_set1_pd(s.y[j]);
+        const __m256d zj = _mm256_set1_pd(s.z[j]), mj = _mm256_set1_pd(s.m[j]);
+        NBODY_UNROLL_ROWS
+        for (size_t r = 0; r < R; ++r) {
+            const __m256d dx = roundAvx2(_mm256_sub_pd(xj, xi[r]));
+            const __m256d dy = roundAvx2(_mm256_sub_pd(yj, yi[r]));
+            const __m256d dz = roundAvx2(_mm256_sub_pd(zj, zi[r]));
+            __m256d r2 = roundAvx2(_mm256_mul_pd(dx, dx));
+            r2 = roundAvx2(fmaToOddAvx2(dy, dy, r2));
+            r2 = roundAvx2(fmaToOddAvx2(dz, dz, r2));
+            const __m256d inv = roundAvx2(_mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(r2)));
+            __m256d f = roundAvx2(_mm256_mul_pd(roundAvx2(_mm256_mul_pd(inv, inv)), inv));
+            f = roundAvx2(_mm256_mul_pd(mj, f));
+            f = _mm256_and_pd(_mm256_cmp_pd(r2, zero, _CMP_NEQ_UQ), f);
+            ax[r] = roundAvx2(fmaToOddAvx2(f, dx, ax[r]));
+            ay[r] = roundAvx2(fmaToOddAvx2(f, dy, ay[r]));
+            az[r] = roundAvx2(fmaToOddAvx2(f, dz, az[r]));
+        }
+    }
+    const __m256d gv = _mm256_set1_pd(g);
+    NBODY_UNROLL_ROWS
+    for (size_t r = 0; r < R; ++r) {
+        double* ox = t.ax + i + 4 * r;
+        double* oy = t.ay + i + 4 * r;
+        double* oz = t.az + i + 4 * r;
+        _mm256_storeu_pd(ox, _mm256_add_pd(_mm256_loadu_pd(ox), roundAvx2(_mm256_mul_pd(gv, ax[r]))));
+        _mm256_storeu_pd(oy, _mm256_add_pd(_mm256_loadu_pd(oy), roundAvx2(_mm256_mul_pd(gv, ay[r]))));
+        _mm256_storeu_pd(oz, _mm256_add_pd(_mm256_loadu_pd(oz), roundAvx2(_mm256_mul_pd(gv, az[r]))));
+    }
+}
+
+NBODY_TARGET_AVX2 static size_t bpositAvx2(const BpositSources& s, const TargetSet& t, size_t begin, size_t end,
+                                           double g) {
+    size_t i = begin;
+    for (; i + 4 * kRows <= end; i += 4 * kRows) bpositRowsAvx2<kRows>(s, t, i, g);
+    for (; i + 4 <= end; i += 4) bpositRowsAvx2<1>(s, t, i, g);
+    return i;
+}
+
+NBODY_TARGET_AVX512 static inline __m512i k512(uint64_t v) { return _mm512_set1_epi64((long long)v); }
+
+NBODY_TARGET_AVX512 static inline __m512d roundAvx512(__m512d v) {
+    const __m512i one = k512(1);
+    const __m512i b = _mm512_castpd_si512(v);
+    const __m512i mag = _mm512_andnot_si512(k512(kSign), b);
+    const __m512i ex = _mm512_min_epu64(_mm512_max_epu64(_mm512_srli_epi64(mag, 52), k512(kExpLo)), k512(kExpHi));
+    const __m512i kb = _mm512_srli_epi64(_mm512_sub_epi64(ex, k512(kExpLo)), 5);
+    const __m512i run = _mm512_max_epi64(_mm512_sub_epi64(kb, k512(5)), _mm512_sub_epi64(k512(6), kb));
+    const __m512i drop = _mm512_add_epi64(_mm512_min_epi64(_mm512_add_epi64(run, one), k512(6)), k512(26));
+    const __m512i unit = _mm512_sllv_epi64(one, drop);
+    const __m512i lsb = _mm512_and_si512(_mm512_srlv_epi64(mag, drop), one);
+    __m512i r = _mm512_add_epi64(mag, _mm512_add_epi64(_mm512_sub_epi64(_mm512_srli_epi64(unit, 1), one), lsb));
+    r = _mm512_andnot_si512(_mm512_sub_epi64(unit, one), r);
+    r = _mm512_min_epu64(_mm512_max_epu64(r, k512(kMinPos)), k512(kMaxPos));
+    r = _mm512_or_si512(r, _mm512_and_si512(b, k512(kSign)));
+    r = _mm512_maskz_mov_epi64(_mm512_test_epi64_mask(mag, mag), r);
+    r = _mm512_mask_mov_epi64(r, _mm512_cmpge_epu64_mask(mag, k512(kInf)), k512(kQNaN));
+    return _mm512_castsi512_pd(r);
+}
+
+NBODY_TARGET_AVX512 static inline __m512d decodeAvx512(const uint32_t* in) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i one = k512(1);
+    const __m512i p = _mm512_cvtepu32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in)));
+    const __m512i neg = _mm512_srli_epi64(p, 31);
+    const __m512i negMask = _mm512_sub_epi64(zero, neg);
+    const __m512i mag = _mm512_sub_epi64(_mm512_xor_si512(p, negMask), negMask);
+    const __m512i x = _mm512_slli_epi64(mag, 33);
+    const __mmask8 ones = _mm512_cmplt_epi64_mask(x, zero);
+    const __m512i t = _mm512_srli_epi64(_mm512_xor_si512(x, _mm512_srai_epi64(x, 63)), 57);
+    __m512i run = zero;
+    for (int j = 1; j <= 6; ++j)
+        run = _mm512_mask_add_epi64(run, _mm512_cmplt_epu64_mask(t, k512(uint64_t(1) << (7 - j))), run, one);
+    const __m512i k = _mm512_mask_blend_epi64(ones, _mm512_sub_epi64(zero, run), _mm512_sub_epi64(run, one));
+    const __m512i z = _mm512_sllv_epi64(x, _mm512_min_epi64(_mm512_add_epi64(run, one), k512(6)));
+    const __m512i ex = _mm512_add_epi64(_mm512_add_epi64(_mm512_slli_epi64(k, 5), _mm512_srli_epi64(z, 59)), k512(1023));
+    __m512i r = _mm512_or_si512(_mm512_slli_epi64(neg, 63), _mm512_slli_epi64(ex, 52));
+    r = _mm512_or_si512(r, _mm512_srli_epi64(_mm512_slli_epi64(z, 5), 12));
+    r = _mm512_maskz_mov_epi64(_mm512_test_epi64_mask(p, p), r);
+    r = _mm512_mask_mov_epi64(r, _mm512_cmpeq_epi64_mask(p, k512(kNaR)), k512(kQNaN));
+    return _mm512_castsi512_pd(r);
+}
+
+NBODY_TARGET_AVX512 static inline void encodeAvx512(__m512d v, uint32_t* out) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i one = k512(1);
+    const __m512i b = _mm512_castpd_si512(roundAvx512(v));
+    const __m512i mag = _mm512_andnot_si512(k512(kSign), b);
+    const __m512i d = _mm512_sub_epi64(_mm512_srli_epi64(mag, 52), k512(kExpLo));
+    const __m512i kb = _mm512_srli_epi64(d, 5);
+    const __m512i run = _mm512_max_epi64(_mm512_sub_epi64(kb, k512(5)), _mm512_sub_epi64(k512(6), kb));
+    const __m512i rlen = _mm512_min_epi64(_mm512_add_epi64(run, one), k512(6));
+    const __m512i up = _mm512_sllv_epi64(_mm512_sub_epi64(_mm512_sllv_epi64(one, run), one), _mm512_sub_epi64(rlen, run));
+    const __m512i regime = _mm512_mask_blend_epi64(_mm512_cmpgt_epi64_mask(kb, k512(5)), _mm512_sub_epi64(rlen, run), up);
+    __m512i body = _mm512_sllv_epi64(regime, _mm512_sub_epi64(k512(31), rlen));
+    body = _mm512_or_si512(body, _mm512_sllv_epi64(_mm512_and_si512(d, k512(31)), _mm512_sub_epi64(k512(26), rlen)));
+    body = _mm512_or_si512(body, _mm512_srlv_epi64(_mm512_and_si512(mag, k512(kManMask)), _mm512_add_epi64(rlen, k512(26))));
+    body = _mm512_mask_sub_epi64(body, _mm512_cmplt_epi64_mask(b, zero), zero, body);
+    body = _mm512_maskz_mov_epi64(_mm512_test_epi64_mask(mag, mag), body);
+    body = _mm512_mask_mov_epi64(body, _mm512_cmpge_epu64_mask(mag, k512(kInf)), k512(kNaR));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm512_cvtepi64_epi32(body));
+}
+
+NBODY_TARGET_AVX512 static inline __m512d fmaToOddAvx512(__m512d a, __m512d b, __m512d c) {
+    const __m512i one = k512(1);
+    const __m512d s = _mm512_mul_pd(a, b);
+    const __m512d hi = _mm512_add_pd(s, c);
+    const __m512d bb = _mm512_sub_pd(hi, s);
+    const __m512d lo = _mm512_add_pd(_mm512_sub_pd(s, _mm512_sub_pd(hi, bb)), _mm512_sub_pd(c, bb));
+    const __m512i h = _mm512_castpd_si512(hi);
+    const __m512i step = _mm512_sub_epi64(one, _mm512_slli_epi64(_mm512_srli_epi64(_mm512_xor_si512(_mm512_castpd_si512(lo), h), 63), 1));
+    const __mmask8 inexact = _mm512_cmp_pd_mask(lo, _mm512_setzero_pd(), _CMP_NEQ_UQ) & _mm512_testn_epi64_mask(h, one);
+    return _mm512_castsi512_pd(_mm512_mask_add_epi64(h, inexact, h, step));
+}
+
+NBODY_TARGET_AVX512 static size_t decodeArrayAvx512(const uint32_t* in, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) _mm512_storeu_pd(out + i, decodeAvx512(in + i));
+    return i;
+}
+
+NBODY_TARGET_AVX512 static size_t encodeArrayAvx512(const double* in, uint32_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) encodeAvx512(_mm512_loadu_pd(in + i), out + i);
+    return i;
+}
+
+NBODY_TARGET_AVX512 static size_t roundArrayAvx512(const double* in, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) _mm512_storeu_pd(out + i, roundAvx512(_mm512_loadu_pd(in + i)));
+    return i;
+}
+
+NBODY_TARGET_AVX512 static size_t applyAvx512(Op op, const uint32_t* a, const uint32_t* b, const uint32_t* c,
+                                              uint32_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d x = decodeAvx512(a + i);
+        __m512d r;
+        switch (op) {
+            case Op::Add: r = _mm512_add_pd(x, decodeAvx512(b + i)); break;
+            case Op::Mul: r = _mm512_mul_pd(x, decodeAvx512(b + i)); break;
+            case Op::Fma: r = fmaToOddAvx512(x, decodeAvx512(b + i), decodeAvx512(c + i)); break;
+            default:      r = _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_sqrt_pd(x)); break;
+        }
+        encodeAvx512(r, out + i);
+    }
+    return i;
+}
+
+template <size_t R>
+NBODY_TARGET_AVX512 static void bpositRowsAvx512(const BpositSources& s, const TargetSet& t, size_t i, double g) {
+    const __m512d zero = _mm512_setzero_pd();
+    __m512d xi[R], yi[R], zi[R], ax[R], ay[R], az[R];
+    NBODY_UNROLL_ROWS
+    for (size_t r = 0; r < R; ++r) {
+        xi[r] = roundAvx512(_mm512_loadu_pd(t.x + i + 8 * r));
+        yi[r] = roundAvx512(_mm512_loadu_pd(t.y + i + 8 * r));
+        zi[r] = roundAvx512(_mm512_loadu_pd(t.z + i + 8 * r));
+        ax[r] = ay[r] = az[r] = zero;
+    }
+    for (size_t j = 0; j < s.n; ++j) {
+        const __m512d xj = _mm512_set1_pd(s.x[j]), yj = _mm512_set1_pd(s.y[j]);
+        const __m512d zj = _mm512_set1_pd(s.z[j]), mj = _mm512_set1_pd(s.m[j]);
+        NBODY_UNROLL_ROWS
+        for (size_t r = 0; r < R; ++r) {
+            const __m512d dx = roundAvx512(_mm512_sub_pd(xj, xi[r]));
+            const __m512d dy = roundAvx512(_mm512_sub_pd(yj, yi[r]));
+            const __m512d dz = roundAvx512(_mm512_sub_pd(zj, zi[r]));
+            __m512d r2 = roundAvx512(_mm512_mul_pd(dx, dx));
+            r2 = roundAvx512(fmaToOddAvx512(dy, dy, r2));
+            r2 = roundAvx512(fmaToOddAvx512(dz, dz, r2));
+            const __m512d inv = roundAvx512(_mm512_div_pd(_mm512_set1_pd(1.0), _mm512_sqrt_pd(r2)));
+            __m512d f = roundAvx512(_mm512_mul_pd(roundAvx512(_mm512_mul_pd(inv, inv)), inv));
+            f = roundAvx512(_mm512_mul_pd(mj, f));
+            f = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(r2, zero, _CMP_NEQ_UQ), f);
+            ax[r] = roundAvx512(fmaToOddAvx512(f, dx, ax[r]));
+            ay[r] = roundAvx512(fmaToOddAvx512(f, dy, ay[r]));
+            az[r] = roundAvx512(fmaToOddAvx512(f, dz, az[r]));
+        }
+    }
+    const __m512d gv = _mm512_set1_pd(g);
+    NBODY_UNROLL_ROWS
+    for (size_t r = 0; r < R; ++r) {
+        double* ox = t.ax + i + 8 * r;
+        double* oy = t.ay + i + 8 * r;
+        double* oz = t.az + i + 8 * r;
+        _mm512_storeu_pd(ox, _mm512_add_pd(_mm512_loadu_pd(ox), roundAvx512(_mm512_mul_pd(gv, ax[r]))));
+        _mm512_storeu_pd(oy, _mm512_add_pd(_mm512_loadu_pd(oy), roundAvx512(_mm512_mul_pd(gv, ay[r]))));
+        _mm512_storeu_pd(oz, _mm512_add_pd(_mm512_loadu_pd(oz), roundAvx512(_mm512_mul_pd(gv, az[r]))));
+    }
+}
+
+NBODY_TARGET_AVX512 static size_t bpositAvx512(const BpositSources& s, const TargetSet& t, size_t begin, size_t end,
+                                               double g) {
+    size_t i = begin;
+    for (; i + 8 * kRows <= end; i += 8 * kRows) bpositRowsAvx512<kRows>(s, t, i, g);
+    for (; i + 8 <= end; i += 8) bpositRowsAvx512<1>(s, t, i, g);
+    return i;
+}
+
+#endif
+
+// Runs the widest path over whole vectors and finishes the tail in scalar.
+static void apply(ForceKernel kernel, Op op, const uint32_t* a, const uint32_t* b, const uint32_t* c,
+                  uint32_t* out, size_t n) {
+    size_t i = 0;
+    switch (kernels::resolve(kernel)) {
+#if NBODY_X86_SIMD
+        case ForceKernel::Avx512: i = applyAvx512(op, a, b, c, out, n); break;
+        case ForceKernel::Avx2:   i = applyAvx2(op, a, b, c, out, n); break;
+#endif
+        default: break;
+    }
+    for (; i < n; ++i) out[i] = encodeScalar(applyScalar(op, a, b, c, i));
+}
+
+namespace bposit {
+
+void decode(ForceKernel kernel, const uint32_t* in, double* out, size_t n) {
+    size_t i = 0;
+    switch (kernels::resolve(kernel)) {
+#if NBODY_X86_SIMD
+        case ForceKernel::Avx512: i = decodeArrayAvx512(in, out, n); break;
+        case ForceKernel::Avx2:   i = decodeArrayAvx2(in, out, n); break;
+#endif
+        default: break;
+    }
+    for (; i < n; ++i) out[i] = decodeScalar(in[i]);
+}
+
+void encode(ForceKernel kernel, const double* in, uint32_t* out, size_t n) {
+    size_t i = 0;
+    switch (kernels::resolve(kernel)) {
+#if NBODY_X86_SIMD
+        case ForceKernel::Avx512: i = encodeArrayAvx512(in, out, n); break;
+        case ForceKernel::Avx2:   i = encodeArrayAvx2(in, out, n); break;
+#endif
+        default: break;
+    }
+    for (; i < n; ++i) out[i] = encodeScalar(in[i]);
+}
+
+void round(ForceKernel kernel, const double* in, double* out, size_t n) {
+    size_t i = 0;
+    switch (kernels::resolve(kernel)) {
+#if NBODY_X86_SIMD
+        case ForceKernel::Avx512: i = roundArrayAvx512(in, out, n); break;
+        case ForceKernel::Avx2:   i = roundArrayAvx2(in, out, n); break;
+#endif
+        default: break;
+    }
+    for (; i < n; ++i) out[i] = roundScalar(in[i]);
+}
+
+void add(ForceKernel kernel, const uint32_t* a, const uint32_t* b, uint32_t* out, size_t n) {
+    apply(kernel, Op::Add, a, b, nullptr, out, n);
+}
+
+void mul(ForceKernel kernel, const uint32_t* a, const uint32_t* b, uint32_t* out, size_t n) {
+    apply(kernel, Op::Mul, a, b, nullptr, out, n);
+}
+
+void fma(ForceKernel kernel, const uint32_t* a, const uint32_t* b, const uint32_t* c, uint32_t* out, size_t n) {
+    apply(kernel, Op::Fma, a, b, c, out, n);
+}
+
+void rsqrt(ForceKernel kernel, const uint32_t* a, uint32_t* out, size_t n) {
+    apply(kernel, Op::Rsqrt, a, nullptr, nullptr, out, n);
+}
+
+}
+
+namespace kernels {
+
+void accumulateBposit(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                      size_t begin, size_t end, double G) {
+    if (src.n == 0 || begin >= end) return;
+    kernel = resolve(kernel);
+    BpositSources& s = t_bposit;
+    roundSources(kernel, src, s);
+    const double g = roundScalar(G);
+
+    size_t i = begin;
+    switch (kernel) {
+#if NBODY_X86_SIMD
+        case ForceKernel::Avx512: i = bpositAvx512(s, dst, begin, end, g); break;
+        case ForceKernel::Avx2:   i = bpositAvx2(s, dst, begin, end, g); break;
+#endif
+        default: break;
+    }
+    bpositScalar(s, dst, i, end, g);
+}
+
+}
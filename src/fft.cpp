@@ -0,0 +1,56 @@
+// src/fft.cpp
+#include "physics/fft.hpp"
+#include <cmath>
+#include <utility>
+
+Fft::Fft(size_t n) {
+    int bits = 0;
+    while ((size_t(1) << bits) < n) ++bits;
+    n = size_t(1) << bits;
+    m_n = n;
+    m_reverse.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        size_t r = 0;
+        for (int b = 0; b < bits; ++b)
+            if (i & (size_t(1) << b)) r |= size_t(1) << (bits - 1 - b);
+        m_reverse[i] = r;
+    }
+
+    const double pi = std::acos(-1.0);
+    m_twiddle.resize(n / 2);
+    for (size_t k = 0; k < n / 2; ++k)
+        m_twiddle[k] = std::polar(1.0, -2.0 * pi * double(k) / double(n));
+}
+
+void Fft::forward(std::complex<double>* data) const {
+    transform(data, false);
+}
+
+void Fft::inverse(std::complex<double>* data) const {
+    transform(data, true);
+}
+
+void Fft::transform(std::complex<double>* data, bool inverse) const {
+    const size_t n = m_n;
+    for (size_t i = 0; i < n; ++i)
+        if (i < m_reverse[i]) std::swap(data[i], data[m_reverse[i]]);
+
+    // Iterative Cooley-Tukey butterflies; the inverse uses conjugate twiddles.
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const size_t half = len / 2;
+        const size_t step = n / len;
+        for (size_t start = 0; start < n; start += len) {
+            for (size_t k = 0; k < half; ++k) {
+                std::complex<double> w = m_twiddle[k * step];
+                if (inverse) w = std::conj(w);
+                // Written out: operator* on std::complex checks for NaN/inf.
+                const std::complex<double> a = data[start + k];
+                const std::complex<double> u = data[start + k + half];
+                const std::complex<double> b(u.real() * w.real() - u.imag() * w.imag(),
+                                             u.real() * w.imag() + u.imag() * w.real());
+                data[start + k] = a + b;
+                data[start + k + half] = a - b;
+            }
+        }
+    }
+}
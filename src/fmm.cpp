@@ -0,0 +1,446 @@
+// src/fmm.cpp
+#include "physics/fmm.hpp"
+#include <algorithm>
+#include <cmath>
+
+static constexpr int kMaxDepth = 48;
+
+int FmmSolver::termIndex(int a, int b, int c) const {
+    const int p1 = m_p + 1;
+    return m_index[(a * p1 + b) * p1 + c];
+}
+
+void FmmSolver::prepareOrder(int order) {
+    if (order == m_p) return;
+    m_p = order;
+    const int p = order;
+    const int p1 = p + 1;
+
+    // Terms sorted by total degree, so "degree <= k" is always a prefix.
+    m_terms.clear();
+    m_index.assign(size_t(p1) * p1 * p1, -1);
+    for (int n = 0; n <= p; ++n)
+        for (int a = n; a >= 0; --a)
+            for (int b = n - a; b >= 0; --b) {
+                int c = n - a - b;
+                m_index[(a * p1 + b) * p1 + c] = int(m_terms.size());
+                m_terms.push_back({a, b, c, {-1, -1, -1}});
+            }
+    for (Term& T : m_terms) {
+        if (T.a > 0) T.dec[0] = termIndex(T.a - 1, T.b, T.c);
+        if (T.b > 0) T.dec[1] = termIndex(T.a, T.b - 1, T.c);
+        if (T.c > 0) T.dec[2] = termIndex(T.a, T.b, T.c - 1);
+    }
+
+    const int nt = int(m_terms.size());
+    std::vector<double> fact(p1 + 1, 1.0);
+    for (int i = 1; i <= p1; ++i) fact[i] = fact[i - 1] * i;
+    m_invFact.resize(nt);
+    for (int t = 0; t < nt; ++t)
+        m_invFact[t] = 1.0 / (fact[m_terms[t].a] * fact[m_terms[t].b] * fact[m_terms[t].c]);
+
+    m_m2m.clear();
+    m_l2l.clear();
+    m_m2lPairs.clear();
+    for (int t = 0; t < nt; ++t) {
+        const Term& T = m_terms[t];
+        for (int s = 0; s < nt; ++s) {
+            const Term& S = m_terms[s];
+            // M2M: parent alpha = T gathers child beta = S <= T.
+            if (S.a <= T.a && S.b <= T.b && S.c <= T.c)
+                m_m2m.push_back({t, s, termIndex(T.a - S.a, T.b - S.b, T.c - S.c), 1.0});
+            // L2L: child gamma = T gathers parent beta = S >= T. The binomial
+            // C(beta, gamma) times (beta - gamma)! from the shift monomial is beta!/gamma!.
+            if (S.a >= T.a && S.b >= T.b && S.c >= T.c)
+                m_l2l.push_back({t, s, termIndex(S.a - T.a, S.b - T.b, S.c - T.c),
+                                 m_invFact[t] / m_invFact[s]});
+            // M2L: local beta = T gathers multipole alpha = S, |alpha| + |beta| <= p.
+            int na = S.a + S.b + S.c, nb = T.a + T.b + T.c;
+            if (na + nb <= p) {
+                double sign = (na % 2) ? -1.0 : 1.0;
+                m_m2lPairs.push_back({t, s, termIndex(S.a + T.a, S.b + T.b, S.c + T.c),
+                                      sign * m_invFact[t]});
+            }
+        }
+    }
+}
+
+void FmmSolver::buildTree(const SourceSet& bodies) {
+    m_src = bodies;
+    m_nodes.clear();
+    m_leaves.clear();
+    for (auto& level : m_levels) level.clear();
+    m_order.resize(bodies.n);
+    m_sortScratch.resize(bodies.n);
+    m_x.resize(bodies.n); m_y.resize(bodies.n); m_z.resize(bodies.n); m_m.resize(bodies.n);
+    m_ax.resize(bodies.n); m_ay.resize(bodies.n); m_az.resize(bodies.n);
+    if (bodies.n == 0) return;
+
+    double lo[3] = {bodies.x[0], bodies.y[0], bodies.z[0]};
+    double hi[3] = {lo[0], lo[1], lo[2]};
+    for (size_t i = 0; i < bodies.n; ++i) {
+        m_order[i] = uint32_t(i);
+        lo[0] = std::min(lo[0], bodies.x[i]); hi[0] = std::max(hi[0], bodies.x[i]);
+        lo[1] = std::min(lo[1], bodies.y[i]); hi[1] = std::max(hi[1], bodies.y[i]);
+        lo[2] = std::min(lo[2], bodies.z[i]); hi[2] = std::max(hi[2], bodies.z[i]);
+    }
+    double half = 0.5 * std::max({hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]});
+    half = half > 0.0 ? half * (1.0 + 1e-9) : 1.0;
+    for (int a = 0; a < 3; ++a) m_origin[a] = 0.5 * (lo[a] + hi[a]);
+    m_scale = 0.5 / half;
+
+    // Scaled copies are filled in tree order once the partition is done,
+    // but the build itself needs them for centres and radii.
+    for (size_t i = 0; i < bodies.n; ++i) {
+        m_x[i] = (bodies.x[i] - m_origin[0]) * m_scale;
+        m_y[i] = (bodies.y[i] - m_origin[1]) * m_scale;
+        m_z[i] = (bodies.z[i] - m_origin[2]) * m_scale;
+        m_m[i] = bodies.m[i];
+    }
+    buildNode(0, uint32_t(bodies.n), 0.0, 0.0, 0.0, 0.5, 0);
+
+    // Reorder the scaled columns into tree order.
+    AlignedVector<double>* cols[4] = {&m_x, &m_y, &m_z, &m_m};
+    for (auto* col : cols) {
+        for (size_t k = 0; k < bodies.n; ++k) m_ax[k] = (*col)[m_order[k]];
+        std::copy(m_ax.begin(), m_ax.end(), col->begin());
+    }
+}
+
+int32_t FmmSolver::buildNode(uint32_t begin, uint32_t end, double ox, double oy, double oz,
+                             double half, int level) {
+    const int32_t index = int32_t(m_nodes.size());
+    m_nodes.emplace_back();
+    {
+        Node& node = m_nodes[index];
+        node.begin = begin;
+        node.end = end;
+        node.level = level;
+        std::fill(std::begin(node.child), std::end(node.child), -1);
+        node.leaf = (end - begin) <= m_params.leafSize || level >= kMaxDepth;
+    }
+    if (int(m_levels.size()) <= level) m_levels.resize(level + 1);
+    m_levels[level].push_back(index);
+
+    if (m_nodes[index].leaf) {
+        m_leaves.push_back(index);
+    } else {
+        uint32_t count[8] = {};
+        auto octant = [&](uint32_t i) {
+            return (m_x[i] >= ox) | ((m_y[i] >= oy) << 1) | ((m_z[i] >= oz) << 2);
+        };
+        for (uint32_t k = begin; k < end; ++k) ++count[octant(m_order[k])];
+        uint32_t start[8];
+        uint32_t offset = begin;
+        for (int o = 0; o < 8; ++o) { start[o] = offset; offset += count[o]; }
+        uint32_t fill[8];
+        std::copy(std::begin(start), std::end(start), fill);
+        for (uint32_t k = begin; k < end; ++k) {
+            uint32_t i = m_order[k];
+            m_sortScratch[fill[octant(i)]++] = i;
+        }
+        std::copy(m_sortScratch.begin() + begin, m_sortScratch.begin() + end, m_order.begin() + begin);
+
+        const double h = 0.5 * half;
+        for (int o = 0; o < 8; ++o) {
+            if (count[o] == 0) continue;
+            int32_t c = buildNode(start[o], start[o] + count[o],
+                                  ox + ((o & 1) ? h : -h), oy + ((o & 2) ? h : -h),
+                                  oz + ((o & 4) ? h : -h), h, level + 1);
+            m_nodes[index].child[o] = c;
+        }
+    }
+
+    Node& node = m_nodes[index];
+    double m = 0.0, mx = 0.0, my = 0.0, mz = 0.0;
+    for (uint32_t k = begin; k < end; ++k) {
+        uint32_t i = m_order[k];
+        m += m_m[i];
+        mx += m_m[i] * m_x[i];
+        my += m_m[i] * m_y[i];
+        mz += m_m[i] * m_z[i];
+    }
+    if (m > 0.0) {
+        node.c[0] = mx / m; node.c[1] = my / m; node.c[2] = mz / m;
+    } else {
+        node.c[0] = ox; node.c[1] = oy; node.c[2] = oz;
+    }
+    double r2 = 0.0;
+    for (uint32_t k = begin; k < end; ++k) {
+        uint32_t i = m_order[k];
+        double dx = m_x[i] - node.c[0], dy = m_y[i] - node.c[1], dz = m_z[i] - node.c[2];
+        r2 = std::max(r2, dx * dx + dy * dy + dz * dz);
+    }
+    node.radius = std::sqrt(r2);
+    return index;
+}
+
+void FmmSolver::walk(int32_t a, int32_t b) {
+    const Node& A = m_nodes[a];
+    const Node& B = m_nodes[b];
+
+    if (a == b) {
+        if (A.leaf) {
+            m_p2p.emplace_back(a, a);
+            return;
+        }
+        for (int i = 0; i < 8; ++i) {
+            if (A.child[i] < 0) continue;
+            for (int j = i; j < 8; ++j)
+                if (A.child[j] >= 0) walk(A.child[i], A.child[j]);
+        }
+        return;
+    }
+
+    double dx = A.c[0] - B.c[0], dy = A.c[1] - B.c[1], dz = A.c[2] - B.c[2];
+    double dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+    // Small leaf pairs are cheaper summed directly than through M2L.
+    const bool bothLeaves = A.leaf && B.leaf;
+    if (A.radius + B.radius < m_params.theta * dist &&
+        !(bothLeaves && size_t(A.end - A.begin) * (B.end - B.begin) < m_m2lPairs.size())) {
+        m_m2l.emplace_back(b, a);
+        m_m2l.emplace_back(a, b);
+        return;
+    }
+    if (bothLeaves) {
+        m_p2p.emplace_back(a, b);
+        m_p2p.emplace_back(b, a);
+        return;
+    }
+    if (!A.leaf && (B.leaf || A.radius >= B.radius)) {
+        for (int i = 0; i < 8; ++i)
+            if (A.child[i] >= 0) walk(A.child[i], b);
+    } else {
+        for (int i = 0; i < 8; ++i)
+            if (B.child[i] >= 0) walk(a, B.child[i]);
+    }
+}
+
+// Scaled monomials d^alpha / alpha! for every term.
+static void taylorMonomials(int p, const std::vector<double>& invFact, const std::vector<int>& index,
+                            double dx, double dy, double dz, double* out) {
+    double px[64], py[64], pz[64];
+    px[0] = py[0] = pz[0] = 1.0;
+    for (int i = 1; i <= p; ++i) {
+        px[i] = px[i - 1] * dx;
+        py[i] = py[i - 1] * dy;
+        pz[i] = pz[i - 1] * dz;
+    }
+    const int p1 = p + 1;
+    for (int a = 0; a <= p; ++a)
+        for (int b = 0; a + b <= p; ++b)
+            for (int c = 0; a + b + c <= p; ++c) {
+                int t = index[(a * p1 + b) * p1 + c];
+                out[t] = px[a] * py[b] * pz[c] * invFact[t];
+            }
+}
+
+void FmmSolver::p2m(int32_t leaf) {
+    const Node& node = m_nodes[leaf];
+    const size_t nt = m_terms.size();
+    double* M = m_multipole.data() + size_t(leaf) * nt;
+    double mono[1024];
+    for (uint32_t k = node.begin; k < node.end; ++k) {
+        taylorMonomials(m_p, m_invFact, m_index,
+                        m_x[k] - node.c[0], m_y[k] - node.c[1], m_z[k] - node.c[2], mono);
+        for (size_t t = 0; t < nt; ++t) M[t] += m_m[k] * mono[t];
+    }
+}
+
+void FmmSolver::m2m(int32_t parent) {
+    const Node& node = m_nodes[parent];
+    const size_t nt = m_terms.size();
+    double* M = m_multipole.data() + size_t(parent) * nt;
+    double shift[1024];
+    for (int o = 0; o < 8; ++o) {
+        if (node.child[o] < 0) continue;
+        const Node& c = m_nodes[node.child[o]];
+        const double* Mc = m_multipole.data() + size_t(node.child[o]) * nt;
+        taylorMonomials(m_p, m_invFact, m_index,
+                        c.c[0] - node.c[0], c.c[1] - node.c[1], c.c[2] - node.c[2], shift);
+        for (const ShiftEntry& e : m_m2m) M[e.target] += Mc[e.source] * shift[e.offset];
+    }
+}
+
+void FmmSolver::m2l(int32_t target, int32_t source, double* local, double* deriv) const {
+    const Node& B = m_nodes[target];
+    const Node& A = m_nodes[source];
+    const size_t nt = m_terms.size();
+    const double X = B.c[0] - A.c[0];
+    const double Y = B.c[1] - A.c[1];
+    const double Z = B.c[2] - A.c[2];
+    const double R[3] = {X, Y, Z};
+
+    // Cartesian derivatives of 1/r up to order p with the McMurchie-Davidson
+    // recurrence: R(n)_000 = (-1)^n (2n-1)!! / r^(2n+1), then
+    // R(n)_{t+1,u,v} = t R(n+1)_{t-1,u,v} + X R(n+1)_{t,u,v} (same for u, v).
+    const int p = m_p;
+    double* prev = deriv;
+    double* cur = deriv + nt;
+    const double invR2 = 1.0 / (X * X + Y * Y + Z * Z);
+    const double invR = std::sqrt(invR2);
+    double base[64];
+    base[0] = invR;
+    for (int n = 1; n <= p; ++n) base[n] = -base[n - 1] * double(2 * n - 1) * invR2;
+
+    for (int n = p; n >= 0; --n) {
+        const int k = p - n;
+        const size_t count = size_t(k + 1) * (k + 2) * (k + 3) / 6;
+        cur[0] = base[n];
+        for (size_t t = 1; t < count; ++t) {
+            const Term& T = m_terms[t];
+            const int axis = T.a > 0 ? 0 : (T.b > 0 ? 1 : 2);
+            const int power = axis == 0 ? T.a : (axis == 1 ? T.b : T.c);
+            const int d1 = T.dec[axis];
+            double v = R[axis] * prev[d1];
+            if (power > 1) v += (power - 1) * prev[m_terms[d1].dec[axis]];
+            cur[t] = v;
+        }
+        std::swap(prev, cur);
+    }
+    const double* D = prev;
+
+    const double* M = m_multipole.data() + size_t(source) * nt;
+    for (const ShiftEntry& e : m_m2lPairs) local[e.target] += e.coef * M[e.source] * D[e.offset];
+}
+
+void FmmSolver::l2l(int32_t parent) {
+    const Node& node = m_nodes[parent];
+    const size_t nt = m_terms.size();
+    const double* L = m_local.data() + size_t(parent) * nt;
+    double pw[1024];
+    for (int o = 0; o < 8; ++o) {
+        if (node.child[o] < 0) continue;
+        const Node& c = m_nodes[node.child[o]];
+        double* Lc = m_local.data() + size_t(node.child[o]) * nt;
+        taylorMonomials(m_p, m_invFact, m_index,
+                        c.c[0] - node.c[0], c.c[1] - node.c[1], c.c[2] - node.c[2], pw);
+        for (const ShiftEntry& e : m_l2l) Lc[e.target] += e.coef * L[e.source] * pw[e.offset];
+    }
+}
+
+void FmmSolver::l2p(int32_t leaf, double* mono) {
+    const Node& node = m_nodes[leaf];
+    const size_t nt = m_terms.size();
+    const double* L = m_local.data() + size_t(leaf) * nt;
+    for (uint32_t k = node.begin; k < node.end; ++k) {
+        taylorMonomials(m_p, m_invFact, m_index,
+                        m_x[k] - node.c[0], m_y[k] - node.c[1], m_z[k] - node.c[2], mono);
+        // d/dy_x of L_beta y^beta is L_beta beta_x y^(beta - e_x), and
+        // beta_x (beta - e_x)! = beta!, so each term is L_beta beta! mono[beta - e_x].
+        double gx = 0.0, gy = 0.0, gz = 0.0;
+        for (size_t t = 1; t < nt; ++t) {
+            const Term& T = m_terms[t];
+            const double l = L[t] / m_invFact[t];
+            if (T.dec[0] >= 0) gx += l * mono[T.dec[0]];
+            if (T.dec[1] >= 0) gy += l * mono[T.dec[1]];
+            if (T.dec[2] >= 0) gz += l * mono[T.dec[2]];
+        }
+        m_ax[k] += gx;
+        m_ay[k] += gy;
+        m_az[k] += gz;
+    }
+}
+
+void FmmSolver::evaluate(const SourceSet& bodies, const AccelSet& out, double G,
+                         const FmmParams& params, ForceKernel kernel, ThreadPool& pool) {
+    m_params = params;
+    m_params.order = std::max(1, std::min(params.order, 16));
+    prepareOrder(m_params.order);
+    buildTree(bodies);
+    const size_t n = bodies.n;
+    if (n == 0) return;
+
+    const size_t nt = m_terms.size();
+    m_multipole.assign(m_nodes.size() * nt, 0.0);
+    m_local.assign(m_nodes.size() * nt, 0.0);
+    m_workerScratch.resize(pool.size());
+    for (auto& s : m_workerScratch) s.resize(2 * nt);
+
+    // Upward pass.
+    pool.parallelFor(0, m_leaves.size(), 16, [&](size_t begin, size_t end, unsigned) {
+        for (size_t l = begin; l < end; ++l) p2m(m_leaves[l]);
+    });
+    for (int level = int(m_levels.size()) - 1; level >= 0; --level) {
+        const auto& nodes = m_levels[level];
+        pool.parallelFor(0, nodes.size(), 16, [&](size_t begin, size_t end, unsigned) {
+            for (size_t k = begin; k < end; ++k)
+                if (!m_nodes[nodes[k]].leaf) m2m(nodes[k]);
+        });
+    }
+
+    // Interaction lists.
+    m_m2l.clear();
+    m_p2p.clear();
+    walk(0, 0);
+    std::sort(m_m2l.begin(), m_m2l.end());
+    std::sort(m_p2p.begin(), m_p2p.end(), [this](const auto& l, const auto& r) {
+        return l.first != r.first ? l.first < r.first : m_nodes[l.second].begin < m_nodes[r.second].begin;
+    });
+    m_m2lTargets.clear();
+    m_m2lStart.clear();
+    for (size_t k = 0; k < m_m2l.size(); ++k) {
+        if (k == 0 || m_m2l[k].first != m_m2l[k - 1].first) {
+            m_m2lTargets.push_back(m_m2l[k].first);
+            m_m2lStart.push_back(k);
+        }
+    }
+    m_m2lStart.push_back(m_m2l.size());
+
+    // M2L: every target cell's local expansion is owned by one task.
+    pool.parallelFor(0, m_m2lTargets.size(), 8, [&](size_t begin, size_t end, unsigned worker) {
+        double* deriv = m_workerScratch[worker].data();
+        for (size_t g = begin; g < end; ++g) {
+            const int32_t target = m_m2lTargets[g];
+            double* local = m_local.data() + size_t(target) * nt;
+            for (size_t k = m_m2lStart[g]; k < m_m2lStart[g + 1]; ++k)
+                m2l(target, m_m2l[k].second, local, deriv);
+        }
+    });
+
+    // Downward pass.
+    for (size_t level = 0; level < m_levels.size(); ++level) {
+        const auto& nodes = m_levels[level];
+        pool.parallelFor(0, nodes.size(), 16, [&](size_t begin, size_t end, unsigned) {
+            for (size_t k = begin; k < end; ++k)
+                if (!m_nodes[nodes[k]].leaf) l2l(nodes[k]);
+        });
+    }
+
+    // L2P and near field, one leaf per task. P2P groups are found by
+    // binary search in the target-sorted list.
+    TargetSet dst{m_x.data(), m_y.data(), m_z.data(), m_ax.data(), m_ay.data(), m_az.data()};
+    pool.parallelFor(0, m_leaves.size(), 4, [&](size_t begin, size_t end, unsigned worker) {
+        double* mono = m_workerScratch[worker].data();
+        for (size_t l = begin; l < end; ++l) {
+            const int32_t leaf = m_leaves[l];
+            const Node& node = m_nodes[leaf];
+            std::fill(m_ax.begin() + node.begin, m_ax.begin() + node.end, 0.0);
+            std::fill(m_ay.begin() + node.begin, m_ay.begin() + node.end, 0.0);
+            std::fill(m_az.begin() + node.begin, m_az.begin() + node.end, 0.0);
+            l2p(leaf, mono);
+
+            auto first = std::lower_bound(m_p2p.begin(), m_p2p.end(), leaf,
+                                          [](const auto& e, int32_t t) { return e.first < t; });
+            auto it = first;
+            while (it != m_p2p.end() && it->first == leaf) {
+                uint32_t b = m_nodes[it->second].begin;
+                uint32_t e = m_nodes[it->second].end;
+                while (++it != m_p2p.end() && it->first == leaf && m_nodes[it->second].begin == e)
+                    e = m_nodes[it->second].end;
+                SourceSet src{m_x.data() + b, m_y.data() + b, m_z.data() + b, m_m.data() + b, e - b};
+                kernels::accumulateDirect(kernel, src, dst, node.begin, node.end, 1.0);
+            }
+        }
+    });
+
+    const double s = G * m_scale * m_scale;
+    pool.parallelFor(0, n, 4096, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; ++k) {
+            uint32_t i = m_order[k];
+            out.ax[i] = s * m_ax[k];
+            out.ay[i] = s * m_ay[k];
+            out.az[i] = s * m_az[k];
+        }
+    });
+}
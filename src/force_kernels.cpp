@@ -0,0 +1,1344 @@
+// src/force_kernels.cpp
+#include "physics/force_kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "utils/quire.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NBODY_X86_SIMD 1
+#include <immintrin.h>
+#define NBODY_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NBODY_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#define NBODY_X86_SIMD 0
+#endif
+
+namespace kernels {
+
+bool cpuHasAvx2() {
+#if NBODY_X86_SIMD
+    static const bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return has;
+#else
+    return false;
+#endif
+}
+
+bool cpuHasAvx512() {
+#if NBODY_X86_SIMD
+    static const bool has = __builtin_cpu_supports("avx512f");
+    return has;
+#else
+    return false;
+#endif
+}
+
+ForceKernel resolve(ForceKernel kernel) {
+    if (kernel == ForceKernel::Auto)
+        kernel = ForceKernel::Avx512;
+    if (kernel == ForceKernel::Avx512 && !cpuHasAvx512())
+        kernel = ForceKernel::Avx2;
+    if (kernel == ForceKernel::Avx2 && !cpuHasAvx2())
+        kernel = ForceKernel::Scalar;
+    return kernel;
+}
+
+const char* name(ForceKernel kernel) {
+    switch (kernel) {
+        case ForceKernel::Auto:   return "auto";
+        case ForceKernel::Scalar: return "scalar";
+        case ForceKernel::Avx2:   return "avx2";
+        case ForceKernel::Avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+// Linear interpolation in the shape table; r^2 past the cutoff clamps to
+// the trailing zero entries.
+static inline double shapeScalar(const PairShape& shape, double r2) {
+    const double u = std::min(r2 * shape.invStep, double(shape.size));
+    const size_t k = size_t(u);
+    const double frac = u - double(k);
+    return shape.table[k] + frac * (shape.table[k + 1] - shape.table[k]);
+}
+
+template <bool Shaped>
+static void directScalar(const SourceSet& s, const TargetSet& t, size_t begin, size_t end, double G,
+                         const PairShape& shape) {
+    for (size_t i = begin; i < end; ++i) {
+        const double xi = t.x[i], yi = t.y[i], zi = t.z[i];
+        double axi = 0.0, ayi = 0.0, azi = 0.0;
+        for (size_t j = 0; j < s.n; ++j) {
+            double dx = s.x[j] - xi;
+            double dy = s.y[j] - yi;
+            double dz = s.z[j] - zi;
+            double distSqr = dx * dx + dy * dy + dz * dz;
+            if (distSqr == 0.0) continue;
+
+            double dist = std::sqrt(distSqr);
+            double f = s.m[j] / (distSqr * dist);
+            if constexpr (Shaped) f *= shapeScalar(shape, distSqr);
+            axi += f * dx;
+            ayi += f * dy;
+            azi += f * dz;
+        }
+        t.ax[i] += G * axi;
+        t.ay[i] += G * ayi;
+        t.az[i] += G * azi;
+    }
+}
+
+static void symmetricScalar(const SourceSet& s, const AccelSet& out, size_t begin, size_t end, double G) {
+    for (size_t i = begin; i < end; ++i) {
+        const double xi = s.x[i], yi = s.y[i], zi = s.z[i];
+        const double mi = s.m[i];
+        double axi = 0.0, ayi = 0.0, azi = 0.0;
+        for (size_t j = i + 1; j < s.n; ++j) {
+            double dx = s.x[j] - xi;
+            double dy = s.y[j] - yi;
+            double dz = s.z[j] - zi;
+            double distSqr = dx * dx + dy * dy + dz * dz;
+            if (distSqr == 0.0) continue;
+
+            double dist = std::sqrt(distSqr);
+            double f = G / (distSqr * dist);
+            double fi = f * s.m[j];
+            double fj = f * mi;
+            axi += fi * dx;
+            ayi += fi * dy;
+            azi += fi * dz;
+            out.ax[j] -= fj * dx;
+            out.ay[j] -= fj * dy;
+            out.az[j] -= fj * dz;
+        }
+        out.ax[i] += axi;
+        out.ay[i] += ayi;
+        out.az[i] += azi;
+    }
+}
+
+static void jerkScalar(const PhaseSourceSet& s, const PhaseTargetSet& t, size_t begin, size_t end, double G) {
+    for (size_t i = begin; i < end; ++i) {
+        const double xi = t.x[i], yi = t.y[i], zi = t.z[i];
+        const double vxi = t.vx[i], vyi = t.vy[i], vzi = t.vz[i];
+        double axi = 0.0, ayi = 0.0, azi = 0.0;
+        double jxi = 0.0, jyi = 0.0, jzi = 0.0;
+        for (size_t j = 0; j < s.n; ++j) {
+            double dx = s.x[j] - xi;
+            double dy = s.y[j] - yi;
+            double dz = s.z[j] - zi;
+            double distSqr = dx * dx + dy * dy + dz * dz;
+            if (distSqr == 0.0) continue;
+
+            double dvx = s.vx[j] - vxi;
+            double dvy = s.vy[j] - vyi;
+            double dvz = s.vz[j] - vzi;
+            double inv2 = 1.0 / distSqr;
+            double f = s.m[j] * inv2 * std::sqrt(inv2);
+            double rv = 3.0 * (dx * dvx + dy * dvy + dz * dvz) * inv2;
+            axi += f * dx;
+            ayi += f * dy;
+            azi += f * dz;
+            jxi += f * (dvx - rv * dx);
+            jyi += f * (dvy - rv * dy);
+            jzi += f * (dvz - rv * dz);
+        }
+        t.ax[i] += G * axi;
+        t.ay[i] += G * ayi;
+        t.az[i] += G * azi;
+        t.jx[i] += G * jxi;
+        t.jy[i] += G * jyi;
+        t.jz[i] += G * jzi;
+    }
+}
+
+// Targets per pass of the register-blocked SIMD micro-kernels; the row
+// loops are unrolled so every accumulator stays in a register.
+static constexpr size_t kRows = 4;
+#if defined(__clang__)
+#define NBODY_UNROLL_ROWS _Pragma("unroll")
+#else
+#define NBODY_UNROLL_ROWS _Pragma("GCC unroll 4")
+#endif
+
+// Mixed precision: float32 copies of the sources as offsets from one
+// reference point, scaled by powers of two so offsets lie in [-1, 1] and
+// masses in (0, 1]. In SI units raw float separations would overflow r^2
+// or underflow r^-3. Padded with zero-mass entries to a multiple of 16.
+struct MixedSources {
+    std::vector<float> x, y, z, m;
+    size_t n = 0;
+};
+
+static constexpr size_t kMixedRun = 128;    // sources summed in float before widening to double
+
+static thread_local MixedSources t_mixed;
+
+static void convertSources(const SourceSet& s, double rx, double ry, double rz,
+                           double invL, double invM, MixedSources& out) {
+    const size_t padded = (s.n + 15) & ~size_t(15);
+    out.x.resize(padded); out.y.resize(padded); out.z.resize(padded); out.m.resize(padded);
+    for (size_t j = 0; j < s.n; ++j) {
+        out.x[j] = float((s.x[j] - rx) * invL);
+        out.y[j] = float((s.y[j] - ry) * invL);
+        out.z[j] = float((s.z[j] - rz) * invL);
+        out.m[j] = float(s.m[j] * invM);
+    }
+    for (size_t j = s.n; j < padded; ++j) out.x[j] = out.y[j] = out.z[j] = out.m[j] = 0.0f;
+    out.n = padded;
+}
+
+static void mixedScalar(const MixedSources& s, float xi, float yi, float zi, double* acc) {
+    for (size_t j0 = 0; j0 < s.n; j0 += kMixedRun) {
+        const size_t j1 = std::min(s.n, j0 + kMixedRun);
+        float fx = 0.0f, fy = 0.0f, fz = 0.0f;
+        for (size_t j = j0; j < j1; ++j) {
+            float dx = s.x[j] - xi;
+            float dy = s.y[j] - yi;
+            float dz = s.z[j] - zi;
+            float r2 = dx * dx + dy * dy + dz * dz;
+            if (r2 == 0.0f) continue;
+
+            float inv = 1.0f / std::sqrt(r2);
+            float f = s.m[j] * inv * (inv * inv);
+            fx += f * dx;
+            fy += f * dy;
+            fz += f * dz;
+        }
+        acc[0] += fx;
+        acc[1] += fy;
+        acc[2] += fz;
+    }
+}
+
+// Exact summation. Every path forms the pair terms f dx with the same
+// operations, r^2 as explicit fmas so that no compiler contraction can
+// make them differ, and each component's sum is rounded once from its
+// exact value; the results then do not depend on the path, the source
+// order or how targets are split between workers.
+//
+// The sums first run compensated (TwoSum, as in Ogita, Rump & Oishi's
+// Sum2) in a few independent lanes, with the magnitudes of the TwoSum
+// errors summed alongside to bound what the compensation itself lost.
+// When the bound shows that every value within it rounds to the same
+// double, that double is the correctly rounded exact sum. Otherwise (heavy
+// cancellation right at a rounding boundary, or a non-finite term) the
+// target is summed again in binned Kulisch accumulators.
+struct ExactSums {
+    BinnedKulischAccumulator x, y, z;
+};
+
+static thread_local ExactSums t_exact;
+
+static constexpr size_t kExactChunk = BinnedKulischAccumulator::kFlushInterval;
+static constexpr size_t kExactLanes = 4;   // compensated lanes on the scalar path
+
+// One component's compensated lanes, up to the AVX-512 width.
+struct CompensatedSum {
+    double s[8] = {}, c[8] = {}, b[8] = {};
+};
+
+// Adds x to s + c; the TwoSum error goes into c and its magnitude into b.
+static inline void twoSumAdd(double& s, double& c, double& b, double x) {
+    const double t = s + x;
+    const double z = t - s;
+    const double e = (s - (t - z)) + (x - z);
+    s = t;
+    c += e;
+    b += std::fabs(e);
+}
+
+// The correctly rounded sum of `terms` terms held in lanes of s + c, if
+// the error bound proves it. Recursive summation of k values errs by at
+// most gamma_k = k u / (1 - k u) times their magnitudes; the bound below
+// takes 2 k u, and the test asks for twice the bound against its own
+// rounding.
+static bool roundCompensated(const double* s, const double* c, const double* b, size_t lanes, size_t terms,
+                             double& out) {
+    constexpr double u = 0x1p-53;
+    double hi = 0.0, lo = 0.0, loAbs = 0.0, err = 0.0;
+    for (size_t l = 0; l < lanes; ++l) {
+        double e = 0.0;
+        twoSumAdd(hi, e, err, s[l]);
+        lo += e + c[l];
+        loAbs += std::fabs(e) + std::fabs(c[l]);
+        err += b[l];
+    }
+    // err now sums every |TwoSum error| that went into a c.
+    double bound = 0.0;
+    if (err != 0.0 || loAbs != 0.0)
+        bound = 2.0 * u * (double(terms) * err + double(2 * lanes) * loAbs) + 0x1p-1070;
+
+    // r is hi + lo rounded and t what that left over, exactly; the sum is
+    // r + t within the bound. Without a bound r is already exact rounding.
+    double r = 0.0, t = 0.0, unused = 0.0;
+    twoSumAdd(r, t, unused, hi);
+    twoSumAdd(r, t, unused, lo);
+    if (!std::isfinite(r) || !std::isfinite(bound)) return false;
+    if (bound != 0.0) {
+        const double mag = std::fabs(r);
+        const double gap = mag - std::nextafter(mag, 0.0);   // the smaller neighbouring gap
+        if (!(0.5 * gap - std::fabs(t) > 2.0 * bound)) return false;
+    }
+    out = r + 0.0;   // the Kulisch path returns +0 for a zero sum
+    return true;
+}
+
+static inline void exactPairsScalar(const SourceSet& s, size_t j0, size_t j1,
+                                    double xi, double yi, double zi, ExactSums& q) {
+    for (size_t j = j0; j < j1; ++j) {
+        double dx = s.x[j] - xi;
+        double dy = s.y[j] - yi;
+        double dz = s.z[j] - zi;
+        double distSqr = std::fma(dx, dx, std::fma(dy, dy, dz * dz));
+        if (distSqr == 0.0) continue;
+
+        double f = s.m[j] / (distSqr * std::sqrt(distSqr));
+        q.x.add(f * dx);
+        q.y.add(f * dy);
+        q.z.add(f * dz);
+    }
+}
+
+// A pair term rounded on its own. Where FMA is available the compiler
+// may otherwise fuse the product into TwoSum's adds, which breaks their
+// exactness; an fma with +0 is the rounded product and fuses with nothing.
+static inline double roundedProduct(double a, double b) {
+#ifdef __FP_FAST_FMA
+    return std::fma(a, b, 0.0);
+#else
+    return a * b;
+#endif
+}
+
+// Compensated pair terms of sources [j0, j1), the first `lanes` sources
+// in lanes 0.., the next in the same lanes again.
+static inline void compensatedPairsScalar(const SourceSet& s, size_t j0, size_t j1, double xi, double yi,
+                                          double zi, CompensatedSum* acc, size_t lanes) {
+    size_t l = 0;
+    for (size_t j = j0; j < j1; ++j) {
+        double dx = s.x[j] - xi;
+        double dy = s.y[j] - yi;
+        double dz = s.z[j] - zi;
+        double distSqr = std::fma(dx, dx, std::fma(dy, dy, dz * dz));
+        if (distSqr == 0.0) continue;
+
+        double f = s.m[j] / (distSqr * std::sqrt(distSqr));
+        twoSumAdd(acc[0].s[l], acc[0].c[l], acc[0].b[l], roundedProduct(f, dx));
+        twoSumAdd(acc[1].s[l], acc[1].c[l], acc[1].b[l], roundedProduct(f, dy));
+        twoSumAdd(acc[2].s[l], acc[2].c[l], acc[2].b[l], roundedProduct(f, dz));
+        if (++l == lanes) l = 0;
+    }
+}
+
+static inline void exactTerms(ExactSums& q, const double* tx, const double* ty, const double* tz, size_t count) {
+    for (size_t l = 0; l < count; ++l) q.x.add(tx[l]);
+    for (size_t l = 0; l < count; ++l) q.y.add(ty[l]);
+    for (size_t l = 0; l < count; ++l) q.z.add(tz[l]);
+}
+
+// Rounds the three compensated components of target i into its
+// acceleration, or reports that the exact path has to run.
+static inline bool finishCompensated(const CompensatedSum* acc, size_t lanes, size_t terms,
+                                     const TargetSet& t, size_t i, double G) {
+    double v[3];
+    for (int k = 0; k < 3; ++k)
+        if (!roundCompensated(acc[k].s, acc[k].c, acc[k].b, lanes, terms, v[k])) return false;
+    t.ax[i] += G * v[0];
+    t.ay[i] += G * v[1];
+    t.az[i] += G * v[2];
+    return true;
+}
+
+static inline void finishExact(const ExactSums& q, const TargetSet& t, size_t i, double G) {
+    t.ax[i] += G * q.x.value();
+    t.ay[i] += G * q.y.value();
+    t.az[i] += G * q.z.value();
+}
+
+static void exactScalar(const SourceSet& s, const TargetSet& t, size_t begin, size_t end, double G) {
+    ExactSums& q = t_exact;
+    const size_t nb = s.n - s.n % kExactLanes;
+    for (size_t i = begin; i < end; ++i) {
+        const double xi = t.x[i], yi = t.y[i], zi = t.z[i];
+        // kExactLanes independent sums in locals, so the TwoSum chains
+        // overlap.
+        double sx[kExactLanes] = {}, cx[kExactLanes] = {}, bx[kExactLanes] = {};
+        double sy[kExactLanes] = {}, cy[kExactLanes] = {}, by[kExactLanes] = {};
+        double sz[kExactLanes] = {}, cz[kExactLanes] = {}, bz[kExactLanes] = {};
+        for (size_t j = 0; j < nb; j += kExactLanes) {
+            for (size_t l = 0; l < kExactLanes; ++l) {
+                const double dx = s.x[j + l] - xi;
+                const double dy = s.y[j + l] - yi;
+                const double dz = s.z[j + l] - zi;
+                const double distSqr = std::fma(dx, dx, std::fma(dy, dy, dz * dz));
+                const double f = distSqr > 0.0 ? s.m[j + l] / (distSqr * std::sqrt(distSqr)) : 0.0;
+                twoSumAdd(sx[l], cx[l], bx[l], roundedProduct(f, dx));
+                twoSumAdd(sy[l], cy[l], by[l], roundedProduct(f, dy));
+                twoSumAdd(sz[l], cz[l], bz[l], roundedProduct(f, dz));
+            }
+        }
+        CompensatedSum acc[3];
+        std::copy(sx, sx + kExactLanes, acc[0].s); std::copy(cx, cx + kExactLanes, acc[0].c); std::copy(bx, bx + kExactLanes, acc[0].b);
+        std::copy(sy, sy + kExactLanes, acc[1].s); std::copy(cy, cy + kExactLanes, acc[1].c); std::copy(by, by + kExactLanes, acc[1].b);
+        std::copy(sz, sz + kExactLanes, acc[2].s); std::copy(cz, cz + kExactLanes, acc[2].c); std::copy(bz, bz + kExactLanes, acc[2].b);
+        compensatedPairsScalar(s, nb, s.n, xi, yi, zi, acc, kExactLanes);
+        if (finishCompensated(acc, kExactLanes, s.n, t, i, G)) continue;
+
+        q.x.clear(); q.y.clear(); q.z.clear();
+        exactPairsScalar(s, 0, s.n, xi, yi, zi, q);
+        finishExact(q, t, i, G);
+    }
+}
+
+#if NBODY_X86_SIMD
+
+NBODY_TARGET_AVX2 static inline double hsum256(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+// r^-3 for four squared distances. The r2 > 0 mask zeroes the self term
+// (and masked-off tail lanes) without a branch.
+NBODY_TARGET_AVX2 static inline __m256d invCubeAvx2(__m256d r2) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d live = _mm256_cmp_pd(r2, _mm256_setzero_pd(), _CMP_GT_OQ);
+    __m256d invR3 = _mm256_div_pd(one, _mm256_mul_pd(r2, _mm256_sqrt_pd(r2)));
+    return _mm256_and_pd(live, invR3);
+}
+
+NBODY_TARGET_AVX2 static inline __m256d shapeAvx2(const PairShape& shape, __m256d r2) {
+    __m256d u = _mm256_min_pd(_mm256_mul_pd(r2, _mm256_set1_pd(shape.invStep)),
+                              _mm256_set1_pd(double(shape.size)));
+    __m128i k = _mm256_cvttpd_epi32(u);
+    __m256d frac = _mm256_sub_pd(u, _mm256_cvtepi32_pd(k));
+    __m256d lo = _mm256_i32gather_pd(shape.table, k, 8);
+    __m256d hi = _mm256_i32gather_pd(shape.table + 1, k, 8);
+    return _mm256_fmadd_pd(frac, _mm256_sub_pd(hi, lo), lo);
+}
+
+// One 4-wide slice of sources against a broadcast target.
+template <bool Shaped>
+NBODY_TARGET_AVX2 static inline void pairAvx2(__m256d xi, __m256d yi, __m256d zi,
+                                              __m256d xj, __m256d yj, __m256d zj, __m256d mj,
+                                              __m256d& ax, __m256d& ay, __m256d& az,
+                                              const PairShape& shape) {
+    __m256d dx = _mm256_sub_pd(xj, xi);
+    __m256d dy = _mm256_sub_pd(yj, yi);
+    __m256d dz = _mm256_sub_pd(zj, zi);
+    __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+    __m256d f = _mm256_mul_pd(mj, invCubeAvx2(r2));
+    if constexpr (Shaped) f = _mm256_mul_pd(f, shapeAvx2(shape, r2));
+    ax = _mm256_fmadd_pd(f, dx, ax);
+    ay = _mm256_fmadd_pd(f, dy, ay);
+    az = _mm256_fmadd_pd(f, dz, az);
+}
+
+template <bool Shaped>
+NBODY_TARGET_AVX2 static void directAvx2(const SourceSet& s, const TargetSet& t, size_t begin, size_t end, double G,
+                                         const PairShape& shape) {
+    const size_t nv = s.n & ~size_t(3);
+    const size_t rem = s.n - nv;
+    const __m256i tailMask = _mm256_cmpgt_epi64(_mm256_set1_epi64x((long long)rem),
+                                                _mm256_setr_epi64x(0, 1, 2, 3));
+
+    for (size_t i = begin; i < end; ++i) {
+        const __m256d xi = _mm256_set1_pd(t.x[i]);
+        const __m256d yi = _mm256_set1_pd(t.y[i]);
+        const __m256d zi = _mm256_set1_pd(t.z[i]);
+        __m256d ax = _mm256_setzero_pd(), ay = _mm256_setzero_pd(), az = _mm256_setzero_pd();
+
+        for (size_t j = 0; j < nv; j += 4) {
+            pairAvx2<Shaped>(xi, yi, zi,
+                             _mm256_loadu_pd(s.x + j), _mm256_loadu_pd(s.y + j), _mm256_loadu_pd(s.z + j),
+                             _mm256_loadu_pd(s.m + j), ax, ay, az, shape);
+        }
+        if (rem) {
+            pairAvx2<Shaped>(xi, yi, zi,
+                             _mm256_maskload_pd(s.x + nv, tailMask), _mm256_maskload_pd(s.y + nv, tailMask),
+                             _mm256_maskload_pd(s.z + nv, tailMask), _mm256_maskload_pd(s.m + nv, tailMask),
+                             ax, ay, az, shape);
+        }
+
+        t.ax[i] += G * hsum256(ax);
+        t.ay[i] += G * hsum256(ay);
+        t.az[i] += G * hsum256(az);
+    }
+}
+
+// Sum of the two float halves as doubles.
+NBODY_TARGET_AVX2 static inline __m256d widenAvx2(__m256 v) {
+    return _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)),
+                         _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+}
+
+// Eight float pairs per instruction: rsqrt estimate plus one Newton step
+// is enough for float, and the run sums are widened into two double
+// vectors.
+template <size_t R>
+NBODY_TARGET_AVX2 static void mixedAvx2(const MixedSources& s, const float* xi, const float* yi, const float* zi,
+                                        double (*acc)[3]) {
+    const __m256 half = _mm256_set1_ps(0.5f), threeHalves = _mm256_set1_ps(1.5f);
+    __m256 txi[R], tyi[R], tzi[R];
+    __m256d dax[R], day[R], daz[R];
+    for (size_t r = 0; r < R; ++r) {
+        txi[r] = _mm256_set1_ps(xi[r]);
+        tyi[r] = _mm256_set1_ps(yi[r]);
+        tzi[r] = _mm256_set1_ps(zi[r]);
+        dax[r] = day[r] = daz[r] = _mm256_setzero_pd();
+    }
+    for (size_t j0 = 0; j0 < s.n; j0 += kMixedRun) {
+        const size_t j1 = std::min(s.n, j0 + kMixedRun);
+        __m256 fax[R], fay[R], faz[R];
+        for (size_t r = 0; r < R; ++r) fax[r] = fay[r] = faz[r] = _mm256_setzero_ps();
+        for (size_t j = j0; j < j1; j += 8) {
+            const __m256 xj = _mm256_loadu_ps(s.x.data() + j), yj = _mm256_loadu_ps(s.y.data() + j);
+            const __m256 zj = _mm256_loadu_ps(s.z.data() + j), mj = _mm256_loadu_ps(s.m.data() + j);
+            NBODY_UNROLL_ROWS
+            for (size_t r = 0; r < R; ++r) {
+                __m256 dx = _mm256_sub_ps(xj, txi[r]);
+                __m256 dy = _mm256_sub_ps(yj, tyi[r]);
+                __m256 dz = _mm256_sub_ps(zj, tzi[r]);
+                __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+                __m256 live = _mm256_cmp_ps(r2, _mm256_setzero_ps(), _CMP_GT_OQ);
+                __m256 y = _mm256_rsqrt_ps(r2);
+                y = _mm256_mul_ps(y, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2), _mm256_mul_ps(y, y), threeHalves));
+                __m256 f = _mm256_and_ps(live, _mm256_mul_ps(_mm256_mul_ps(mj, y), _mm256_mul_ps(y, y)));
+                fax[r] = _mm256_fmadd_ps(f, dx, fax[r]);
+                fay[r] = _mm256_fmadd_ps(f, dy, fay[r]);
+                faz[r] = _mm256_fmadd_ps(f, dz, faz[r]);
+            }
+        }
+        for (size_t r = 0; r < R; ++r) {
+            dax[r] = _mm256_add_pd(dax[r], widenAvx2(fax[r]));
+            day[r] = _mm256_add_pd(day[r], widenAvx2(fay[r]));
+            daz[r] = _mm256_add_pd(daz[r], widenAvx2(faz[r]));
+        }
+    }
+    for (size_t r = 0; r < R; ++r) {
+        acc[r][0] += hsum256(dax[r]);
+        acc[r][1] += hsum256(day[r]);
+        acc[r][2] += hsum256(daz[r]);
+    }
+}
+
+// Register-blocked micro-kernel over one tile: kRows targets at a time,
+// each source slice loaded once and reused for every row.
+static const PairShape kNoShape{};
+
+NBODY_TARGET_AVX2 static void tileAvx2(const SourceSet& s, size_t j0, size_t j1, const TargetSet& t,
+                                       size_t i0, size_t i1, double G) {
+    const size_t nv = j0 + ((j1 - j0) & ~size_t(3));
+    const size_t rem = j1 - nv;
+    const __m256i tailMask = _mm256_cmpgt_epi64(_mm256_set1_epi64x((long long)rem),
+                                                _mm256_setr_epi64x(0, 1, 2, 3));
+    size_t i = i0;
+    for (; i + kRows <= i1; i += kRows) {
+        __m256d xi[kRows], yi[kRows], zi[kRows], ax[kRows], ay[kRows], az[kRows];
+        NBODY_UNROLL_ROWS
+        for (size_t r = 0; r < kRows; ++r) {
+            xi[r] = _mm256_set1_pd(t.x[i + r]);
+            yi[r] = _mm256_set1_pd(t.y[i + r]);
+            zi[r] = _mm256_set1_pd(t.z[i + r]);
+            ax[r] = ay[r] = az[r] = _mm256_setzero_pd();
+        }
+        for (size_t j = j0; j < nv; j += 4) {
+            const __m256d xj = _mm256_loadu_pd(s.x + j), yj = _mm256_loadu_pd(s.y + j);
+            const __m256d zj = _mm256_loadu_pd(s.z + j), mj = _mm256_loadu_pd(s.m + j);
+            NBODY_UNROLL_ROWS
+            for (size_t r = 0; r < kRows; ++r)
+                pairAvx2<false>(xi[r], yi[r], zi[r], xj, yj, zj, mj, ax[r], ay[r], az[r], kNoShape);
+        }
+        if (rem) {
+            const __m256d xj = _mm256_maskload_pd(s.x + nv, tailMask), yj = _mm256_maskload_pd(s.y + nv, tailMask);
+            const __m256d zj = _mm256_maskload_pd(s.z + nv, tailMask), mj = _mm256_maskload_pd(s.m + nv, tailMask);
+            NBODY_UNROLL_ROWS
+            for (size_t r = 0; r < kRows; ++r)
+                pairAvx2<false>(xi[r], yi[r], zi[r], xj, yj, zj, mj, ax[r], ay[r], az[r], kNoShape);
+        }
+        NBODY_UNROLL_ROWS
+        for (size_t r = 0; r < kRows; ++r) {
+            t.ax[i + r] += G * hsum256(ax[r]);
+            t.ay[i + r] += G * hsum256(ay[r]);
+            t.az[i + r] += G * hsum256(az[r]);
+        }
+    }
+    if (i < i1) {
+        const SourceSet tile{s.x + j0, s.y + j0, s.z + j0, s.m + j0, j1 - j0};
+        directAvx2<false>(tile, t, i, i1, G, kNoShape);
+    }
+}
+
+// Row i of the upper triangle: sources j > i are read in 4-wide slices and
+// their reaction terms written back with a contiguous load/subtract/store.
+NBODY_TARGET_AVX2 static void symmetricAvx2(const SourceSet& s, const AccelSet& out, size_t begin, size_t end, double G) {
+    const __m256d g = _mm256_set1_pd(G);
+    const __m256i lane = _mm256_setr_epi64x(0, 1, 2, 3);
+
+    for (size_t i = begin; i < end; ++i) {
+        const __m256d xi = _mm256_set1_pd(s.x[i]);
+        const __m256d yi = _mm256_set1_pd(s.y[i]);
+        const __m256d zi = _mm256_set1_pd(s.z[i]);
+        const __m256d mi = _mm256_set1_pd(s.m[i]);
+        __m256d ax = _mm256_setzero_pd(), ay = _mm256_setzero_pd(), az = _mm256_setzero_pd();
+
+        for (size_t j = i + 1; j < s.n; j += 4) {
+            const size_t rem = s.n - j;
+            const __m256i mask = _mm256_cmpgt_epi64(_mm256_set1_epi64x((long long)rem), lane);
+            __m256d dx = _mm256_sub_pd(_mm256_maskload_pd(s.x + j, mask), xi);
+            __m256d dy = _mm256_sub_pd(_mm256_maskload_pd(s.y + j, mask), yi);
+            __m256d dz = _mm256_sub_pd(_mm256_maskload_pd(s.z + j, mask), zi);
+            __m256d mj = _mm256_maskload_pd(s.m + j, mask);
+            __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+            __m256d f = _mm256_mul_pd(g, invCubeAvx2(r2));
+            __m256d fi = _mm256_mul_pd(f, mj);
+            __m256d fj = _mm256_mul_pd(f, mi);
+            ax = _mm256_fmadd_pd(fi, dx, ax);
+            ay = _mm256_fmadd_pd(fi, dy, ay);
+            az = _mm256_fmadd_pd(fi, dz, az);
+            _mm256_maskstore_pd(out.ax + j, mask, _mm256_fnmadd_pd(fj, dx, _mm256_maskload_pd(out.ax + j, mask)));
+            _mm256_maskstore_pd(out.ay + j, mask, _mm256_fnmadd_pd(fj, dy, _mm256_maskload_pd(out.ay + j, mask)));
+            _mm256_maskstore_pd(out.az + j, mask, _mm256_fnmadd_pd(fj, dz, _mm256_maskload_pd(out.az + j, mask)));
+        }
+
+        out.ax[i] += hsum256(ax);
+        out.ay[i] += hsum256(ay);
+        out.az[i] += hsum256(az);
+    }
+}
+
+// One 4-wide slice of sources against a broadcast target. tgt and src
+// hold x, y, z, vx, vy, vz; acc holds ax, ay, az, jx, jy, jz.
+NBODY_TARGET_AVX2 static inline void jerkPairAvx2(const __m256d* tgt, const __m256d* src, __m256d mj, __m256d* acc) {
+    __m256d dx = _mm256_sub_pd(src[0], tgt[0]);
+    __m256d dy = _mm256_sub_pd(src[1], tgt[1]);
+    __m256d dz = _mm256_sub_pd(src[2], tgt[2]);
+    __m256d dvx = _mm256_sub_pd(src[3], tgt[3]);
+    __m256d dvy = _mm256_sub_pd(src[4], tgt[4]);
+    __m256d dvz = _mm256_sub_pd(src[5], tgt[5]);
+    __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+    __m256d live = _mm256_cmp_pd(r2, _mm256_setzero_pd(), _CMP_GT_OQ);
+    __m256d inv2 = _mm256_and_pd(live, _mm256_div_pd(_mm256_set1_pd(1.0), r2));
+    __m256d f = _mm256_mul_pd(mj, _mm256_mul_pd(inv2, _mm256_sqrt_pd(inv2)));
+    __m256d rv = _mm256_fmadd_pd(dx, dvx, _mm256_fmadd_pd(dy, dvy, _mm256_mul_pd(dz, dvz)));
+    rv = _mm256_mul_pd(_mm256_set1_pd(3.0), _mm256_mul_pd(rv, inv2));
+    acc[0] = _mm256_fmadd_pd(f, dx, acc[0]);
+    acc[1] = _mm256_fmadd_pd(f, dy, acc[1]);
+    acc[2] = _mm256_fmadd_pd(f, dz, acc[2]);
+    acc[3] = _mm256_fmadd_pd(f, _mm256_fnmadd_pd(rv, dx, dvx), acc[3]);
+    acc[4] = _mm256_fmadd_pd(f, _mm256_fnmadd_pd(rv, dy, dvy), acc[4]);
+    acc[5] = _mm256_fmadd_pd(f, _mm256_fnmadd_pd(rv, dz, dvz), acc[5]);
+}
+
+NBODY_TARGET_AVX2 static void jerkAvx2(const PhaseSourceSet& s, const PhaseTargetSet& t, size_t begin, size_t end, double G) {
+    const size_t nv = s.n & ~size_t(3);
+    const size_t rem = s.n - nv;
+    const __m256i tailMask = _mm256_cmpgt_epi64(_mm256_set1_epi64x((long long)rem),
+                                                _mm256_setr_epi64x(0, 1, 2, 3));
+    const double* cols[6] = {s.x, s.y, s.z, s.vx, s.vy, s.vz};
+
+    for (size_t i = begin; i < end; ++i) {
+        const __m256d tgt[6] = {_mm256_set1_pd(t.x[i]), _mm256_set1_pd(t.y[i]), _mm256_set1_pd(t.z[i]),
+                                _mm256_set1_pd(t.vx[i]), _mm256_set1_pd(t.vy[i]), _mm256_set1_pd(t.vz[i])};
+        __m256d acc[6];
+        for (int c = 0; c < 6; ++c) acc[c] = _mm256_setzero_pd();
+
+        __m256d src[6];
+        for (size_t j = 0; j < nv; j += 4) {
+            for (int c = 0; c < 6; ++c) src[c] = _mm256_loadu_pd(cols[c] + j);
+            jerkPairAvx2(tgt, src, _mm256_loadu_pd(s.m + j), acc);
+        }
+        if (rem) {
+            for (int c = 0; c < 6; ++c) src[c] = _mm256_maskload_pd(cols[c] + nv, tailMask);
+            jerkPairAvx2(tgt, src, _mm256_maskload_pd(s.m + nv, tailMask), acc);
+        }
+
+        t.ax[i] += G * hsum256(acc[0]);
+        t.ay[i] += G * hsum256(acc[1]);
+        t.az[i] += G * hsum256(acc[2]);
+        t.jx[i] += G * hsum256(acc[3]);
+        t.jy[i] += G * hsum256(acc[4]);
+        t.jz[i] += G * hsum256(acc[5]);
+    }
+}
+
+NBODY_TARGET_AVX512 static inline __m512d invCubeAvx512(__mmask8 lanes, __m512d r2) {
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d threeHalves = _mm512_set1_pd(1.5);
+    __mmask8 live = _mm512_mask_cmp_pd_mask(lanes, r2, _mm512_setzero_pd(), _CMP_GT_OQ);
+    // 14-bit reciprocal square root estimate, two Newton steps to full double.
+    __m512d h = _mm512_mul_pd(half, r2);
+    __m512d y = _mm512_rsqrt14_pd(r2);
+    y = _mm512_mul_pd(y, _mm512_fnmadd_pd(h, _mm512_mul_pd(y, y), threeHalves));
+    y = _mm512_mul_pd(y, _mm512_fnmadd_pd(h, _mm512_mul_pd(y, y), threeHalves));
+    return _mm512_maskz_mul_pd(live, y, _mm512_mul_pd(y, y));
+}
+
+NBODY_TARGET_AVX512 static inline __m512d shapeAvx512(const PairShape& shape, __m512d r2) {
+    __m512d u = _mm512_min_pd(_mm512_mul_pd(r2, _mm512_set1_pd(shape.invStep)),
+                              _mm512_set1_pd(double(shape.size)));
+    __m256i k = _mm512_cvttpd_epi32(u);
+    __m512d frac = _mm512_sub_pd(u, _mm512_cvtepi32_pd(k));
+    __m512d lo = _mm512_i32gather_pd(k, shape.table, 8);
+    __m512d hi = _mm512_i32gather_pd(k, shape.table + 1, 8);
+    return _mm512_fmadd_pd(frac, _mm512_sub_pd(hi, lo), lo);
+}
+
+template <bool Shaped>
+NBODY_TARGET_AVX512 static inline void pairAvx512(__mmask8 lanes, __m512d xi, __m512d yi, __m512d zi,
+                                                  __m512d xj, __m512d yj, __m512d zj, __m512d mj,
+                                                  __m512d& ax, __m512d& ay, __m512d& az,
+                                                  const PairShape& shape) {
+    __m512d dx = _mm512_sub_pd(xj, xi);
+    __m512d dy = _mm512_sub_pd(yj, yi);
+    __m512d dz = _mm512_sub_pd(zj, zi);
+    __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+    __m512d f = _mm512_mul_pd(mj, invCubeAvx512(lanes, r2));
+    if constexpr (Shaped) f = _mm512_mul_pd(f, shapeAvx512(shape, r2));
+    ax = _mm512_fmadd_pd(f, dx, ax);
+    ay = _mm512_fmadd_pd(f, dy, ay);
+    az = _mm512_fmadd_pd(f, dz, az);
+}
+
+template <bool Shaped>
+NBODY_TARGET_AVX512 static void directAvx512(const SourceSet& s, const TargetSet& t, size_t begin, size_t end, double G,
+                                             const PairShape& shape) {
+    const size_t nv = s.n & ~size_t(7);
+    const __mmask8 tail = (__mmask8)((1u << (s.n - nv)) - 1u);
+
+    for (size_t i = begin; i < end; ++i) {
+        const __m512d xi = _mm512_set1_pd(t.x[i]);
+        const __m512d yi = _mm512_set1_pd(t.y[i]);
+        const __m512d zi = _mm512_set1_pd(t.z[i]);
+        __m512d ax = _mm512_setzero_pd(), ay = _mm512_setzero_pd(), az = _mm512_setzero_pd();
+
+        for (size_t j = 0; j < nv; j += 8) {
+            pairAvx512<Shaped>(0xFF, xi, yi, zi,
+                               _mm512_loadu_pd(s.x + j), _mm512_loadu_pd(s.y + j), _mm512_loadu_pd(s.z + j),
+                               _mm512_loadu_pd(s.m + j), ax, ay, az, shape);
+        }
+        if (tail) {
+            pairAvx512<Shaped>(tail, xi, yi, zi,
+                               _mm512_maskz_loadu_pd(tail, s.x + nv), _mm512_maskz_loadu_pd(tail, s.y + nv),
+                               _mm512_maskz_loadu_pd(tail, s.z + nv), _mm512_maskz_loadu_pd(tail, s.m + nv),
+                               ax, ay, az, shape);
+        }
+
+        t.ax[i] += G * _mm512_reduce_add_pd(ax);
+        t.ay[i] += G * _mm512_reduce_add_pd(ay);
+        t.az[i] += G * _mm512_reduce_add_pd(az);
+    }
+}
+
+NBODY_TARGET_AVX512 static void tileAvx512(const SourceSet& s, size_t j0, size_t j1, const TargetSet& t,
+                                           size_t i0, size_t i1, double G) {
+    const size_t nv = j0 + ((j1 - j0) & ~size_t(7));
+    const __mmask8 tail = (__mmask8)((1u << (j1 - nv)) - 1u);
+    size_t i = i0;
+    for (; i + kRows <= i1; i += kRows) {
+        __m512d xi[kRows], yi[kRows], zi[kRows], ax[kRows], ay[kRows], az[kRows];
+        NBODY_UNROLL_ROWS
+        for (size_t r = 0; r < kRows; ++r) {
+            xi[r] = _mm512_set1_pd(t.x[i + r]);
+            yi[r] = _mm512_set1_pd(t.y[i + r]);
+            zi[r] = _mm512_set1_pd(t.z[i + r]);
+            ax[r] = ay[r] = az[r] = _mm512_setzero_pd();
+        }
+        for (size_t j = j0; j < nv; j += 8) {
+            const __m512d xj = _mm512_loadu_pd(s.x + j), yj = _mm512_loadu_pd(s.y + j);
+            const __m512d zj = _mm512_loadu_pd(s.z + j), mj = _mm512_loadu_pd(s.m + j);
+            NBODY_UNROLL_ROWS
+            for (size_t r = 0; r < kRows; ++r)
+                pairAvx512<false>(0xFF, xi[r], yi[r], zi[r], xj, yj, zj, mj, ax[r], ay[r], az[r], kNoShape);
+        }
+        if (tail) {
+            const __m512d xj = _mm512_maskz_loadu_pd(tail, s.x + nv), yj = _mm512_maskz_loadu_pd(tail, s.y + nv);
+            const __m512d zj = _mm512_maskz_loadu_pd(tail, s.z + nv), mj = _mm512_maskz_loadu_pd(tail, s.m + nv);
+            NBODY_UNROLL_ROWS
+            for (size_t r = 0; r < kRows; ++r)
+                pairAvx512<false>(tail, xi[r], yi[r], zi[r], xj, yj, zj, mj, ax[r], ay[r], az[r], kNoShape);
+        }
+        NBODY_UNROLL_ROWS
+        for (size_t r = 0; r < kRows; ++r) {
+            t.ax[i + r] += G * _mm512_reduce_add_pd(ax[r]);
+            t.ay[i + r] += G * _mm512_reduce_add_pd(ay[r]);
+            t.az[i + r] += G * _mm512_reduce_add_pd(az[r]);
+        }
+    }
+    if (i < i1) {
+        const SourceSet tile{s.x + j0, s.y + j0, s.z + j0, s.m + j0, j1 - j0};
+        directAvx512<false>(tile, t, i, i1, G, kNoShape);
+    }
+}
+
+NBODY_TARGET_AVX512 static inline __m512d widenAvx512(__m512 v) {
+    __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+    return _mm512_add_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(v)), _mm512_cvtps_pd(hi));
+}
+
+template <size_t R>
+NBODY_TARGET_AVX512 static void mixedAvx512(const MixedSources& s, const float* xi, const float* yi, const float* zi,
+                                            double (*acc)[3]) {
+    const __m512 half = _mm512_set1_ps(0.5f), threeHalves = _mm512_set1_ps(1.5f);
+    __m512 txi[R], tyi[R], tzi[R];
+    __m512d dax[R], day[R], daz[R];
+    for (size_t r = 0; r < R; ++r) {
+        txi[r] = _mm512_set1_ps(xi[r]);
+        tyi[r] = _mm512_set1_ps(yi[r]);
+        tzi[r] = _mm512_set1_ps(zi[r]);
+        dax[r] = day[r] = daz[r] = _mm512_setzero_pd();
+    }
+    for (size_t j0 = 0; j0 < s.n; j0 += kMixedRun) {
+        const size_t j1 = std::min(s.n, j0 + kMixedRun);
+        __m512 fax[R], fay[R], faz[R];
+        for (size_t r = 0; r < R; ++r) fax[r] = fay[r] = faz[r] = _mm512_setzero_ps();
+        for (size_t j = j0; j < j1; j += 16) {
+            const __m512 xj = _mm512_loadu_ps(s.x.data() + j), yj = _mm512_loadu_ps(s.y.data() + j);
+            const __m512 zj = _mm512_loadu_ps(s.z.data() + j), mj = _mm512_loadu_ps(s.m.data() + j);
+            NBODY_UNROLL_ROWS
+            for (size_t r = 0; r < R; ++r) {
+                __m512 dx = _mm512_sub_ps(xj, txi[r]);
+                __m512 dy = _mm512_sub_ps(yj, tyi[r]);
+                __m512 dz = _mm512_sub_ps(zj, tzi[r]);
+                __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+                __mmask16 live = _mm512_cmp_ps_mask(r2, _mm512_setzero_ps(), _CMP_GT_OQ);
+                __m512 y = _mm512_rsqrt14_ps(r2);
+                y = _mm512_mul_ps(y, _mm512_fnmadd_ps(_mm512_mul_ps(half, r2), _mm512_mul_ps(y, y), threeHalves));
+                __m512 f = _mm512_maskz_mul_ps(live, _mm512_mul_ps(mj, y), _mm512_mul_ps(y, y));
+                fax[r] = _mm512_fmadd_ps(f, dx, fax[r]);
+                fay[r] = _mm512_fmadd_ps(f, dy, fay[r]);
+                faz[r] = _mm512_fmadd_ps(f, dz, faz[r]);
+            }
+        }
+        for (size_t r = 0; r < R; ++r) {
+            dax[r] = _mm512_add_pd(dax[r], widenAvx512(fax[r]));
+            day[r] = _mm512_add_pd(day[r], widenAvx512(fay[r]));
+            daz[r] = _mm512_add_pd(daz[r], widenAvx512(faz[r]));
+        }
+    }
+    for (size_t r = 0; r < R; ++r) {
+        acc[r][0] += _mm512_reduce_add_pd(dax[r]);
+        acc[r][1] += _mm512_reduce_add_pd(day[r]);
+        acc[r][2] += _mm512_reduce_add_pd(daz[r]);
+    }
+}
+
+NBODY_TARGET_AVX512 static void symmetricAvx512(const SourceSet& s, const AccelSet& out, size_t begin, size_t end, double G) {
+    const __m512d g = _mm512_set1_pd(G);
+
+    for (size_t i = begin; i < end; ++i) {
+        const __m512d xi = _mm512_set1_pd(s.x[i]);
+        const __m512d yi = _mm512_set1_pd(s.y[i]);
+        const __m512d zi = _mm512_set1_pd(s.z[i]);
+        const __m512d mi = _mm512_set1_pd(s.m[i]);
+        __m512d ax = _mm512_setzero_pd(), ay = _mm512_setzero_pd(), az = _mm512_setzero_pd();
+
+        for (size_t j = i + 1; j < s.n; j += 8) {
+            const size_t rem = s.n - j;
+            const __mmask8 lanes = rem >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << rem) - 1u);
+            __m512d dx = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, s.x + j), xi);
+            __m512d dy = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, s.y + j), yi);
+            __m512d dz = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, s.z + j), zi);
+            __m512d mj = _mm512_maskz_loadu_pd(lanes, s.m + j);
+            __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+            __m512d f = _mm512_mul_pd(g, invCubeAvx512(lanes, r2));
+            __m512d fi = _mm512_mul_pd(f, mj);
+            __m512d fj = _mm512_mul_pd(f, mi);
+            ax = _mm512_fmadd_pd(fi, dx, ax);
+            ay = _mm512_fmadd_pd(fi, dy, ay);
+            az = _mm512_fmadd_pd(fi, dz, az);
+            _mm512_mask_storeu_pd(out.ax + j, lanes, _mm512_fnmadd_pd(fj, dx, _mm512_maskz_loadu_pd(lanes, out.ax + j)));
+            _mm512_mask_storeu_pd(out.ay + j, lanes, _mm512_fnmadd_pd(fj, dy, _mm512_maskz_loadu_pd(lanes, out.ay + j)));
+            _mm512_mask_storeu_pd(out.az + j, lanes, _mm512_fnmadd_pd(fj, dz, _mm512_maskz_loadu_pd(lanes, out.az + j)));
+        }
+
+        out.ax[i] += _mm512_reduce_add_pd(ax);
+        out.ay[i] += _mm512_reduce_add_pd(ay);
+        out.az[i] += _mm512_reduce_add_pd(az);
+    }
+}
+
+NBODY_TARGET_AVX512 static inline void jerkPairAvx512(__mmask8 lanes, const __m512d* tgt, const __m512d* src,
+                                                      __m512d mj, __m512d* acc) {
+    __m512d dx = _mm512_sub_pd(src[0], tgt[0]);
+    __m512d dy = _mm512_sub_pd(src[1], tgt[1]);
+    __m512d dz = _mm512_sub_pd(src[2], tgt[2]);
+    __m512d dvx = _mm512_sub_pd(src[3], tgt[3]);
+    __m512d dvy = _mm512_sub_pd(src[4], tgt[4]);
+    __m512d dvz = _mm512_sub_pd(src[5], tgt[5]);
+    __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+    __mmask8 live = _mm512_mask_cmp_pd_mask(lanes, r2, _mm512_setzero_pd(), _CMP_GT_OQ);
+    // rsqrt14 estimate and two Newton steps, as in invCubeAvx512.
+    const __m512d threeHalves = _mm512_set1_pd(1.5);
+    __m512d h = _mm512_mul_pd(_mm512_set1_pd(0.5), r2);
+    __m512d y = _mm512_rsqrt14_pd(r2);
+    y = _mm512_mul_pd(y, _mm512_fnmadd_pd(h, _mm512_mul_pd(y, y), threeHalves));
+    y = _mm512_mul_pd(y, _mm512_fnmadd_pd(h, _mm512_mul_pd(y, y), threeHalves));
+    y = _mm512_maskz_mov_pd(live, y);
+    __m512d inv2 = _mm512_mul_pd(y, y);
+    __m512d f = _mm512_mul_pd(mj, _mm512_mul_pd(inv2, y));
+    __m512d rv = _mm512_fmadd_pd(dx, dvx, _mm512_fmadd_pd(dy, dvy, _mm512_mul_pd(dz, dvz)));
+    rv = _mm512_mul_pd(_mm512_set1_pd(3.0), _mm512_mul_pd(rv, inv2));
+    acc[0] = _mm512_fmadd_pd(f, dx, acc[0]);
+    acc[1] = _mm512_fmadd_pd(f, dy, acc[1]);
+    acc[2] = _mm512_fmadd_pd(f, dz, acc[2]);
+    acc[3] = _mm512_fmadd_pd(f, _mm512_fnmadd_pd(rv, dx, dvx), acc[3]);
+    acc[4] = _mm512_fmadd_pd(f, _mm512_fnmadd_pd(rv, dy, dvy), acc[4]);
+    acc[5] = _mm512_fmadd_pd(f, _mm512_fnmadd_pd(rv, dz, dvz), acc[5]);
+}
+
+NBODY_TARGET_AVX512 static void jerkAvx512(const PhaseSourceSet& s, const PhaseTargetSet& t, size_t begin, size_t end, double G) {
+    const size_t nv = s.n & ~size_t(7);
+    const __mmask8 tail = (__mmask8)((1u << (s.n - nv)) - 1u);
+    const double* cols[6] = {s.x, s.y, s.z, s.vx, s.vy, s.vz};
+
+    for (size_t i = begin; i < end; ++i) {
+        const __m512d tgt[6] = {_mm512_set1_pd(t.x[i]), _mm512_set1_pd(t.y[i]), _mm512_set1_pd(t.z[i]),
+                                _mm512_set1_pd(t.vx[i]), _mm512_set1_pd(t.vy[i]), _mm512_set1_pd(t.vz[i])};
+        __m512d acc[6];
+        for (int c = 0; c < 6; ++c) acc[c] = _mm512_setzero_pd();
+
+        __m512d src[6];
+        for (size_t j = 0; j < nv; j += 8) {
+            for (int c = 0; c < 6; ++c) src[c] = _mm512_loadu_pd(cols[c] + j);
+            jerkPairAvx512(0xFF, tgt, src, _mm512_loadu_pd(s.m + j), acc);
+        }
+        if (tail) {
+            for (int c = 0; c < 6; ++c) src[c] = _mm512_maskz_loadu_pd(tail, cols[c] + nv);
+            jerkPairAvx512(tail, tgt, src, _mm512_maskz_loadu_pd(tail, s.m + nv), acc);
+        }
+
+        t.ax[i] += G * _mm512_reduce_add_pd(acc[0]);
+        t.ay[i] += G * _mm512_reduce_add_pd(acc[1]);
+        t.az[i] += G * _mm512_reduce_add_pd(acc[2]);
+        t.jx[i] += G * _mm512_reduce_add_pd(acc[3]);
+        t.jy[i] += G * _mm512_reduce_add_pd(acc[4]);
+        t.jz[i] += G * _mm512_reduce_add_pd(acc[5]);
+    }
+}
+
+// Bin index (biased exponent) and signed significand of four terms, as
+// BinnedKulischAccumulator::add splits them; the touched range of nonzero
+// terms widens lo/hi. False if a term is infinite or NaN.
+NBODY_TARGET_AVX2 static inline bool splitTermsAvx2(__m256d v, uint64_t* bin, int64_t* sig, __m256i& lo, __m256i& hi) {
+    const __m256i b = _mm256_castpd_si256(v);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ex = _mm256_and_si256(_mm256_srli_epi64(b, 52), _mm256_set1_epi64x(0x7ff));
+    const __m256i hidden = _mm256_andnot_si256(_mm256_cmpeq_epi64(ex, zero), _mm256_set1_epi64x(int64_t(1) << 52));
+    __m256i m = _mm256_or_si256(_mm256_and_si256(b, _mm256_set1_epi64x((int64_t(1) << 52) - 1)), hidden);
+    const __m256i neg = _mm256_cmpgt_epi64(zero, b);
+    m = _mm256_sub_epi64(_mm256_xor_si256(m, neg), neg);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(bin), ex);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sig), m);
+    const __m256i nz = _mm256_xor_si256(_mm256_cmpeq_epi64(m, zero), _mm256_set1_epi64x(-1));
+    lo = _mm256_blendv_epi8(lo, ex, _mm256_and_si256(nz, _mm256_cmpgt_epi64(lo, ex)));
+    hi = _mm256_blendv_epi8(hi, ex, _mm256_and_si256(nz, _mm256_cmpgt_epi64(ex, hi)));
+    return _mm256_testz_si256(_mm256_cmpeq_epi64(ex, _mm256_set1_epi64x(0x7ff)), _mm256_set1_epi64x(-1));
+}
+
+NBODY_TARGET_AVX2 static inline void flushBinsAvx2(BinnedKulischAccumulator& acc, __m256i lo, __m256i hi) {
+    alignas(32) uint64_t l[4], h[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(l), lo);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(h), hi);
+    acc.flushBins(unsigned(std::min({l[0], l[1], l[2], l[3]})), unsigned(std::max({h[0], h[1], h[2], h[3]})));
+}
+
+NBODY_TARGET_AVX2 static inline void twoSumAvx2(__m256d& s, __m256d& c, __m256d& b, __m256d x) {
+    const __m256d t = _mm256_add_pd(s, x);
+    const __m256d z = _mm256_sub_pd(t, s);
+    const __m256d e = _mm256_add_pd(_mm256_sub_pd(s, _mm256_sub_pd(t, z)), _mm256_sub_pd(x, z));
+    s = t;
+    c = _mm256_add_pd(c, e);
+    b = _mm256_add_pd(b, _mm256_andnot_pd(_mm256_set1_pd(-0.0), e));
+}
+
+// m_j / r^3 for a slice of sources, 0 for coincident pairs.
+NBODY_TARGET_AVX2 static inline __m256d exactForceAvx2(__m256d xj, __m256d yj, __m256d zj, __m256d mj, __m256d xi,
+                                                       __m256d yi, __m256d zi, __m256d& dx, __m256d& dy, __m256d& dz) {
+    dx = _mm256_sub_pd(xj, xi);
+    dy = _mm256_sub_pd(yj, yi);
+    dz = _mm256_sub_pd(zj, zi);
+    const __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+    const __m256d f = _mm256_div_pd(mj, _mm256_mul_pd(r2, _mm256_sqrt_pd(r2)));
+    return _mm256_and_pd(_mm256_cmp_pd(r2, _mm256_setzero_pd(), _CMP_GT_OQ), f);
+}
+
+// Binned Kulisch sums of the SIMD slices of sources: terms are split in
+// registers and only the bin adds run scalar; chunks of kExactChunk
+// sources stay within the bins' flush interval.
+NBODY_TARGET_AVX2 static void binnedAvx2(const SourceSet& s, size_t nv, __m256d xi, __m256d yi, __m256d zi,
+                                         ExactSums& q) {
+    alignas(32) double tx[4], ty[4], tz[4];
+    alignas(32) uint64_t bx[4], by[4], bz[4];
+    alignas(32) int64_t sx[4], sy[4], sz[4];
+    int64_t* const binX = q.x.bins();
+    int64_t* const binY = q.y.bins();
+    int64_t* const binZ = q.z.bins();
+    for (size_t jb = 0; jb < nv; jb += kExactChunk) {
+        const size_t je = std::min(nv, jb + kExactChunk);
+        const __m256i empty = _mm256_set1_epi64x(BinnedKulischAccumulator::kBins);
+        __m256i loX = empty, loY = empty, loZ = empty;
+        __m256i hiX = _mm256_setzero_si256(), hiY = hiX, hiZ = hiX;
+        for (size_t j = jb; j < je; j += 4) {
+            __m256d dx, dy, dz;
+            const __m256d f = exactForceAvx2(_mm256_loadu_pd(s.x + j), _mm256_loadu_pd(s.y + j),
+                                             _mm256_loadu_pd(s.z + j), _mm256_loadu_pd(s.m + j), xi, yi, zi, dx, dy, dz);
+            const __m256d fx = _mm256_mul_pd(f, dx), fy = _mm256_mul_pd(f, dy), fz = _mm256_mul_pd(f, dz);
+            const bool finite = splitTermsAvx2(fx, bx, sx, loX, hiX) & splitTermsAvx2(fy, by, sy, loY, hiY) &
+                                splitTermsAvx2(fz, bz, sz, loZ, hiZ);
+            if (!finite) {
+                _mm256_store_pd(tx, fx);
+                _mm256_store_pd(ty, fy);
+                _mm256_store_pd(tz, fz);
+                exactTerms(q, tx, ty, tz, 4);
+                continue;
+            }
+            for (size_t l = 0; l < 4; ++l) {
+                binX[bx[l]] += sx[l];
+                binY[by[l]] += sy[l];
+                binZ[bz[l]] += sz[l];
+            }
+        }
+        flushBinsAvx2(q.x, loX, hiX);
+        flushBinsAvx2(q.y, loY, hiY);
+        flushBinsAvx2(q.z, loZ, hiZ);
+    }
+}
+
+NBODY_TARGET_AVX2 static void exactAvx2(const SourceSet& s, const TargetSet& t, size_t begin, size_t end, double G) {
+    ExactSums& q = t_exact;
+    const size_t nv = s.n & ~size_t(3);
+    const size_t rem = s.n - nv;
+    // Masked-off sources load as zero mass and add zero terms.
+    const __m256i tailMask = _mm256_cmpgt_epi64(_mm256_set1_epi64x((long long)rem),
+                                                _mm256_setr_epi64x(0, 1, 2, 3));
+    const __m256d zero = _mm256_setzero_pd();
+
+    for (size_t i = begin; i < end; ++i) {
+        const __m256d xi = _mm256_set1_pd(t.x[i]);
+        const __m256d yi = _mm256_set1_pd(t.y[i]);
+        const __m256d zi = _mm256_set1_pd(t.z[i]);
+        __m256d sX = zero, cX = zero, bX = zero;
+        __m256d sY = zero, cY = zero, bY = zero;
+        __m256d sZ = zero, cZ = zero, bZ = zero;
+        // fmas with +0 round the terms on their own; see roundedProduct.
+        __m256d dx, dy, dz;
+        for (size_t j = 0; j < nv; j += 4) {
+            const __m256d f = exactForceAvx2(_mm256_loadu_pd(s.x + j), _mm256_loadu_pd(s.y + j),
+                                             _mm256_loadu_pd(s.z + j), _mm256_loadu_pd(s.m + j), xi, yi, zi, dx, dy, dz);
+            twoSumAvx2(sX, cX, bX, _mm256_fmadd_pd(f, dx, zero));
+            twoSumAvx2(sY, cY, bY, _mm256_fmadd_pd(f, dy, zero));
+            twoSumAvx2(sZ, cZ, bZ, _mm256_fmadd_pd(f, dz, zero));
+        }
+        if (rem) {
+            const __m256d f = exactForceAvx2(_mm256_maskload_pd(s.x + nv, tailMask), _mm256_maskload_pd(s.y + nv, tailMask),
+                                             _mm256_maskload_pd(s.z + nv, tailMask), _mm256_maskload_pd(s.m + nv, tailMask),
+                                             xi, yi, zi, dx, dy, dz);
+            twoSumAvx2(sX, cX, bX, _mm256_fmadd_pd(f, dx, zero));
+            twoSumAvx2(sY, cY, bY, _mm256_fmadd_pd(f, dy, zero));
+            twoSumAvx2(sZ, cZ, bZ, _mm256_fmadd_pd(f, dz, zero));
+        }
+        CompensatedSum acc[3];
+        _mm256_storeu_pd(acc[0].s, sX); _mm256_storeu_pd(acc[0].c, cX); _mm256_storeu_pd(acc[0].b, bX);
+        _mm256_storeu_pd(acc[1].s, sY); _mm256_storeu_pd(acc[1].c, cY); _mm256_storeu_pd(acc[1].b, bY);
+        _mm256_storeu_pd(acc[2].s, sZ); _mm256_storeu_pd(acc[2].c, cZ); _mm256_storeu_pd(acc[2].b, bZ);
+        if (finishCompensated(acc, 4, s.n, t, i, G)) continue;
+
+        q.x.clear(); q.y.clear(); q.z.clear();
+        binnedAvx2(s, nv, xi, yi, zi, q);
+        exactPairsScalar(s, nv, s.n, t.x[i], t.y[i], t.z[i], q);
+        finishExact(q, t, i, G);
+    }
+}
+
+// AVX-512 form of splitTermsAvx2, for eight terms.
+NBODY_TARGET_AVX512 static inline bool splitTermsAvx512(__m512d v, uint64_t* bin, int64_t* sig, __m512i& lo, __m512i& hi) {
+    const __m512i b = _mm512_castpd_si512(v);
+    const __m512i ex = _mm512_and_si512(_mm512_srli_epi64(b, 52), _mm512_set1_epi64(0x7ff));
+    __m512i m = _mm512_and_si512(b, _mm512_set1_epi64((int64_t(1) << 52) - 1));
+    m = _mm512_mask_or_epi64(m, _mm512_test_epi64_mask(ex, ex), m, _mm512_set1_epi64(int64_t(1) << 52));
+    const __m512i neg = _mm512_srai_epi64(b, 63);
+    m = _mm512_sub_epi64(_mm512_xor_si512(m, neg), neg);
+    _mm512_store_si512(bin, ex);
+    _mm512_store_si512(sig, m);
+    const __mmask8 nz = _mm512_test_epi64_mask(m, m);
+    lo = _mm512_mask_min_epu64(lo, nz, lo, ex);
+    hi = _mm512_mask_max_epu64(hi, nz, hi, ex);
+    return _mm512_cmpeq_epi64_mask(ex, _mm512_set1_epi64(0x7ff)) == 0;
+}
+
+NBODY_TARGET_AVX512 static inline void twoSumAvx512(__m512d& s, __m512d& c, __m512d& b, __m512d x) {
+    const __m512d t = _mm512_add_pd(s, x);
+    const __m512d z = _mm512_sub_pd(t, s);
+    const __m512d e = _mm512_add_pd(_mm512_sub_pd(s, _mm512_sub_pd(t, z)), _mm512_sub_pd(x, z));
+    s = t;
+    c = _mm512_add_pd(c, e);
+    b = _mm512_add_pd(b, _mm512_abs_pd(e));
+}
+
+NBODY_TARGET_AVX512 static inline __m512d exactForceAvx512(__m512d xj, __m512d yj, __m512d zj, __m512d mj,
+                                                           __m512d xi, __m512d yi, __m512d zi, __m512d& dx,
+                                                           __m512d& dy, __m512d& dz) {
+    dx = _mm512_sub_pd(xj, xi);
+    dy = _mm512_sub_pd(yj, yi);
+    dz = _mm512_sub_pd(zj, zi);
+    const __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+    const __m512d f = _mm512_div_pd(mj, _mm512_mul_pd(r2, _mm512_sqrt_pd(r2)));
+    return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(r2, _mm512_setzero_pd(), _CMP_GT_OQ), f);
+}
+
+NBODY_TARGET_AVX512 static void binnedAvx512(const SourceSet& s, size_t nv, __m512d xi, __m512d yi, __m512d zi,
+                                             ExactSums& q) {
+    alignas(64) double tx[8], ty[8], tz[8];
+    alignas(64) uint64_t bx[8], by[8], bz[8];
+    alignas(64) int64_t sx[8], sy[8], sz[8];
+    int64_t* const binX = q.x.bins();
+    int64_t* const binY = q.y.bins();
+    int64_t* const binZ = q.z.bins();
+    for (size_t jb = 0; jb < nv; jb += kExactChunk) {
+        const size_t je = std::min(nv, jb + kExactChunk);
+        const __m512i empty = _mm512_set1_epi64(BinnedKulischAccumulator::kBins);
+        __m512i loX = empty, loY = empty, loZ = empty;
+        __m512i hiX = _mm512_setzero_si512(), hiY = hiX, hiZ = hiX;
+        for (size_t j = jb; j < je; j += 8) {
+            __m512d dx, dy, dz;
+            const __m512d f = exactForceAvx512(_mm512_loadu_pd(s.x + j), _mm512_loadu_pd(s.y + j),
+                                               _mm512_loadu_pd(s.z + j), _mm512_loadu_pd(s.m + j), xi, yi, zi, dx, dy,
+                                               dz);
+            const __m512d fx = _mm512_mul_pd(f, dx), fy = _mm512_mul_pd(f, dy), fz = _mm512_mul_pd(f, dz);
+            const bool finite = splitTermsAvx512(fx, bx, sx, loX, hiX) & splitTermsAvx512(fy, by, sy, loY, hiY) &
+                                splitTermsAvx512(fz, bz, sz, loZ, hiZ);
+            if (!finite) {
+                _mm512_store_pd(tx, fx);
+                _mm512_store_pd(ty, fy);
+                _mm512_store_pd(tz, fz);
+                exactTerms(q, tx, ty, tz, 8);
+                continue;
+            }
+            for (size_t l = 0; l < 8; ++l) {
+                binX[bx[l]] += sx[l];
+                binY[by[l]] += sy[l];
+                binZ[bz[l]] += sz[l];
+            }
+        }
+        q.x.flushBins(unsigned(_mm512_reduce_min_epu64(loX)), unsigned(_mm512_reduce_max_epu64(hiX)));
+        q.y.flushBins(unsigned(_mm512_reduce_min_epu64(loY)), unsigned(_mm512_reduce_max_epu64(hiY)));
+        q.z.flushBins(unsigned(_mm512_reduce_min_epu64(loZ)), unsigned(_mm512_reduce_max_epu64(hiZ)));
+    }
+}
+
+NBODY_TARGET_AVX512 static void exactAvx512(const SourceSet& s, const TargetSet& t, size_t begin, size_t end, double G) {
+    ExactSums& q = t_exact;
+    const size_t nv = s.n & ~size_t(7);
+    const __mmask8 tail = (__mmask8)((1u << (s.n - nv)) - 1u);
+    const __m512d zero = _mm512_setzero_pd();
+
+    for (size_t i = begin; i < end; ++i) {
+        const __m512d xi = _mm512_set1_pd(t.x[i]);
+        const __m512d yi = _mm512_set1_pd(t.y[i]);
+        const __m512d zi = _mm512_set1_pd(t.z[i]);
+        __m512d sX = zero, cX = zero, bX = zero;
+        __m512d sY = zero, cY = zero, bY = zero;
+        __m512d sZ = zero, cZ = zero, bZ = zero;
+        __m512d dx, dy, dz;
+        for (size_t j = 0; j < nv; j += 8) {
+            const __m512d f = exactForceAvx512(_mm512_loadu_pd(s.x + j), _mm512_loadu_pd(s.y + j),
+                                               _mm512_loadu_pd(s.z + j), _mm512_loadu_pd(s.m + j), xi, yi, zi, dx, dy,
+                                               dz);
+            twoSumAvx512(sX, cX, bX, _mm512_fmadd_pd(f, dx, zero));
+            twoSumAvx512(sY, cY, bY, _mm512_fmadd_pd(f, dy, zero));
+            twoSumAvx512(sZ, cZ, bZ, _mm512_fmadd_pd(f, dz, zero));
+        }
+        if (tail) {
+            const __m512d f = exactForceAvx512(_mm512_maskz_loadu_pd(tail, s.x + nv), _mm512_maskz_loadu_pd(tail, s.y + nv),
+                                               _mm512_maskz_loadu_pd(tail, s.z + nv), _mm512_maskz_loadu_pd(tail, s.m + nv),
+                                               xi, yi, zi, dx, dy, dz);
+            twoSumAvx512(sX, cX, bX, _mm512_fmadd_pd(f, dx, zero));
+            twoSumAvx512(sY, cY, bY, _mm512_fmadd_pd(f, dy, zero));
+            twoSumAvx512(sZ, cZ, bZ, _mm512_fmadd_pd(f, dz, zero));
+        }
+        CompensatedSum acc[3];
+        _mm512_storeu_pd(acc[0].s, sX); _mm512_storeu_pd(acc[0].c, cX); _mm512_storeu_pd(acc[0].b, bX);
+        _mm512_storeu_pd(acc[1].s, sY); _mm512_storeu_pd(acc[1].c, cY); _mm512_storeu_pd(acc[1].b, bY);
+        _mm512_storeu_pd(acc[2].s, sZ); _mm512_storeu_pd(acc[2].c, cZ); _mm512_storeu_pd(acc[2].b, bZ);
+        if (finishCompensated(acc, 8, s.n, t, i, G)) continue;
+
+        q.x.clear(); q.y.clear(); q.z.clear();
+        binnedAvx512(s, nv, xi, yi, zi, q);
+        exactPairsScalar(s, nv, s.n, t.x[i], t.y[i], t.z[i], q);
+        finishExact(q, t, i, G);
+    }
+}
+
+#endif
+
+template <bool Shaped>
+static void dispatchDirect(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                           size_t begin, size_t end, double G, const PairShape& shape) {
+    switch (resolve(kernel)) {
+#if NBODY_X86_SIMD
+        case ForceKernel::Avx512: directAvx512<Shaped>(src, dst, begin, end, G, shape); return;
+        case ForceKernel::Avx2:   directAvx2<Shaped>(src, dst, begin, end, G, shape); return;
+#endif
+        default:                  directScalar<Shaped>(src, dst, begin, end, G, shape); return;
+    }
+}
+
+void accumulateDirect(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                      size_t begin, size_t end, double G, const PairShape* shape) {
+    if (shape)
+        dispatchDirect<true>(kernel, src, dst, begin, end, G, *shape);
+    else
+        dispatchDirect<false>(kernel, src, dst, begin, end, G, PairShape{});
+}
+
+void accumulateTiled(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                     size_t begin, size_t end, double G, const TileConfig& tiles) {
+    kernel = resolve(kernel);
+    const size_t ti = std::max<size_t>(tiles.i, 4);
+    const size_t tj = std::max<size_t>((tiles.j + 7) & ~size_t(7), 8);
+    for (size_t ib = begin; ib < end; ib += ti) {
+        const size_t ie = std::min(end, ib + ti);
+        for (size_t jb = 0; jb < src.n; jb += tj) {
+            const size_t je = std::min(src.n, jb + tj);
+            switch (kernel) {
+#if NBODY_X86_SIMD
+                case ForceKernel::Avx512: tileAvx512(src, jb, je, dst, ib, ie, G); break;
+                case ForceKernel::Avx2:   tileAvx2(src, jb, je, dst, ib, ie, G); break;
+#endif
+                default: {
+                    const SourceSet tile{src.x + jb, src.y + jb, src.z + jb, src.m + jb, je - jb};
+                    directScalar<false>(tile, dst, ib, ie, G, PairShape{});
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void accumulateMixed(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                     size_t begin, size_t end, double G) {
+    if (src.n == 0 || begin >= end) return;
+    kernel = resolve(kernel);
+
+    double lo[3] = {src.x[0], src.y[0], src.z[0]};
+    double hi[3] = {lo[0], lo[1], lo[2]};
+    double maxMass = 0.0;
+    auto grow = [&](double x, double y, double z) {
+        lo[0] = std::min(lo[0], x); hi[0] = std::max(hi[0], x);
+        lo[1] = std::min(lo[1], y); hi[1] = std::max(hi[1], y);
+        lo[2] = std::min(lo[2], z); hi[2] = std::max(hi[2], z);
+    };
+    for (size_t j = 0; j < src.n; ++j) {
+        grow(src.x[j], src.y[j], src.z[j]);
+        maxMass = std::max(maxMass, std::fabs(src.m[j]));
+    }
+    int eM = 0;
+    std::frexp(maxMass, &eM);
+    const double invM = std::ldexp(1.0, -eM);
+
+    // Blocks sit at multiples of kMixedBlock whatever [begin, end) is, and
+    // each block's reference point and length scale come from the sources
+    // and the block's first target alone, so a target's result ignores the
+    // split. Targets are body positions, inside the source box.
+    MixedSources& s = t_mixed;
+    for (size_t ib = begin; ib < end;) {
+        const size_t base = ib / kMixedBlock * kMixedBlock;
+        const size_t ie = std::min(end, base + kMixedBlock);
+        const double rx = dst.x[base], ry = dst.y[base], rz = dst.z[base];
+        const double blo[3] = {std::min(lo[0], rx), std::min(lo[1], ry), std::min(lo[2], rz)};
+        const double bhi[3] = {std::max(hi[0], rx), std::max(hi[1], ry), std::max(hi[2], rz)};
+        int eL = 0;
+        std::frexp(std::max({bhi[0] - blo[0], bhi[1] - blo[1], bhi[2] - blo[2]}), &eL);
+        const double invL = std::ldexp(1.0, -eL);
+        const double scale = G * std::ldexp(1.0, eM - 2 * eL);
+        convertSources(src, rx, ry, rz, invL, invM, s);
+        float xi[kMixedBlock], yi[kMixedBlock], zi[kMixedBlock];
+        double acc[kMixedBlock][3] = {};
+        for (size_t i = ib; i < ie; ++i) {
+            xi[i - ib] = float((dst.x[i] - rx) * invL);
+            yi[i - ib] = float((dst.y[i] - ry) * invL);
+            zi[i - ib] = float((dst.z[i] - rz) * invL);
+        }
+        // Four targets per pass on the SIMD paths, as in the tiled kernel.
+        const size_t rows = ie - ib;
+        size_t r = 0;
+        switch (kernel) {
+#if NBODY_X86_SIMD
+            case ForceKernel::Avx512:
+                for (; r + kRows <= rows; r += kRows) mixedAvx512<kRows>(s, xi + r, yi + r, zi + r, acc + r);
+                for (; r < rows; ++r) mixedAvx512<1>(s, xi + r, yi + r, zi + r, acc + r);
+                break;
+            case ForceKernel::Avx2:
+                for (; r + kRows <= rows; r += kRows) mixedAvx2<kRows>(s, xi + r, yi + r, zi + r, acc + r);
+                for (; r < rows; ++r) mixedAvx2<1>(s, xi + r, yi + r, zi + r, acc + r);
+                break;
+#endif
+            default:
+                for (; r < rows; ++r) mixedScalar(s, xi[r], yi[r], zi[r], acc[r]);
+                break;
+        }
+        for (size_t i = ib; i < ie; ++i) {
+            dst.ax[i] += scale * acc[i - ib][0];
+            dst.ay[i] += scale * acc[i - ib][1];
+            dst.az[i] += scale * acc[i - ib][2];
+        }
+        ib = ie;
+    }
+}
+
+void accumulateExact(ForceKernel kernel, const SourceSet& src, const TargetSet& dst,
+                     size_t begin, size_t end, double G) {
+    switch (resolve(kernel)) {
+#if NBODY_X86_SIMD
+        case ForceKernel::Avx512: exactAvx512(src, dst, begin, end, G); return;
+        case ForceKernel::Avx2:   exactAvx2(src, dst, begin, end, G); return;
+#endif
+        default:                  exactScalar(src, dst, begin, end, G); return;
+    }
+}
+
+void accumulateSymmetric(ForceKernel kernel, const SourceSet& bodies, const AccelSet& out,
+                         size_t begin, size_t end, double G) {
+    switch (resolve(kernel)) {
+#if NBODY_X86_SIMD
+        case ForceKernel::Avx512: symmetricAvx512(bodies, out, begin, end, G); return;
+        case ForceKernel::Avx2:   symmetricAvx2(bodies, out, begin, end, G); return;
+#endif
+        default:                  symmetricScalar(bodies, out, begin, end, G); return;
+    }
+}
+
+void accumulateJerk(ForceKernel kernel, const PhaseSourceSet& src, const PhaseTargetSet& dst,
+                    size_t begin, size_t end, double G) {
+    switch (resolve(kernel)) {
+#if NBODY_X86_SIMD
+        case ForceKernel::Avx512: jerkAvx512(src, dst, begin, end, G); return;
+        case ForceKernel::Avx2:   jerkAvx2(src, dst, begin, end, G); return;
+#endif
+        default:                  jerkScalar(src, dst, begin, end, G); return;
+    }
+}
+
+size_t triangleRowSplit(size_t n, size_t parts, size_t k) {
+    if (k == 0 || n < 2) return 0;
+    if (k >= parts) return n;
+
+    // Rows before r hold r(n-1) - r(r-1)/2 pairs; find the first row whose
+    // prefix reaches k/parts of the total.
+    const double total = 0.5 * double(n) * double(n - 1);
+    const double want = total * double(k) / double(parts);
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t r = (lo + hi) / 2;
+        double before = double(r) * double(n - 1) - 0.5 * double(r) * double(r - 1);
+        if (before < want) lo = r + 1;
+        else hi = r;
+    }
+    return lo;
+}
+
+}
@@ -0,0 +1,140 @@
+// src/hermite.cpp
+#include "physics/hermite.hpp"
+#include <algorithm>
+#include <cmath>
+
+static double norm(double x, double y, double z) {
+    return std::sqrt(x * x + y * y + z * z);
+}
+
+void HermiteIntegrator::predict(const BodyStorage& bodies, uint64_t tick, double tickLength, ThreadPool& pool) {
+    pool.parallelFor(0, bodies.size(), 4096, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            const double h = double(tick - m_time[i]) * tickLength;
+            const double h2 = 0.5 * h * h, h3 = h * h2 / 3.0;
+            m_px[i] = bodies.x[i] + h * bodies.vx[i] + h2 * bodies.ax[i] + h3 * m_jx[i];
+            m_py[i] = bodies.y[i] + h * bodies.vy[i] + h2 * bodies.ay[i] + h3 * m_jy[i];
+            m_pz[i] = bodies.z[i] + h * bodies.vz[i] + h2 * bodies.az[i] + h3 * m_jz[i];
+            m_pvx[i] = bodies.vx[i] + h * bodies.ax[i] + h2 * m_jx[i];
+            m_pvy[i] = bodies.vy[i] + h * bodies.ay[i] + h2 * m_jy[i];
+            m_pvz[i] = bodies.vz[i] + h * bodies.az[i] + h2 * m_jz[i];
+        }
+    });
+}
+
+void HermiteIntegrator::evaluate(const BodyStorage& bodies, size_t count, double G,
+                                 ForceKernel kernel, ThreadPool& pool) {
+    for (auto* col : {&m_tx, &m_ty, &m_tz, &m_tvx, &m_tvy, &m_tvz,
+                      &m_ax, &m_ay, &m_az, &m_tjx, &m_tjy, &m_tjz})
+        col->resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        const uint32_t i = m_schedule.order[k];
+        m_tx[k] = m_px[i];   m_ty[k] = m_py[i];   m_tz[k] = m_pz[i];
+        m_tvx[k] = m_pvx[i]; m_tvy[k] = m_pvy[i]; m_tvz[k] = m_pvz[i];
+    }
+
+    PhaseSourceSet src{m_px.data(), m_py.data(), m_pz.data(), m_pvx.data(), m_pvy.data(), m_pvz.data(),
+                       bodies.mass.data(), bodies.size()};
+    PhaseTargetSet dst{m_tx.data(), m_ty.data(), m_tz.data(), m_tvx.data(), m_tvy.data(), m_tvz.data(),
+                       m_ax.data(), m_ay.data(), m_az.data(), m_tjx.data(), m_tjy.data(), m_tjz.data()};
+    const size_t grain = std::max<size_t>(16, count / (8 * pool.size()));
+    pool.parallelFor(0, count, grain, [&](size_t begin, size_t end, unsigned) {
+        for (double* col : {dst.ax, dst.ay, dst.az, dst.jx, dst.jy, dst.jz})
+            std::fill(col + begin, col + end, 0.0);
+        kernels::accumulateJerk(kernel, src, dst, begin, end, G);
+    });
+}
+
+void HermiteIntegrator::start(BodyStorage& bodies, double dt, double G, ForceKernel kernel, ThreadPool& pool) {
+    const size_t n = bodies.size();
+    m_schedule.maxLevel = m_params.maxLevel;
+    m_schedule.level.assign(n, 0);
+    m_schedule.sort();
+    m_time.assign(n, 0);
+    for (auto* col : {&m_jx, &m_jy, &m_jz, &m_px, &m_py, &m_pz, &m_pvx, &m_pvy, &m_pvz})
+        col->assign(n, 0.0);
+
+    std::fill(bodies.ax.begin(), bodies.ax.end(), 0.0);
+    std::fill(bodies.ay.begin(), bodies.ay.end(), 0.0);
+    std::fill(bodies.az.begin(), bodies.az.end(), 0.0);
+    predict(bodies, 0, 0.0, pool);
+    evaluate(bodies, n, G, kernel, pool);
+
+    for (size_t k = 0; k < n; ++k) {
+        const uint32_t i = m_schedule.order[k];
+        bodies.ax[i] = m_ax[k]; bodies.ay[i] = m_ay[k]; bodies.az[i] = m_az[k];
+        m_jx[i] = m_tjx[k];     m_jy[i] = m_tjy[k];     m_jz[i] = m_tjz[k];
+        const double a = norm(m_ax[k], m_ay[k], m_az[k]);
+        const double j = norm(m_tjx[k], m_tjy[k], m_tjz[k]);
+        const double step = j > 0.0 ? m_params.etaStart * a / j : HUGE_VAL;
+        m_schedule.level[i] = uint8_t(m_schedule.levelFor(step, dt));
+    }
+    m_schedule.sort();
+}
+
+void HermiteIntegrator::step(BodyStorage& bodies, double dt, double G, const HermiteParams& params,
+                             ForceKernel kernel, ThreadPool& pool, BlockTimestepStats& stats) {
+    const size_t n = bodies.size();
+    stats = BlockTimestepStats{};
+    if (n == 0) return;
+    if (m_schedule.level.size() != n) {
+        m_params = params;
+        m_params.maxLevel = std::clamp(m_params.maxLevel, 0, 30);
+        start(bodies, dt, G, kernel, pool);
+    }
+
+    const uint64_t ticks = m_schedule.ticks();
+    const double tick = dt / double(ticks);
+    uint64_t t = 0;
+    while (t < ticks) {
+        t += m_schedule.stepTicks(m_schedule.finest());
+        const size_t count = m_schedule.dueAt(t);
+        predict(bodies, t, tick, pool);
+        evaluate(bodies, count, G, kernel, pool);
+        ++stats.substeps;
+        stats.activeTargets += count;
+
+        bool moved = false;
+        for (size_t k = 0; k < count; ++k) {
+            const uint32_t i = m_schedule.order[k];
+            const double h = double(t - m_time[i]) * tick;
+            const double a1[3] = {m_ax[k], m_ay[k], m_az[k]};
+            const double j1[3] = {m_tjx[k], m_tjy[k], m_tjz[k]};
+            const double a0[3] = {bodies.ax[i], bodies.ay[i], bodies.az[i]};
+            const double j0[3] = {m_jx[i], m_jy[i], m_jz[i]};
+            const double p[3] = {m_px[i], m_py[i], m_pz[i]};
+            const double pv[3] = {m_pvx[i], m_pvy[i], m_pvz[i]};
+
+            // Snap and crackle at the start of the step from the Hermite
+            // interpolant through both endpoints.
+            double x[3], v[3], snap[3], crackle[3];
+            for (int c = 0; c < 3; ++c) {
+                const double da = a0[c] - a1[c];
+                const double s0 = (-6.0 * da - h * (4.0 * j0[c] + 2.0 * j1[c])) / (h * h);
+                crackle[c] = (12.0 * da + 6.0 * h * (j0[c] + j1[c])) / (h * h * h);
+                x[c] = p[c] + h * h * h * h * (s0 / 24.0 + h * crackle[c] / 120.0);
+                v[c] = pv[c] + h * h * h * (s0 / 6.0 + h * crackle[c] / 24.0);
+                snap[c] = s0 + h * crackle[c];
+            }
+            bodies.x[i] = x[0];  bodies.y[i] = x[1];  bodies.z[i] = x[2];
+            bodies.vx[i] = v[0]; bodies.vy[i] = v[1]; bodies.vz[i] = v[2];
+            bodies.ax[i] = a1[0]; bodies.ay[i] = a1[1]; bodies.az[i] = a1[2];
+            m_jx[i] = j1[0];      m_jy[i] = j1[1];      m_jz[i] = j1[2];
+            m_time[i] = t < ticks ? t : 0;
+
+            const double a = norm(a1[0], a1[1], a1[2]);
+            const double j = norm(j1[0], j1[1], j1[2]);
+            const double s = norm(snap[0], snap[1], snap[2]);
+            const double c = norm(crackle[0], crackle[1], crackle[2]);
+            const double den = j * c + s * s;
+            const double want = den > 0.0 ? std::sqrt(m_params.eta * (a * s + j * j) / den) : HUGE_VAL;
+            const int level = m_schedule.level[i];
+            const int next = m_schedule.next(level, want, dt, t);
+            if (next != level) {
+                m_schedule.level[i] = uint8_t(next);
+                moved = true;
+            }
+        }
+        if (moved) m_schedule.sort();
+    }
+}
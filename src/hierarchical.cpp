@@ -0,0 +1,154 @@
+// src/hierarchical.cpp
+#include "physics/hierarchical.hpp"
+#include <algorithm>
+#include <cmath>
+#include "physics/wisdom_holman.hpp"
+
+bool HierarchicalJacobi::resume(const BodyStorage& bodies, double G) const {
+    const size_t n = bodies.size();
+    if (n != m_n || G != m_G) return false;
+    for (size_t i = 0; i < n; ++i)
+        if (bodies.mass[i] != m_mass[i] ||
+            bodies.x[i] != m_outX[i] || bodies.y[i] != m_outY[i] || bodies.z[i] != m_outZ[i] ||
+            bodies.vx[i] != m_outVx[i] || bodies.vy[i] != m_outVy[i] || bodies.vz[i] != m_outVz[i])
+            return false;
+    return true;
+}
+
+void HierarchicalJacobi::load(const BodyStorage& bodies, double G) {
+    const size_t n = bodies.size();
+    m_n = n;
+    m_G = G;
+    m_nodes.clear();
+    m_mass.assign(bodies.mass.begin(), bodies.mass.end());
+
+    // Greedy pairing by shortest two-body period, P^2 ~ r^3 / M, with each
+    // subtree standing in as a point at its barycentre.
+    struct Item {
+        uint32_t id;
+        double mass, x, y, z;
+    };
+    std::vector<Item> items(n);
+    for (size_t i = 0; i < n; ++i) items[i] = {uint32_t(i), bodies.mass[i], bodies.x[i], bodies.y[i], bodies.z[i]};
+    while (items.size() > 1) {
+        size_t bestP = 0, bestQ = 1;
+        double best = HUGE_VAL;
+        for (size_t p = 0; p < items.size(); ++p)
+            for (size_t q = p + 1; q < items.size(); ++q) {
+                const double dx = items[q].x - items[p].x, dy = items[q].y - items[p].y, dz = items[q].z - items[p].z;
+                const double r2 = dx * dx + dy * dy + dz * dz;
+                const double period2 = r2 * std::sqrt(r2) / (items[p].mass + items[q].mass);
+                if (period2 < best) {
+                    best = period2;
+                    bestP = p;
+                    bestQ = q;
+                }
+            }
+        Item a = items[bestP], b = items[bestQ];
+        if (b.mass > a.mass) std::swap(a, b);
+        const double total = a.mass + b.mass;
+        m_nodes.push_back({a.id, b.id, a.mass, b.mass});
+        const Item merged{uint32_t(n + m_nodes.size() - 1), total, (a.mass * a.x + b.mass * b.x) / total,
+                          (a.mass * a.y + b.mass * b.y) / total, (a.mass * a.z + b.mass * b.z) / total};
+        items.erase(items.begin() + bestQ);
+        items[bestP] = merged;
+    }
+    for (const Node& node : m_nodes) m_mass.push_back(node.massA + node.massB);
+    m_values.resize(m_mass.size());
+
+    State& s = m_state;
+    const size_t slots = m_nodes.size() + 1;
+    for (auto* col : {&s.qx, &s.qy, &s.qz, &s.vx, &s.vy, &s.vz, &s.kx, &s.ky, &s.kz})
+        col->assign(slots, 0.0);
+    toTree(bodies.x.data(), s.qx.data());
+    toTree(bodies.y.data(), s.qy.data());
+    toTree(bodies.z.data(), s.qz.data());
+    toTree(bodies.vx.data(), s.vx.data());
+    toTree(bodies.vy.data(), s.vy.data());
+    toTree(bodies.vz.data(), s.vz.data());
+}
+
+// Barycentres bottom-up; each node keeps B - A. Accelerations transform
+// the same way: a_B - a_A is the acceleration of the node's separation.
+void HierarchicalJacobi::toTree(const double* col, double* q) {
+    std::copy(col, col + m_n, m_values.begin());
+    for (size_t k = 0; k < m_nodes.size(); ++k) {
+        const Node& node = m_nodes[k];
+        const double a = m_values[node.a], b = m_values[node.b];
+        m_values[m_n + k] = (node.massA * a + node.massB * b) / (node.massA + node.massB);
+        q[k + 1] = b - a;
+    }
+    q[0] = m_values.back();
+}
+
+void HierarchicalJacobi::fromTree(const double* q, double* col) {
+    m_values.back() = q[0];
+    for (size_t k = m_nodes.size(); k-- > 0;) {
+        const Node& node = m_nodes[k];
+        const double total = node.massA + node.massB;
+        const double centre = m_values[m_n + k];
+        m_values[node.a] = centre - node.massB / total * q[k + 1];
+        m_values[node.b] = centre + node.massA / total * q[k + 1];
+    }
+    std::copy(m_values.begin(), m_values.begin() + m_n, col);
+}
+
+void HierarchicalJacobi::record(const BodyStorage& bodies) {
+    m_outX.assign(bodies.x.begin(), bodies.x.end());
+    m_outY.assign(bodies.y.begin(), bodies.y.end());
+    m_outZ.assign(bodies.z.begin(), bodies.z.end());
+    m_outVx.assign(bodies.vx.begin(), bodies.vx.end());
+    m_outVy.assign(bodies.vy.begin(), bodies.vy.end());
+    m_outVz.assign(bodies.vz.begin(), bodies.vz.end());
+}
+
+void HierarchicalJacobi::writePositions(BodyStorage& bodies) {
+    fromTree(m_state.qx.data(), bodies.x.data());
+    fromTree(m_state.qy.data(), bodies.y.data());
+    fromTree(m_state.qz.data(), bodies.z.data());
+}
+
+void HierarchicalJacobi::writeState(BodyStorage& bodies) {
+    writePositions(bodies);
+    fromTree(m_state.vx.data(), bodies.vx.data());
+    fromTree(m_state.vy.data(), bodies.vy.data());
+    fromTree(m_state.vz.data(), bodies.vz.data());
+}
+
+void HierarchicalJacobi::kepler(double h, ThreadPool& pool) {
+    State& s = m_state;
+    s.qx[0] += h * s.vx[0];
+    s.qy[0] += h * s.vy[0];
+    s.qz[0] += h * s.vz[0];
+    pool.parallelFor(1, m_nodes.size() + 1, 64, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; ++k) {
+            const double mu = m_G * m_mass[m_n + k - 1];
+            keplerDrift(mu, h, s.qx[k], s.qy[k], s.qz[k], s.vx[k], s.vy[k], s.vz[k]);
+        }
+    });
+}
+
+void HierarchicalJacobi::kick(double h) {
+    State& s = m_state;
+    for (size_t k = 1; k < s.vx.size(); ++k) {
+        s.vx[k] += h * s.kx[k];
+        s.vy[k] += h * s.ky[k];
+        s.vz[k] += h * s.kz[k];
+    }
+}
+
+void HierarchicalJacobi::interaction(const BodyStorage& bodies) {
+    State& s = m_state;
+    toTree(bodies.ax.data(), s.kx.data());
+    toTree(bodies.ay.data(), s.ky.data());
+    toTree(bodies.az.data(), s.kz.data());
+
+    // Take out the Kepler part that the drift already integrates.
+    for (size_t k = 1; k < s.kx.size(); ++k) {
+        const double r2 = s.qx[k] * s.qx[k] + s.qy[k] * s.qy[k] + s.qz[k] * s.qz[k];
+        const double scale = m_G * m_mass[m_n + k - 1] / (r2 * std::sqrt(r2));
+        s.kx[k] += scale * s.qx[k];
+        s.ky[k] += scale * s.qy[k];
+        s.kz[k] += scale * s.qz[k];
+    }
+}
@@ -0,0 +1,194 @@
+// src/ias15.cpp
+#include "physics/ias15.hpp"
+#include <algorithm>
+
+// Gauss-Radau nodes of order 15 on [0, 1].
+static const double kNodes[8] = {
+    0.0,
+    0.0562625605369221464656521910318,
+    0.180240691736892364987579942780,
+    0.352624717113169637373907769648,
+    0.547153626330555383001448554766,
+    0.734210177215410531523210605558,
+    0.885320946839095768090359771030,
+    0.977520613561287501891174488626
+};
+
+// Lower-triangle index of (row, col) for col < row.
+static inline int tri(int row, int col) {
+    return row * (row - 1) / 2 + col;
+}
+
+Ias15::Ias15() {
+    for (int n = 1; n < 8; ++n)
+        for (int k = 0; k < n; ++k) m_rr[tri(n, k)] = kNodes[n] - kNodes[k];
+
+    // g_j multiplies t (t - h_1) ... (t - h_j); its coefficient of t^(k+1)
+    // is c(j, k), so b_k = sum_{j >= k} c(j, k) g_j.
+    double c[7][7] = {};
+    for (int j = 0; j < 7; ++j) {
+        double poly[8] = {1.0};
+        for (int m = 1; m <= j; ++m)
+            for (int p = m; p >= 0; --p) poly[p] = (p > 0 ? poly[p - 1] : 0.0) - kNodes[m] * poly[p];
+        for (int k = 0; k <= j; ++k) c[j][k] = poly[k];
+    }
+    // The inverse of that unit triangle: g_k = sum_{j >= k} d(j, k) b_j.
+    double d[7][7] = {};
+    for (int j = 0; j < 7; ++j) {
+        d[j][j] = 1.0;
+        for (int k = j - 1; k >= 0; --k) {
+            double sum = 0.0;
+            for (int m = k + 1; m <= j; ++m) sum -= c[m][k] * d[j][m];
+            d[j][k] = sum;
+        }
+    }
+    for (int j = 1; j < 7; ++j)
+        for (int k = 0; k < j; ++k) {
+            m_c[tri(j, k)] = c[j][k];
+            m_d[tri(j, k)] = d[j][k];
+        }
+}
+
+void Ias15::reset(size_t n, double interval) {
+    m_n = n;
+    m_dt = interval;
+    m_lastAccepted = 0.0;
+    for (auto* set : {&m_b, &m_g, &m_e, &m_bSaved, &m_eSaved})
+        for (auto& col : *set) col.assign(3 * n, 0.0);
+    m_csx.assign(3 * n, 0.0);
+    m_csv.assign(3 * n, 0.0);
+    m_x0.resize(3 * n);
+    m_v0.resize(3 * n);
+    m_a0.resize(3 * n);
+}
+
+void Ias15::begin(const BodyStorage& bodies) {
+    for (size_t i = 0; i < m_n; ++i) {
+        m_x0[3 * i] = bodies.x[i];  m_x0[3 * i + 1] = bodies.y[i];  m_x0[3 * i + 2] = bodies.z[i];
+        m_v0[3 * i] = bodies.vx[i]; m_v0[3 * i + 1] = bodies.vy[i]; m_v0[3 * i + 2] = bodies.vz[i];
+        m_a0[3 * i] = bodies.ax[i]; m_a0[3 * i + 1] = bodies.ay[i]; m_a0[3 * i + 2] = bodies.az[i];
+    }
+    for (size_t k = 0; k < 3 * m_n; ++k)
+        for (int j = 0; j < 7; ++j) {
+            double g = m_b[j][k];
+            for (int m = j + 1; m < 7; ++m) g += m_d[tri(m, j)] * m_b[m][k];
+            m_g[j][k] = g;
+        }
+}
+
+void Ias15::predict(BodyStorage& bodies, int node, double h) const {
+    const double s = kNodes[node];
+    const double sh = s * h;
+    double* out[3] = {bodies.x.data(), bodies.y.data(), bodies.z.data()};
+    for (size_t k = 0; k < 3 * m_n; ++k) {
+        const double poly = m_a0[k] / 2.0 + s * (m_b[0][k] / 6.0 + s * (m_b[1][k] / 12.0 + s * (m_b[2][k] / 20.0 +
+                            s * (m_b[3][k] / 30.0 + s * (m_b[4][k] / 42.0 + s * (m_b[5][k] / 56.0 + s * m_b[6][k] / 72.0))))));
+        out[k % 3][k / 3] = m_x0[k] + sh * (m_v0[k] + sh * poly);
+    }
+}
+
+void Ias15::absorb(const BodyStorage& bodies, int node) {
+    const int j = node - 1;
+    const double* acc[3] = {bodies.ax.data(), bodies.ay.data(), bodies.az.data()};
+    double maxDelta = 0.0, maxA = 0.0;
+    for (size_t k = 0; k < 3 * m_n; ++k) {
+        const double a = acc[k % 3][k / 3];
+        // Divided difference through the nodes evaluated so far.
+        double g = (a - m_a0[k]) / m_rr[tri(node, 0)];
+        for (int m = 1; m < node; ++m) g = (g - m_g[m - 1][k]) / m_rr[tri(node, m)];
+        const double delta = g - m_g[j][k];
+        m_g[j][k] = g;
+        for (int m = 0; m < j; ++m) m_b[m][k] += m_c[tri(j, m)] * delta;
+        m_b[j][k] += delta;
+        maxDelta = std::max(maxDelta, std::fabs(delta));
+        maxA = std::max(maxA, std::fabs(a));
+    }
+    if (node == 7) m_correction = maxA > 0.0 ? maxDelta / maxA : 0.0;
+}
+
+bool Ias15::finish(BodyStorage& bodies, double h, bool clipped, const Ias15Params& params) {
+    double maxB6 = 0.0, maxA = 0.0;
+    const double* acc[3] = {bodies.ax.data(), bodies.ay.data(), bodies.az.data()};
+    for (size_t k = 0; k < 3 * m_n; ++k) {
+        maxB6 = std::max(maxB6, std::fabs(m_b[6][k]));
+        maxA = std::max(maxA, std::fabs(acc[k % 3][k / 3]));
+    }
+    const double error = maxA > 0.0 ? maxB6 / maxA : 0.0;
+    double proposal = error > 0.0 && std::isfinite(error) ? h * std::pow(params.epsilon / error, 1.0 / 7.0) : 4.0 * h;
+    proposal = std::max(proposal, params.minStep);
+
+    if (proposal < 0.25 * h) {
+        for (size_t i = 0; i < m_n; ++i) {
+            bodies.x[i] = m_x0[3 * i];  bodies.y[i] = m_x0[3 * i + 1];  bodies.z[i] = m_x0[3 * i + 2];
+            bodies.vx[i] = m_v0[3 * i]; bodies.vy[i] = m_v0[3 * i + 1]; bodies.vz[i] = m_v0[3 * i + 2];
+            bodies.ax[i] = m_a0[3 * i]; bodies.ay[i] = m_a0[3 * i + 1]; bodies.az[i] = m_a0[3 * i + 2];
+        }
+        m_dt = proposal;
+        if (m_lastAccepted > 0.0) {
+            predictNext(m_dt / m_lastAccepted, m_eSaved, m_bSaved);
+        } else {
+            for (auto& col : m_b) std::fill(col.begin(), col.end(), 0.0);
+            for (auto& col : m_e) std::fill(col.begin(), col.end(), 0.0);
+        }
+        return false;
+    }
+
+    double* pos[3] = {bodies.x.data(), bodies.y.data(), bodies.z.data()};
+    double* vel[3] = {bodies.vx.data(), bodies.vy.data(), bodies.vz.data()};
+    for (size_t k = 0; k < 3 * m_n; ++k) {
+        const double dx = h * (m_v0[k] + h * (m_a0[k] / 2.0 + m_b[0][k] / 6.0 + m_b[1][k] / 12.0 + m_b[2][k] / 20.0 +
+                               m_b[3][k] / 30.0 + m_b[4][k] / 42.0 + m_b[5][k] / 56.0 + m_b[6][k] / 72.0));
+        const double dv = h * (m_a0[k] + m_b[0][k] / 2.0 + m_b[1][k] / 3.0 + m_b[2][k] / 4.0 +
+                               m_b[3][k] / 5.0 + m_b[4][k] / 6.0 + m_b[5][k] / 7.0 + m_b[6][k] / 8.0);
+        // Kahan summation onto the start values.
+        const double yx = dx - m_csx[k], tx = m_x0[k] + yx;
+        m_csx[k] = (tx - m_x0[k]) - yx;
+        pos[k % 3][k / 3] = tx;
+        const double yv = dv - m_csv[k], tv = m_v0[k] + yv;
+        m_csv[k] = (tv - m_v0[k]) - yv;
+        vel[k % 3][k / 3] = tv;
+    }
+
+    // A clipped step says nothing about the natural step length beyond
+    // whether it has to shrink.
+    m_dt = clipped ? std::min(m_dt, proposal) : std::min(proposal, 4.0 * h);
+    m_lastAccepted = h;
+    m_eSaved = m_e;
+    m_bSaved = m_b;
+    predictNext(m_dt / h, m_eSaved, m_bSaved);
+    return true;
+}
+
+void Ias15::predictNext(double ratio, const Coefficients& e, const Coefficients& b) {
+    // Far-off predictions are worse than starting from zero.
+    if (ratio > 20.0) {
+        for (auto& col : m_b) std::fill(col.begin(), col.end(), 0.0);
+        for (auto& col : m_e) std::fill(col.begin(), col.end(), 0.0);
+        return;
+    }
+    // e_k = q^(k+1) sum_{j >= k} binom(j+1, k+1) b_j: the polynomial of the
+    // last step re-expanded over the next one. The miss of the previous
+    // prediction (b - e) is carried over as a correction.
+    static const double binom[7][7] = {
+        {1, 2, 3, 4, 5, 6, 7},
+        {0, 1, 3, 6, 10, 15, 21},
+        {0, 0, 1, 4, 10, 20, 35},
+        {0, 0, 0, 1, 5, 15, 35},
+        {0, 0, 0, 0, 1, 6, 21},
+        {0, 0, 0, 0, 0, 1, 7},
+        {0, 0, 0, 0, 0, 0, 1}
+    };
+    double q[7];
+    q[0] = ratio;
+    for (int k = 1; k < 7; ++k) q[k] = q[k - 1] * ratio;
+
+    for (size_t idx = 0; idx < 3 * m_n; ++idx) {
+        for (int k = 0; k < 7; ++k) {
+            double sum = 0.0;
+            for (int j = k; j < 7; ++j) sum += binom[k][j] * b[j][idx];
+            const double predicted = q[k] * sum;
+            m_b[k][idx] = predicted + (b[k][idx] - e[k][idx]);
+            m_e[k][idx] = predicted;
+        }
+    }
+}
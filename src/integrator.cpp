@@ -0,0 +1,112 @@
+// src/integrator.cpp
+#include "physics/integrator.hpp"
+
+// Triple jump: w1 = 1 / (2 - 2^(1/3)), w0 = 1 - 2 w1.
+static const double kLeapfrog[] = {1.0};
+static const double kYoshida4[] = {
+    1.3512071919596578, -1.7024143839193153, 1.3512071919596578
+};
+
+// Yoshida (1990), solution A: w1..w3 as published, w0 = 1 - 2 (w1 + w2 + w3).
+static const double kYoshida6[] = {
+    0.784513610477560, 0.235573213359357, -1.17767998417887,
+    1.31518632068391,
+    -1.17767998417887, 0.235573213359357, 0.784513610477560
+};
+
+namespace integrators {
+
+bool isComposition(Integrator integrator) {
+    switch (integrator) {
+    case Integrator::VelocityVerlet:
+    case Integrator::Leapfrog:
+    case Integrator::Yoshida4:
+    case Integrator::Yoshida6: return true;
+    default:                   return false;
+    }
+}
+
+Composition composition(Integrator integrator) {
+    switch (integrator) {
+    case Integrator::Yoshida4: return {kYoshida4, 3};
+    case Integrator::Yoshida6: return {kYoshida6, 7};
+    default:                   return {kLeapfrog, 1};
+    }
+}
+
+int order(Integrator integrator) {
+    switch (integrator) {
+    case Integrator::Yoshida4:
+    case Integrator::Hermite:  return 4;
+    case Integrator::Yoshida6: return 6;
+    case Integrator::Rkf78:    return 8;
+    case Integrator::Ias15:    return 15;
+    default:                   return 2;
+    }
+}
+
+const char* name(Integrator integrator) {
+    switch (integrator) {
+    case Integrator::VelocityVerlet: return "velocity-verlet";
+    case Integrator::Leapfrog:       return "leapfrog";
+    case Integrator::Yoshida4:       return "yoshida4";
+    case Integrator::Yoshida6:       return "yoshida6";
+    case Integrator::WisdomHolman:   return "wisdom-holman";
+    case Integrator::BlockTimestep:  return "block-timestep";
+    case Integrator::Hermite:        return "hermite";
+    case Integrator::Ias15:          return "ias15";
+    case Integrator::Rkf78:          return "rkf78";
+    case Integrator::Hierarchical:   return "hierarchical-jacobi";
+    case Integrator::Parareal:       return "parareal";
+    }
+    return "unknown";
+}
+
+}
+
+void BlockSchedule::sort() {
+    const int levels = maxLevel + 1;
+    count.assign(levels, 0);
+    for (uint8_t l : level) ++count[l];
+
+    size_t fill[64];
+    size_t offset = 0;
+    for (int l = levels - 1; l >= 0; --l) {
+        fill[l] = offset;
+        offset += count[l];
+    }
+    order.resize(level.size());
+    for (size_t i = 0; i < level.size(); ++i) order[fill[level[i]]++] = uint32_t(i);
+}
+
+int BlockSchedule::finest() const {
+    int l = maxLevel;
+    while (l > 0 && count[l] == 0) --l;
+    return l;
+}
+
+size_t BlockSchedule::dueAt(uint64_t tick) const {
+    // Levels whose step divides the tick; at the end of the solver step
+    // that is every level.
+    int threshold = 0;
+    if (tick < ticks()) {
+        threshold = maxLevel;
+        for (uint64_t rest = tick; (rest & 1) == 0; rest >>= 1) --threshold;
+    }
+    size_t due = 0;
+    for (int l = threshold; l <= maxLevel; ++l) due += count[l];
+    return due;
+}
+
+int BlockSchedule::levelFor(double step, double dt) const {
+    int l = 0;
+    while (l < maxLevel && dt / double(uint64_t(1) << l) > step) ++l;
+    return l;
+}
+
+int BlockSchedule::next(int current, double step, double dt, uint64_t tick) const {
+    const int wanted = levelFor(step, dt);
+    if (wanted >= current) return wanted;
+    if (current == 0 || (tick & (stepTicks(current - 1) - 1)) != 0) return current;
+    return current - 1;
+}
@@ -71,13 +71,13 @@ int main() {
 
     glm::dvec3 totalMom(0.0);
     double totalMass = 0.0;
-       for (auto& b : solver.getBodies()) {
-    totalMom += b.mass * b.velocity;
-    totalMass += b.mass;
+       for (auto b : solver.getBodies()) {
+    totalMom += b.mass() * b.velocity();
+    totalMass += b.mass();
      }
         glm::dvec3 vCOM = totalMom / totalMass;
-        for (auto& b : solver.getBodies()) {
-        b.velocity -= vCOM; 
+        for (auto b : solver.getBodies()) {
+        b.setVelocity(b.velocity() - vCOM);
         }
 
 int frameCount = 0; 
@@ -0,0 +1,114 @@
+// src/p3m.cpp
+#include "physics/p3m.hpp"
+#include <algorithm>
+#include <cmath>
+
+static constexpr size_t kShapeSize = 2048;
+
+// Cells per axis are capped so a spread-out system with a tiny cutoff does
+// not allocate a huge, mostly empty grid.
+static constexpr size_t kMaxCellsPerAxis = 256;
+
+void P3mSolver::buildShape(double cutoff) {
+    if (cutoff == m_shapeCutoff && !m_shape.empty()) return;
+    m_shapeCutoff = cutoff;
+
+    // Entry k sits at r^2 = k / size * cutoff^2 (in units of r_s^2).
+    const double rootPi = std::sqrt(std::acos(-1.0));
+    m_shape.assign(kShapeSize + 2, 0.0);
+    for (size_t k = 0; k < kShapeSize; ++k) {
+        const double r = cutoff * std::sqrt(double(k) / double(kShapeSize));
+        m_shape[k] = std::erfc(0.5 * r) + r / rootPi * std::exp(-0.25 * r * r);
+    }
+}
+
+void P3mSolver::buildCells(const SourceSet& bodies) {
+    double hi[3] = {bodies.x[0], bodies.y[0], bodies.z[0]};
+    m_lo[0] = hi[0]; m_lo[1] = hi[1]; m_lo[2] = hi[2];
+    for (size_t i = 0; i < bodies.n; ++i) {
+        m_lo[0] = std::min(m_lo[0], bodies.x[i]); hi[0] = std::max(hi[0], bodies.x[i]);
+        m_lo[1] = std::min(m_lo[1], bodies.y[i]); hi[1] = std::max(hi[1], bodies.y[i]);
+        m_lo[2] = std::min(m_lo[2], bodies.z[i]); hi[2] = std::max(hi[2], bodies.z[i]);
+    }
+    for (int a = 0; a < 3; ++a) {
+        const double extent = hi[a] - m_lo[a];
+        const double cells = std::floor(extent / m_rcut);
+        m_dims[a] = size_t(std::clamp(cells, 1.0, double(kMaxCellsPerAxis)));
+        m_invCell[a] = extent > 0.0 ? double(m_dims[a]) / extent : 0.0;
+    }
+
+    const size_t cells = m_dims[0] * m_dims[1] * m_dims[2];
+    m_cellStart.assign(cells + 1, 0);
+    m_cellOf.resize(bodies.n);
+    for (size_t i = 0; i < bodies.n; ++i) {
+        const double p[3] = {bodies.x[i], bodies.y[i], bodies.z[i]};
+        size_t c[3];
+        for (int a = 0; a < 3; ++a)
+            c[a] = std::min(m_dims[a] - 1, size_t((p[a] - m_lo[a]) * m_invCell[a]));
+        const uint32_t cell = uint32_t((c[2] * m_dims[1] + c[1]) * m_dims[0] + c[0]);
+        m_cellOf[i] = cell;
+        ++m_cellStart[cell + 1];
+    }
+    for (size_t c = 0; c < cells; ++c) m_cellStart[c + 1] += m_cellStart[c];
+
+    std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+    m_order.resize(bodies.n);
+    for (size_t i = 0; i < bodies.n; ++i) m_order[fill[m_cellOf[i]]++] = uint32_t(i);
+
+    m_x.resize(bodies.n); m_y.resize(bodies.n); m_z.resize(bodies.n); m_m.resize(bodies.n);
+    m_ax.resize(bodies.n); m_ay.resize(bodies.n); m_az.resize(bodies.n);
+    for (size_t k = 0; k < bodies.n; ++k) {
+        const uint32_t i = m_order[k];
+        m_x[k] = bodies.x[i]; m_y[k] = bodies.y[i]; m_z[k] = bodies.z[i]; m_m[k] = bodies.m[i];
+    }
+}
+
+void P3mSolver::evaluate(const SourceSet& bodies, const AccelSet& out, double G,
+                         const P3mParams& params, ForceKernel kernel, ThreadPool& pool) {
+    if (bodies.n == 0) return;
+
+    // Long range straight into the output.
+    ParticleMeshParams mesh = params.mesh;
+    mesh.splitRadius = params.splitCells;
+    m_mesh.evaluate(bodies, out, G, mesh, pool);
+
+    m_rs = params.splitCells * m_mesh.spacing();
+    m_rcut = params.cutoff * m_rs;
+    buildShape(params.cutoff);
+    buildCells(bodies);
+    const PairShape shape{m_shape.data(), kShapeSize, double(kShapeSize) / (m_rcut * m_rcut)};
+
+    // Short range, one target cell per task against the 3x3 rows of
+    // neighbouring cells.
+    const size_t nx = m_dims[0], ny = m_dims[1], nz = m_dims[2];
+    TargetSet dst{m_x.data(), m_y.data(), m_z.data(), m_ax.data(), m_ay.data(), m_az.data()};
+    pool.parallelFor(0, nx * ny * nz, 4, [&](size_t begin, size_t end, unsigned) {
+        for (size_t cell = begin; cell < end; ++cell) {
+            const uint32_t tb = m_cellStart[cell], te = m_cellStart[cell + 1];
+            if (tb == te) continue;
+            std::fill(m_ax.begin() + tb, m_ax.begin() + te, 0.0);
+            std::fill(m_ay.begin() + tb, m_ay.begin() + te, 0.0);
+            std::fill(m_az.begin() + tb, m_az.begin() + te, 0.0);
+
+            const size_t cx = cell % nx, cy = (cell / nx) % ny, cz = cell / (nx * ny);
+            const size_t x0 = cx > 0 ? cx - 1 : 0, x1 = std::min(cx + 1, nx - 1);
+            for (size_t z = (cz > 0 ? cz - 1 : 0); z <= std::min(cz + 1, nz - 1); ++z)
+                for (size_t y = (cy > 0 ? cy - 1 : 0); y <= std::min(cy + 1, ny - 1); ++y) {
+                    const size_t row = (z * ny + y) * nx;
+                    const uint32_t sb = m_cellStart[row + x0], se = m_cellStart[row + x1 + 1];
+                    if (sb == se) continue;
+                    SourceSet src{m_x.data() + sb, m_y.data() + sb, m_z.data() + sb, m_m.data() + sb, se - sb};
+                    kernels::accumulateDirect(kernel, src, dst, tb, te, G, &shape);
+                }
+        }
+    });
+
+    pool.parallelFor(0, bodies.n, 4096, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; ++k) {
+            const uint32_t i = m_order[k];
+            out.ax[i] += m_ax[k];
+            out.ay[i] += m_ay[k];
+            out.az[i] += m_az[k];
+        }
+    });
+}
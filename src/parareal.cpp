@@ -0,0 +1,135 @@
+// src/parareal.cpp
+#include "physics/parareal.hpp"
+#include <algorithm>
+#include <cmath>
+
+void Parareal::resize(size_t n, size_t slices) {
+    m_n = n;
+    m_u.resize(slices + 1);
+    m_f.resize(slices);
+    m_g.resize(slices);
+    for (auto* states : {&m_u, &m_f, &m_g})
+        for (auto& state : *states) state.resize(6 * n);
+    m_coarse.resize(6 * n);
+    m_work.resize(slices + 1);
+    for (Work& w : m_work)
+        for (auto* col : {&w.x, &w.y, &w.z, &w.vx, &w.vy, &w.vz, &w.ax, &w.ay, &w.az})
+            col->resize(n);
+}
+
+void Parareal::force(Work& w) const {
+    std::fill(w.ax.begin(), w.ax.end(), 0.0);
+    std::fill(w.ay.begin(), w.ay.end(), 0.0);
+    std::fill(w.az.begin(), w.az.end(), 0.0);
+    SourceSet src{w.x.data(), w.y.data(), w.z.data(), m_mass, m_n};
+    TargetSet dst{w.x.data(), w.y.data(), w.z.data(), w.ax.data(), w.ay.data(), w.az.data()};
+    kernels::accumulateDirect(m_kernel, src, dst, 0, m_n, m_G);
+}
+
+// Same merged-kick KDK loop as Solver::stepComposition, on one slice.
+void Parareal::propagate(Work& w, const double* in, double* out, double h, int steps,
+                         const Composition& scheme) const {
+    const size_t n = m_n;
+    double* cols[6] = {w.x.data(), w.y.data(), w.z.data(), w.vx.data(), w.vy.data(), w.vz.data()};
+    for (int c = 0; c < 6; ++c) std::copy(in + c * n, in + (c + 1) * n, cols[c]);
+    force(w);
+
+    const double* weight = scheme.weights;
+    double pending = 0.5 * weight[0] * h;
+    for (int s = 0; s < steps; ++s) {
+        for (size_t k = 0; k < scheme.stages; ++k) {
+            const double drift = weight[k] * h;
+            for (size_t i = 0; i < n; ++i) {
+                w.vx[i] += w.ax[i] * pending;
+                w.vy[i] += w.ay[i] * pending;
+                w.vz[i] += w.az[i] * pending;
+                w.x[i] += w.vx[i] * drift;
+                w.y[i] += w.vy[i] * drift;
+                w.z[i] += w.vz[i] * drift;
+            }
+            force(w);
+            const double next = k + 1 < scheme.stages ? weight[k + 1] : (s + 1 < steps ? weight[0] : 0.0);
+            pending = 0.5 * (weight[k] + next) * h;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        w.vx[i] += w.ax[i] * pending;
+        w.vy[i] += w.ay[i] * pending;
+        w.vz[i] += w.az[i] * pending;
+    }
+    for (int c = 0; c < 6; ++c) std::copy(cols[c], cols[c] + n, out + c * n);
+}
+
+void Parareal::step(BodyStorage& bodies, double dt, double G, const PararealParams& params,
+                    ForceKernel kernel, ThreadPool& pool) {
+    const size_t n = bodies.size();
+    if (n == 0) return;
+    const size_t slices = params.slices > 0 ? params.slices : pool.size();
+    const int iterations = params.maxIterations > 0 ? std::min<int>(params.maxIterations, int(slices))
+                                                    : int(slices);
+    m_G = G;
+    m_kernel = kernel;
+    m_mass = bodies.mass.data();
+    resize(n, slices);
+    m_stats = PararealStats{};
+
+    const double h = dt / double(slices);
+    const int fineSteps = std::max(params.fineSteps, 1);
+    const int coarseSteps = std::max(params.coarseSteps, 1);
+    const Composition fine = integrators::composition(params.fine);
+    const Composition coarse = integrators::composition(Integrator::VelocityVerlet);
+
+    AlignedVector<double>* columns[6] = {&bodies.x, &bodies.y, &bodies.z, &bodies.vx, &bodies.vy, &bodies.vz};
+    for (int c = 0; c < 6; ++c) std::copy(columns[c]->begin(), columns[c]->end(), m_u[0].begin() + c * n);
+
+    // Corrections are measured against the largest position and speed.
+    double rMax = 0.0, vMax = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        rMax = std::max(rMax, glm::length(bodies.position(i)));
+        vMax = std::max(vMax, glm::length(bodies.velocity(i)));
+    }
+    const double invScale[2] = {rMax > 0.0 ? 1.0 / rMax : 1.0, vMax > 0.0 ? 1.0 / vMax : 1.0};
+
+    // Initial guess: one serial coarse sweep.
+    Work& serial = m_work[slices];
+    for (size_t k = 0; k < slices; ++k) {
+        propagate(serial, m_u[k].data(), m_g[k].data(), h / coarseSteps, coarseSteps, coarse);
+        m_u[k + 1] = m_g[k];
+    }
+
+    for (int it = 0; it < iterations; ++it) {
+        // Slices before `it` start from converged states; their fine
+        // results are final.
+        pool.parallelFor(size_t(it), slices, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t k = begin; k < end; ++k)
+                propagate(m_work[k], m_u[k].data(), m_f[k].data(), h / fineSteps, fineSteps, fine);
+        });
+        m_stats.fineSlices += slices - size_t(it);
+
+        double correction = 0.0;
+        for (size_t k = size_t(it); k < slices; ++k) {
+            propagate(serial, m_u[k].data(), m_coarse.data(), h / coarseSteps, coarseSteps, coarse);
+            std::vector<double>& next = m_u[k + 1];
+            for (size_t j = 0; j < 6 * n; ++j) {
+                // F + (G_new - G_old): exactly F once the start state stops moving.
+                const double value = m_f[k][j] + (m_coarse[j] - m_g[k][j]);
+                correction = std::max(correction, std::fabs(value - next[j]) * invScale[j >= 3 * n]);
+                next[j] = value;
+            }
+            m_g[k].swap(m_coarse);
+        }
+        m_stats.iterations = it + 1;
+        m_stats.correction = correction;
+        if (correction <= params.tolerance) break;
+    }
+
+    for (int c = 0; c < 6; ++c)
+        std::copy(m_u[slices].begin() + c * n, m_u[slices].begin() + (c + 1) * n, columns[c]->begin());
+
+    // Leave the accelerations of the final positions, like the other schemes.
+    AlignedVector<double>* accel[3] = {&bodies.ax, &bodies.ay, &bodies.az};
+    for (auto* col : accel) std::fill(col->begin(), col->end(), 0.0);
+    SourceSet src{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n};
+    TargetSet dst{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.ax.data(), bodies.ay.data(), bodies.az.data()};
+    kernels::accumulateDirect(kernel, src, dst, 0, n, G);
+}
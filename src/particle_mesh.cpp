@@ -0,0 +1,289 @@
+// src/particle_mesh.cpp
+#include "physics/particle_mesh.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Bodies are kept this many cells away from the mesh edge so the TSC
+// stencil plus the 4-point difference never reaches past it.
+static constexpr size_t kMargin = 4;
+
+// Self-potential of a uniform unit cube at its centre, used for the r = 0
+// entry of the Green's function.
+static constexpr double kCubeSelfPotential = 2.3800772;
+
+// Strided FFT lines gathered per task.
+static constexpr size_t kLineBlock = 8;
+
+// First cell and per-cell weights of a body at mesh coordinate u.
+static int stencil(MassAssignment scheme, double u, double w[3]) {
+    if (scheme == MassAssignment::Tsc) {
+        const double c = std::floor(u + 0.5);
+        const double d = u - c;
+        w[0] = 0.5 * (0.5 - d) * (0.5 - d);
+        w[1] = 0.75 - d * d;
+        w[2] = 0.5 * (0.5 + d) * (0.5 + d);
+        return int(c) - 1;
+    }
+    const double c = std::floor(u);
+    const double f = u - c;
+    w[0] = 1.0 - f;
+    w[1] = f;
+    w[2] = 0.0;
+    return int(c);
+}
+
+static int stencilWidth(MassAssignment scheme) {
+    return scheme == MassAssignment::Tsc ? 3 : 2;
+}
+
+void ParticleMesh::prepare(const ParticleMeshParams& params, ThreadPool& pool) {
+    const size_t grid = std::max<size_t>(params.grid, 4 * kMargin);
+    size_t m = 1;
+    while (m < grid) m <<= 1;
+    const double splitRadius = std::max(params.splitRadius, 0.0);
+    if (m == m_grid && splitRadius == m_split && params.assignment == m_assignment && !m_greenHat.empty())
+        return;
+
+    m_grid = m;
+    m_split = splitRadius;
+    m_assignment = params.assignment;
+    m_padded = 2 * m;
+    m_fft = Fft(m_padded);
+    const size_t P = m_padded;
+    m_work.assign(P * P * P, 0.0);
+    m_fx.assign(m * m * m, 0.0);
+    m_fy.assign(m * m * m, 0.0);
+    m_fz.assign(m * m * m, 0.0);
+
+    // -1/r (or its long-range part) on the padded mesh with wrapped
+    // distances, so the circular convolution equals the free-space one on
+    // the unpadded octant.
+    const double self = splitRadius > 0.0 ? 1.0 / (splitRadius * std::sqrt(std::acos(-1.0)))
+                                          : kCubeSelfPotential;
+    const double invTwoSplit = splitRadius > 0.0 ? 0.5 / splitRadius : 0.0;
+    pool.parallelFor(0, P, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; ++k) {
+            const double dz = double(std::min(k, P - k));
+            for (size_t j = 0; j < P; ++j) {
+                const double dy = double(std::min(j, P - j));
+                for (size_t i = 0; i < P; ++i) {
+                    const double dx = double(std::min(i, P - i));
+                    const double r = std::sqrt(dx * dx + dy * dy + dz * dz);
+                    double g = -self;
+                    if (r > 0.0) g = splitRadius > 0.0 ? -std::erf(r * invTwoSplit) / r : -1.0 / r;
+                    m_work[(k * P + j) * P + i] = g;
+                }
+            }
+        }
+    });
+    transformLines(0, P, P, false, pool);
+    transformLines(1, P, P, false, pool);
+    transformLines(2, P, P, false, pool);
+
+    // The kernel is real and even, so its transform is real. A split
+    // kernel is smooth enough to also divide out the assignment window
+    // (applied once when depositing and once when interpolating); on the
+    // raw 1/r kernel that would only amplify grid noise.
+    m_greenHat.resize(P * P * P);
+    const int order = stencilWidth(m_assignment);
+    const double pi = std::acos(-1.0);
+    auto window = [&](size_t i) {
+        const double a = pi * double(std::min(i, P - i)) / double(P);
+        return a > 0.0 ? std::pow(std::sin(a) / a, 2 * order) : 1.0;
+    };
+    pool.parallelFor(0, P, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; ++k)
+            for (size_t j = 0; j < P; ++j)
+                for (size_t i = 0; i < P; ++i) {
+                    const size_t c = (k * P + j) * P + i;
+                    double g = m_work[c].real();
+                    if (splitRadius > 0.0) g /= window(i) * window(j) * window(k);
+                    m_greenHat[c] = g;
+                }
+    });
+}
+
+void ParticleMesh::transformLines(int axis, size_t boundA, size_t boundB, bool inverse,
+                                  ThreadPool& pool) {
+    const size_t P = m_padded;
+    const size_t stride = axis == 0 ? 1 : (axis == 1 ? P : P * P);
+    // Lines are enumerated by (a, b): the two remaining indices in
+    // increasing stride order.
+    const size_t strideA = axis == 0 ? P : 1;
+    const size_t strideB = axis == 2 ? P : P * P;
+
+    m_lines.resize(pool.size());
+    for (auto& lines : m_lines) lines.resize(kLineBlock * P);
+
+    if (stride == 1) {
+        pool.parallelFor(0, boundA * boundB, 16, [&](size_t begin, size_t end, unsigned) {
+            for (size_t l = begin; l < end; ++l) {
+                std::complex<double>* line = m_work.data() + (l % boundA) * strideA + (l / boundA) * strideB;
+                inverse ? m_fft.inverse(line) : m_fft.forward(line);
+            }
+        });
+        return;
+    }
+
+    // Strided lines are neighbours along x, so gather kLineBlock of them at
+    // a time: every read then touches a run of contiguous elements instead
+    // of one element per cache line.
+    const size_t blocks = (boundA + kLineBlock - 1) / kLineBlock;
+    pool.parallelFor(0, blocks * boundB, 2, [&](size_t begin, size_t end, unsigned worker) {
+        std::complex<double>* lines = m_lines[worker].data();
+        for (size_t l = begin; l < end; ++l) {
+            const size_t a0 = (l % blocks) * kLineBlock;
+            const size_t count = std::min(kLineBlock, boundA - a0);
+            std::complex<double>* base = m_work.data() + a0 * strideA + (l / blocks) * strideB;
+            for (size_t t = 0; t < P; ++t)
+                for (size_t q = 0; q < count; ++q) lines[q * P + t] = base[t * stride + q];
+            for (size_t q = 0; q < count; ++q)
+                inverse ? m_fft.inverse(lines + q * P) : m_fft.forward(lines + q * P);
+            for (size_t t = 0; t < P; ++t)
+                for (size_t q = 0; q < count; ++q) base[t * stride + q] = lines[q * P + t];
+        }
+    });
+}
+
+void ParticleMesh::deposit(const SourceSet& bodies, ThreadPool& pool) {
+    const size_t M = m_grid, P = m_padded;
+    const int width = stencilWidth(m_assignment);
+
+    // Each worker deposits into its own grid; the grids are summed into
+    // the padded mesh afterwards, which also clears the padding.
+    m_density.resize(pool.size());
+    for (auto& grid : m_density) grid.assign(M * M * M, 0.0);
+
+    pool.parallelFor(0, bodies.n, 4096, [&](size_t begin, size_t end, unsigned worker) {
+        double* rho = m_density[worker].data();
+        for (size_t i = begin; i < end; ++i) {
+            double wx[3], wy[3], wz[3];
+            const int ix = stencil(m_assignment, (bodies.x[i] - m_origin[0]) / m_h, wx);
+            const int iy = stencil(m_assignment, (bodies.y[i] - m_origin[1]) / m_h, wy);
+            const int iz = stencil(m_assignment, (bodies.z[i] - m_origin[2]) / m_h, wz);
+            const double m = bodies.m[i];
+            for (int c = 0; c < width; ++c)
+                for (int b = 0; b < width; ++b) {
+                    const double wzy = m * wz[c] * wy[b];
+                    double* row = rho + (size_t(iz + c) * M + size_t(iy + b)) * M + ix;
+                    for (int a = 0; a < width; ++a) row[a] += wzy * wx[a];
+                }
+        }
+    });
+
+    pool.parallelFor(0, P * P, 64, [&](size_t begin, size_t end, unsigned) {
+        for (size_t row = begin; row < end; ++row) {
+            const size_t j = row % P, k = row / P;
+            std::complex<double>* dst = m_work.data() + row * P;
+            if (j >= M || k >= M) {
+                std::fill(dst, dst + P, 0.0);
+                continue;
+            }
+            for (size_t i = 0; i < M; ++i) {
+                double sum = 0.0;
+                for (const auto& grid : m_density) sum += grid[(k * M + j) * M + i];
+                dst[i] = sum;
+            }
+            std::fill(dst + M, dst + P, 0.0);
+        }
+    });
+}
+
+void ParticleMesh::convolve(double G, ThreadPool& pool) {
+    const size_t M = m_grid, P = m_padded;
+
+    // The density is zero outside the first octant and only that octant of
+    // the potential is needed, so the x and y passes skip lines that are
+    // all zero on the way in or never read on the way out.
+    transformLines(0, M, M, false, pool);
+    transformLines(1, P, M, false, pool);
+    transformLines(2, P, P, false, pool);
+
+    // Green's function for unit spacing scales as 1/h; fold in G and the
+    // 1/P^3 of the inverse transform.
+    const double scale = G / (m_h * double(P) * double(P) * double(P));
+    pool.parallelFor(0, m_work.size(), 1 << 16, [&](size_t begin, size_t end, unsigned) {
+        for (size_t c = begin; c < end; ++c) m_work[c] *= scale * m_greenHat[c];
+    });
+
+    transformLines(2, P, P, true, pool);
+    transformLines(1, P, M, true, pool);
+    transformLines(0, M, M, true, pool);
+}
+
+void ParticleMesh::differentiate(ThreadPool& pool) {
+    const size_t M = m_grid, P = m_padded;
+    const double inv12h = 1.0 / (12.0 * m_h);
+    auto phi = [&](size_t i, size_t j, size_t k) { return m_work[(k * P + j) * P + i].real(); };
+
+    // a = -grad phi with the fourth-order central difference
+    // (8 (phi+1 - phi-1) - (phi+2 - phi-2)) / 12h. The outer two layers are
+    // never touched by a stencil and stay zero.
+    pool.parallelFor(0, M, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; ++k)
+            for (size_t j = 0; j < M; ++j)
+                for (size_t i = 0; i < M; ++i) {
+                    const size_t c = (k * M + j) * M + i;
+                    if (i < 2 || j < 2 || k < 2 || i + 2 >= M || j + 2 >= M || k + 2 >= M) {
+                        m_fx[c] = m_fy[c] = m_fz[c] = 0.0;
+                        continue;
+                    }
+                    m_fx[c] = -(8.0 * (phi(i + 1, j, k) - phi(i - 1, j, k)) -
+                                (phi(i + 2, j, k) - phi(i - 2, j, k))) * inv12h;
+                    m_fy[c] = -(8.0 * (phi(i, j + 1, k) - phi(i, j - 1, k)) -
+                                (phi(i, j + 2, k) - phi(i, j - 2, k))) * inv12h;
+                    m_fz[c] = -(8.0 * (phi(i, j, k + 1) - phi(i, j, k - 1)) -
+                                (phi(i, j, k + 2) - phi(i, j, k - 2))) * inv12h;
+                }
+    });
+}
+
+void ParticleMesh::interpolate(const SourceSet& bodies, const AccelSet& out, ThreadPool& pool) const {
+    const size_t M = m_grid;
+    const int width = stencilWidth(m_assignment);
+    pool.parallelFor(0, bodies.n, 4096, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            double wx[3], wy[3], wz[3];
+            const int ix = stencil(m_assignment, (bodies.x[i] - m_origin[0]) / m_h, wx);
+            const int iy = stencil(m_assignment, (bodies.y[i] - m_origin[1]) / m_h, wy);
+            const int iz = stencil(m_assignment, (bodies.z[i] - m_origin[2]) / m_h, wz);
+            double ax = 0.0, ay = 0.0, az = 0.0;
+            for (int c = 0; c < width; ++c)
+                for (int b = 0; b < width; ++b) {
+                    const double wzy = wz[c] * wy[b];
+                    const size_t row = (size_t(iz + c) * M + size_t(iy + b)) * M + ix;
+                    for (int a = 0; a < width; ++a) {
+                        const double w = wzy * wx[a];
+                        ax += w * m_fx[row + a];
+                        ay += w * m_fy[row + a];
+                        az += w * m_fz[row + a];
+                    }
+                }
+            out.ax[i] = ax;
+            out.ay[i] = ay;
+            out.az[i] = az;
+        }
+    });
+}
+
+void ParticleMesh::evaluate(const SourceSet& bodies, const AccelSet& out, double G,
+                            const ParticleMeshParams& params, ThreadPool& pool) {
+    if (bodies.n == 0) return;
+    prepare(params, pool);
+
+    double lo[3] = {bodies.x[0], bodies.y[0], bodies.z[0]};
+    double hi[3] = {lo[0], lo[1], lo[2]};
+    for (size_t i = 0; i < bodies.n; ++i) {
+        lo[0] = std::min(lo[0], bodies.x[i]); hi[0] = std::max(hi[0], bodies.x[i]);
+        lo[1] = std::min(lo[1], bodies.y[i]); hi[1] = std::max(hi[1], bodies.y[i]);
+        lo[2] = std::min(lo[2], bodies.z[i]); hi[2] = std::max(hi[2], bodies.z[i]);
+    }
+    const double extent = std::max({hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]});
+    m_h = extent > 0.0 ? extent * (1.0 + 1e-9) / double(m_grid - 2 * kMargin) : 1.0;
+    for (int a = 0; a < 3; ++a) m_origin[a] = 0.5 * (lo[a] + hi[a]) - 0.5 * double(m_grid) * m_h;
+
+    deposit(bodies, pool);
+    convolve(G, pool);
+    differentiate(pool);
+    interpolate(bodies, out, pool);
+}
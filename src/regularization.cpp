@@ -0,0 +1,415 @@
+// src/regularization.cpp
+#include "physics/regularization.hpp"
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include "physics/integrator.hpp"
+#include "utils/math.hpp"
+
+// Advances the relative orbit (r, v) about mass parameter mu by h with the
+// Kustaanheimo-Stiefel transform. With r = L(u) u, u' = L(u)^T v / 2 and
+// dt = r ds the motion is u'' = (E/2) u; with z = -2 E s^2,
+//   t(s) = r0 s (1 + c1(z)) / 2 + (r.v) s^2 c2(z) + 2 |u'|^2 s^3 c3(z).
+static void ksDrift(double mu, double h, double r[3], double v[3]) {
+    const double r0 = std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    if (r0 == 0.0 || h == 0.0) return;
+
+    double u[4];
+    if (r[0] >= 0.0) {
+        u[0] = std::sqrt(0.5 * (r0 + r[0]));
+        u[1] = r[1] / (2.0 * u[0]);
+        u[2] = r[2] / (2.0 * u[0]);
+        u[3] = 0.0;
+    } else {
+        u[1] = std::sqrt(0.5 * (r0 - r[0]));
+        u[0] = r[1] / (2.0 * u[1]);
+        u[2] = 0.0;
+        u[3] = r[2] / (2.0 * u[1]);
+    }
+    double up[4] = {
+        0.5 * (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]),
+        0.5 * (-u[1] * v[0] + u[0] * v[1] + u[3] * v[2]),
+        0.5 * (-u[2] * v[0] - u[3] * v[1] + u[0] * v[2]),
+        0.5 * (u[3] * v[0] - u[2] * v[1] + u[1] * v[2])
+    };
+
+    const double v2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    const double rv = r[0] * v[0] + r[1] * v[1] + r[2] * v[2];
+    const double energy = 0.5 * v2 - mu / r0;
+    const double up2 = up[0] * up[0] + up[1] * up[1] + up[2] * up[2] + up[3] * up[3];
+
+    // Whole periods of a bound orbit change nothing.
+    if (energy < 0.0) {
+        const double period = 2.0 * std::acos(-1.0) * mu / std::pow(-2.0 * energy, 1.5);
+        if (std::fabs(h) > period) h = std::fmod(h, period);
+    }
+
+    // t(s) grows monotonically (dt/ds = r > 0): Newton, falling back to
+    // bisection (or doubling while unbracketed) when a step leaves the bracket.
+    double c[4];
+    double s = h / r0;
+    double lo = h > 0.0 ? 0.0 : -HUGE_VAL, hi = h > 0.0 ? HUGE_VAL : 0.0;
+    for (int it = 0; it < 100; ++it) {
+        stumpff(-2.0 * energy * s * s, c);
+        const double t = 0.5 * r0 * s * (1.0 + c[1]) + rv * s * s * c[2] + 2.0 * up2 * s * s * s * c[3];
+        const double rate = 0.5 * r0 * (1.0 + c[0]) + rv * s * c[1] + 2.0 * up2 * s * s * c[2];
+        if (t < h) lo = s; else hi = s;
+        double next = s - (t - h) / rate;
+        if (!(next > lo && next < hi)) next = std::isinf(lo) || std::isinf(hi) ? 2.0 * s : 0.5 * (lo + hi);
+        const double ds = next - s;
+        s = next;
+        if (std::fabs(ds) <= 1e-15 * std::fabs(s)) break;
+    }
+
+    stumpff(-0.5 * energy * s * s, c);
+    const double cs = c[0], sn = s * c[1];
+    double un[4], upn[4];
+    for (int k = 0; k < 4; ++k) {
+        un[k] = u[k] * cs + up[k] * sn;
+        upn[k] = 0.5 * energy * u[k] * sn + up[k] * cs;
+    }
+    const double rn = un[0] * un[0] + un[1] * un[1] + un[2] * un[2] + un[3] * un[3];
+    r[0] = un[0] * un[0] - un[1] * un[1] - un[2] * un[2] + un[3] * un[3];
+    r[1] = 2.0 * (un[0] * un[1] - un[2] * un[3]);
+    r[2] = 2.0 * (un[0] * un[2] + un[1] * un[3]);
+    v[0] = 2.0 * (un[0] * upn[0] - un[1] * upn[1] - un[2] * upn[2] + un[3] * upn[3]) / rn;
+    v[1] = 2.0 * (un[1] * upn[0] + un[0] * upn[1] - un[3] * upn[2] - un[2] * upn[3]) / rn;
+    v[2] = 2.0 * (un[2] * upn[0] + un[3] * upn[1] + un[0] * upn[2] + un[1] * upn[3]) / rn;
+}
+
+void Regularization::clear() {
+    m_members.clear();
+    m_systems.clear();
+    m_stats = RegularizationStats{};
+}
+
+void Regularization::select(const BodyStorage& bodies, double G, const RegularizationParams& params) {
+    clear();
+    m_G = G;
+    m_stepsPerOrbit = std::max(1, params.chainStepsPerOrbit);
+    const size_t n = bodies.size();
+    if (params.radius <= 0.0 || params.maxMembers < 2 || n < 2) return;
+
+    // Cells one radius wide, so every close pair sits in neighbouring cells.
+    auto cellLess = [](const CellEntry& a, const CellEntry& b) {
+        return std::tie(a.cx, a.cy, a.cz) < std::tie(b.cx, b.cy, b.cz);
+    };
+    const double inv = 1.0 / params.radius;
+    std::vector<CellEntry>& cells = m_cells;
+    cells.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        cells[i] = {int64_t(std::floor(bodies.x[i] * inv)), int64_t(std::floor(bodies.y[i] * inv)),
+                    int64_t(std::floor(bodies.z[i] * inv)), uint32_t(i)};
+    std::sort(cells.begin(), cells.end(), cellLess);
+
+    std::vector<Link>& links = m_links;
+    links.clear();
+    const double r2max = params.radius * params.radius;
+    for (const CellEntry& e : cells)
+        for (int64_t dx = -1; dx <= 1; ++dx)
+            for (int64_t dy = -1; dy <= 1; ++dy)
+                for (int64_t dz = -1; dz <= 1; ++dz) {
+                    const CellEntry key{e.cx + dx, e.cy + dy, e.cz + dz, 0};
+                    const auto range = std::equal_range(cells.begin(), cells.end(), key, cellLess);
+                    for (auto it = range.first; it != range.second; ++it) {
+                        const uint32_t i = e.i, j = it->i;
+                        if (j <= i) continue;
+                        const double rx = bodies.x[j] - bodies.x[i], ry = bodies.y[j] - bodies.y[i],
+                                     rz = bodies.z[j] - bodies.z[i];
+                        const double r2 = rx * rx + ry * ry + rz * rz;
+                        if (r2 >= r2max || r2 == 0.0) continue;
+                        const double vx = bodies.vx[j] - bodies.vx[i], vy = bodies.vy[j] - bodies.vy[i],
+                                     vz = bodies.vz[j] - bodies.vz[i];
+                        const double r = std::sqrt(r2);
+                        const double energy = 0.5 * (vx * vx + vy * vy + vz * vz) -
+                                              G * (bodies.mass[i] + bodies.mass[j]) / r;
+                        // Bound, or still closing in.
+                        if (energy < 0.0 || rx * vx + ry * vy + rz * vz < 0.0) links.push_back({r, i, j});
+                    }
+                }
+    if (links.empty()) return;
+
+    // Union-find over the links, tightest first.
+    std::sort(links.begin(), links.end(), [](const Link& a, const Link& b) { return a.r < b.r; });
+    std::vector<uint32_t>& parent = m_parent;
+    std::vector<uint32_t>& size = m_size;
+    parent.resize(n);
+    size.assign(n, 1);
+    for (size_t i = 0; i < n; ++i) parent[i] = uint32_t(i);
+    auto root = [&](uint32_t i) {
+        while (parent[i] != i) i = parent[i] = parent[parent[i]];
+        return i;
+    };
+    for (const Link& link : links) {
+        uint32_t a = root(link.i), b = root(link.j);
+        if (a == b || size[a] + size[b] > params.maxMembers) continue;
+        if (size[a] < size[b]) std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>>& grouped = m_grouped;
+    grouped.clear();
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t r = root(uint32_t(i));
+        if (size[r] > 1) grouped.push_back({r, uint32_t(i)});
+    }
+    std::sort(grouped.begin(), grouped.end());
+    for (size_t k = 0; k < grouped.size();) {
+        const size_t first = k;
+        while (k < grouped.size() && grouped[k].first == grouped[first].first) m_members.push_back(grouped[k++].second);
+        m_systems.push_back({first, k - first});
+        if (k - first == 2) ++m_stats.pairs;
+        else ++m_stats.chains;
+    }
+    m_stats.members = m_members.size();
+}
+
+void Regularization::cancelInternal(BodyStorage& bodies, double h) const {
+    for (const Subsystem& system : m_systems)
+        for (size_t a = system.first; a < system.first + system.count; ++a)
+            for (size_t b = a + 1; b < system.first + system.count; ++b) {
+                const uint32_t i = m_members[a], j = m_members[b];
+                const double dx = bodies.x[j] - bodies.x[i], dy = bodies.y[j] - bodies.y[i],
+                             dz = bodies.z[j] - bodies.z[i];
+                const double r2 = dx * dx + dy * dy + dz * dz;
+                const double inv3 = m_G * h / (r2 * std::sqrt(r2));
+                bodies.vx[i] -= bodies.mass[j] * inv3 * dx;
+                bodies.vy[i] -= bodies.mass[j] * inv3 * dy;
+                bodies.vz[i] -= bodies.mass[j] * inv3 * dz;
+                bodies.vx[j] += bodies.mass[i] * inv3 * dx;
+                bodies.vy[j] += bodies.mass[i] * inv3 * dy;
+                bodies.vz[j] += bodies.mass[i] * inv3 * dz;
+            }
+}
+
+void Regularization::gather(const BodyStorage& bodies) {
+    m_pos.resize(3 * m_members.size());
+    m_vel.resize(3 * m_members.size());
+    m_mass.resize(m_members.size());
+    for (size_t k = 0; k < m_members.size(); ++k) {
+        const uint32_t i = m_members[k];
+        m_pos[3 * k] = bodies.x[i];  m_pos[3 * k + 1] = bodies.y[i];  m_pos[3 * k + 2] = bodies.z[i];
+        m_vel[3 * k] = bodies.vx[i]; m_vel[3 * k + 1] = bodies.vy[i]; m_vel[3 * k + 2] = bodies.vz[i];
+        m_mass[k] = bodies.mass[i];
+    }
+}
+
+void Regularization::drift(BodyStorage& bodies, double h) {
+    for (const Subsystem& system : m_systems) {
+        if (system.count == 2) {
+            double* p = &m_pos[3 * system.first];
+            double* v = &m_vel[3 * system.first];
+            const double mi = m_mass[system.first], mj = m_mass[system.first + 1], total = mi + mj;
+            double r[3], w[3];
+            for (int c = 0; c < 3; ++c) {
+                r[c] = p[3 + c] - p[c];
+                w[c] = v[3 + c] - v[c];
+            }
+            const double r0[3] = {r[0], r[1], r[2]}, w0[3] = {w[0], w[1], w[2]};
+            ksDrift(m_G * total, h, r, w);
+            // Linear drift plus the change in relative motion, so the
+            // members never pass through large centre-of-mass sums.
+            for (int c = 0; c < 3; ++c) {
+                const double dr = r[c] - r0[c] - h * w0[c], dw = w[c] - w0[c];
+                p[c] += h * v[c] - mj / total * dr;
+                p[3 + c] += h * v[3 + c] + mi / total * dr;
+                v[c] -= mj / total * dw;
+                v[3 + c] += mi / total * dw;
+            }
+        } else {
+            chainDrift(system, h);
+        }
+    }
+
+    for (size_t k = 0; k < m_members.size(); ++k) {
+        const uint32_t i = m_members[k];
+        bodies.x[i] = m_pos[3 * k];  bodies.y[i] = m_pos[3 * k + 1];  bodies.z[i] = m_pos[3 * k + 2];
+        bodies.vx[i] = m_vel[3 * k]; bodies.vy[i] = m_vel[3 * k + 1]; bodies.vz[i] = m_vel[3 * k + 2];
+    }
+}
+
+// Logarithmic-Hamiltonian leapfrog (Mikkola & Tanikawa 1999) on chain
+// vectors X_k = x_(k+1) - x_k between nearest neighbours:
+//   drift: dt = ds / (T + B), X += dt V, t += dt
+//   kick:  V += (ds / U) (a_(k+1) - a_k)
+// with B = U - T at the start. It follows Kepler orbits exactly apart from
+// the time and stays regular through collisions; the Yoshida 6th-order
+// weights compose it. Positions of all pairs are sums of chain vectors,
+// so close separations never lose digits to the distance from the origin.
+void Regularization::chainDrift(const Subsystem& system, double h) {
+    const size_t m = system.count;
+    double* p = &m_pos[3 * system.first];
+    double* v = &m_vel[3 * system.first];
+    const double* mass = &m_mass[system.first];
+    double total = 0.0;
+    for (size_t k = 0; k < m; ++k) total += mass[k];
+
+    // Chain: start at the closest pair, then keep attaching the body
+    // nearest to either end.
+    auto dist2 = [&](size_t a, size_t b) {
+        double d2 = 0.0;
+        for (int c = 0; c < 3; ++c) d2 += (p[3 * b + c] - p[3 * a + c]) * (p[3 * b + c] - p[3 * a + c]);
+        return d2;
+    };
+    ChainScratch& cs = m_chain;
+    std::vector<uint8_t>& used = cs.used;
+    used.assign(m, 0);
+    size_t first = 0, second = 1;
+    for (size_t a = 0; a < m; ++a)
+        for (size_t b = a + 1; b < m; ++b)
+            if (dist2(a, b) < dist2(first, second)) first = a, second = b;
+    std::vector<size_t>& chain = cs.order;
+    chain.assign({first, second});
+    used[first] = used[second] = 1;
+    while (chain.size() < m) {
+        size_t best = m;
+        bool front = false;
+        double bestD2 = HUGE_VAL;
+        for (size_t k = 0; k < m; ++k) {
+            if (used[k]) continue;
+            const double df = dist2(k, chain.front()), db = dist2(k, chain.back());
+            if (std::min(df, db) < bestD2) {
+                bestD2 = std::min(df, db);
+                best = k;
+                front = df < db;
+            }
+        }
+        used[best] = 1;
+        if (front) chain.insert(chain.begin(), best);
+        else chain.push_back(best);
+    }
+
+    const size_t links = m - 1;
+    std::vector<double>& mc = cs.mass;
+    std::vector<double>& x0 = cs.x0;
+    std::vector<double>& v0 = cs.v0;
+    mc.resize(m);
+    x0.resize(3 * links);
+    v0.resize(3 * links);
+    for (size_t k = 0; k < m; ++k) mc[k] = mass[chain[k]];
+    for (size_t k = 0; k < links; ++k)
+        for (int c = 0; c < 3; ++c) {
+            x0[3 * k + c] = p[3 * chain[k + 1] + c] - p[3 * chain[k] + c];
+            v0[3 * k + c] = v[3 * chain[k + 1] + c] - v[3 * chain[k] + c];
+        }
+
+    std::vector<double>& x = cs.x;
+    std::vector<double>& w = cs.w;
+    std::vector<double>& acc = cs.acc;
+    std::vector<double>& vel = cs.vel;
+    x.resize(3 * links);
+    w.resize(3 * links);
+    acc.resize(3 * m);
+    vel.resize(3 * m);
+    // Centre-of-mass frame values of the bodies from chain vectors.
+    auto centred = [&](const std::vector<double>& vec, std::vector<double>& out) {
+        double mean[3] = {0.0, 0.0, 0.0};
+        for (int c = 0; c < 3; ++c) out[c] = 0.0;
+        for (size_t k = 1; k < m; ++k)
+            for (int c = 0; c < 3; ++c) out[3 * k + c] = out[3 * (k - 1) + c] + vec[3 * (k - 1) + c];
+        for (size_t k = 0; k < m; ++k)
+            for (int c = 0; c < 3; ++c) mean[c] += mc[k] * out[3 * k + c] / total;
+        for (size_t k = 0; k < m; ++k)
+            for (int c = 0; c < 3; ++c) out[3 * k + c] -= mean[c];
+    };
+    // Potential U, filling acc; separations from sums of chain vectors.
+    auto potential = [&]() {
+        std::fill(acc.begin(), acc.end(), 0.0);
+        double u = 0.0;
+        for (size_t i = 0; i < m; ++i) {
+            double d[3] = {0.0, 0.0, 0.0};
+            for (size_t j = i + 1; j < m; ++j) {
+                for (int c = 0; c < 3; ++c) d[c] += x[3 * (j - 1) + c];
+                const double r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+                const double r = std::sqrt(r2);
+                const double inv3 = m_G / (r2 * r);
+                u += m_G * mc[i] * mc[j] / r;
+                for (int c = 0; c < 3; ++c) {
+                    acc[3 * i + c] += mc[j] * inv3 * d[c];
+                    acc[3 * j + c] -= mc[i] * inv3 * d[c];
+                }
+            }
+        }
+        return u;
+    };
+    // Kinetic energy in the centre-of-mass frame.
+    auto kinetic = [&]() {
+        centred(w, vel);
+        double t = 0.0;
+        for (size_t k = 0; k < m; ++k)
+            for (int c = 0; c < 3; ++c) t += 0.5 * mc[k] * vel[3 * k + c] * vel[3 * k + c];
+        return t;
+    };
+
+    x = x0;
+    w = v0;
+    const double u0 = potential();
+    const double binding = u0 - kinetic();
+
+    double period = HUGE_VAL;
+    for (size_t k = 0; k < links; ++k) {
+        const double r = std::sqrt(x0[3 * k] * x0[3 * k] + x0[3 * k + 1] * x0[3 * k + 1] + x0[3 * k + 2] * x0[3 * k + 2]);
+        period = std::min(period, 2.0 * std::acos(-1.0) * std::sqrt(r * r * r / (m_G * (mc[k] + mc[k + 1]))));
+    }
+    const size_t steps = size_t(std::clamp(std::ceil(m_stepsPerOrbit * std::fabs(h) / period), 1.0, 1e6));
+
+    const Composition scheme = integrators::composition(Integrator::Yoshida6);
+    auto run = [&](double ds) {
+        x = x0;
+        w = v0;
+        double t = 0.0;
+        auto driftAR = [&](double d) {
+            const double dt = d / (kinetic() + binding);
+            for (size_t k = 0; k < 3 * links; ++k) x[k] += dt * w[k];
+            t += dt;
+        };
+        for (size_t s = 0; s < steps; ++s)
+            for (size_t k = 0; k < scheme.stages; ++k) {
+                const double d = scheme.weights[k] * ds;
+                driftAR(0.5 * d);
+                const double dt = d / potential();
+                for (size_t l = 0; l < links; ++l)
+                    for (int c = 0; c < 3; ++c) w[3 * l + c] += dt * (acc[3 * (l + 1) + c] - acc[3 * l + c]);
+                driftAR(0.5 * d);
+            }
+        m_stats.chainSubsteps += steps;
+        return t;
+    };
+
+    // t grows smoothly with ds: secant iterations land the chain on h.
+    double dsA = h * u0 / double(steps);
+    double tA = run(dsA);
+    if (std::fabs(tA - h) > 1e-15 * std::fabs(h)) {
+        double dsB = dsA * h / tA;
+        double tB = run(dsB);
+        for (int it = 0; it < 12 && std::fabs(tB - h) > 1e-15 * std::fabs(h) && tB != tA; ++it) {
+            const double next = dsB + (h - tB) * (dsB - dsA) / (tB - tA);
+            dsA = dsB;
+            tA = tB;
+            dsB = next;
+            tB = run(dsB);
+        }
+    }
+
+    // Back to bodies as linear drift plus the change in the centre-of-mass
+    // frame, as for pairs.
+    std::vector<double>& oldPos = cs.oldPos;
+    std::vector<double>& oldVel = cs.oldVel;
+    std::vector<double>& newPos = cs.newPos;
+    std::vector<double>& newVel = cs.newVel;
+    oldPos.resize(3 * m);
+    oldVel.resize(3 * m);
+    newPos.resize(3 * m);
+    newVel.resize(3 * m);
+    centred(x0, oldPos);
+    centred(v0, oldVel);
+    centred(x, newPos);
+    centred(w, newVel);
+    for (size_t k = 0; k < m; ++k)
+        for (int c = 0; c < 3; ++c) {
+            const size_t i = 3 * chain[k] + c, j = 3 * k + c;
+            p[i] += h * v[i] + (newPos[j] - oldPos[j] - h * oldVel[j]);
+            v[i] += newVel[j] - oldVel[j];
+        }
+}
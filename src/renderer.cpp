@@ -122,7 +122,7 @@ static glm::vec2 worldToNDC(const glm::dvec2& worldPos, double scaleMetersPerUni
     return glm::vec2((float)ndcX, (float)ndcY);
 }
 
-void Renderer::draw(const std::vector<Body>& solverBodies) {
+void Renderer::draw(ConstBodyView solverBodies) {
     if (solverBodies.empty()) return;
 
     glClearColor(0.02f, 0.02f, 0.05f, 1.0f);
@@ -136,9 +136,9 @@ void Renderer::draw(const std::vector<Body>& solverBodies) {
 
     glm::dvec3 bary(0.0);
     double totalMass = 0.0;
-    for (const auto& b : solverBodies) {
-        bary += b.mass * b.position;
-        totalMass += b.mass;
+    for (auto b : solverBodies) {
+        bary += b.mass() * b.position();
+        totalMass += b.mass();
     }
     if (totalMass != 0.0) bary /= totalMass;
 
@@ -157,7 +157,7 @@ void Renderer::draw(const std::vector<Body>& solverBodies) {
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
 
         GLint colorLoc = glGetUniformLocation(m_shaderProgram, "uColor");
-        const auto& c = solverBodies[i].color;
+        const auto& c = solverBodies[i].color();
         if (colorLoc >= 0) glUniform3f(colorLoc, c.r, c.g, c.b);
 
         glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)trail.size());
@@ -166,8 +166,10 @@ void Renderer::draw(const std::vector<Body>& solverBodies) {
     // --- Visual exaggeration for Moon ---
     std::vector<glm::dvec2> worldPositions;
     worldPositions.reserve(solverBodies.size());
-    for (const auto& b : solverBodies)
-        worldPositions.emplace_back(b.position.x - bary.x, b.position.y - bary.y);
+    for (auto b : solverBodies) {
+        glm::dvec3 p = b.position();
+        worldPositions.emplace_back(p.x - bary.x, p.y - bary.y);
+    }
 
     const double displayExaggeration = 50.0;
     if (worldPositions.size() >= 3) {
@@ -184,7 +186,7 @@ void Renderer::draw(const std::vector<Body>& solverBodies) {
     cols.reserve(worldPositions.size());
     for (size_t i = 0; i < worldPositions.size(); ++i) {
         ptsNDC.emplace_back(worldToNDC(worldPositions[i], m_scaleMetersPerUnit, m_width, m_height));
-        cols.emplace_back(solverBodies[i].color);
+        cols.emplace_back(solverBodies[i].color());
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, m_vboPoints);
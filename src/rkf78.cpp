@@ -0,0 +1,173 @@
+// src/rkf78.cpp
+#include "physics/rkf78.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Fehlberg (1968) 7(8) tableau, lower triangle row by row.
+static const double kA[13][12] = {
+    {},
+    {2.0 / 27.0},
+    {1.0 / 36.0, 1.0 / 12.0},
+    {1.0 / 24.0, 0.0, 1.0 / 8.0},
+    {5.0 / 12.0, 0.0, -25.0 / 16.0, 25.0 / 16.0},
+    {1.0 / 20.0, 0.0, 0.0, 1.0 / 4.0, 1.0 / 5.0},
+    {-25.0 / 108.0, 0.0, 0.0, 125.0 / 108.0, -65.0 / 27.0, 125.0 / 54.0},
+    {31.0 / 300.0, 0.0, 0.0, 0.0, 61.0 / 225.0, -2.0 / 9.0, 13.0 / 900.0},
+    {2.0, 0.0, 0.0, -53.0 / 6.0, 704.0 / 45.0, -107.0 / 9.0, 67.0 / 90.0, 3.0},
+    {-91.0 / 108.0, 0.0, 0.0, 23.0 / 108.0, -976.0 / 135.0, 311.0 / 54.0, -19.0 / 60.0, 17.0 / 6.0, -1.0 / 12.0},
+    {2383.0 / 4100.0, 0.0, 0.0, -341.0 / 164.0, 4496.0 / 1025.0, -301.0 / 82.0, 2133.0 / 4100.0,
+     45.0 / 82.0, 45.0 / 164.0, 18.0 / 41.0},
+    {3.0 / 205.0, 0.0, 0.0, 0.0, 0.0, -6.0 / 41.0, -3.0 / 205.0, -3.0 / 41.0, 3.0 / 41.0, 6.0 / 41.0, 0.0},
+    {-1777.0 / 4100.0, 0.0, 0.0, -341.0 / 164.0, 4496.0 / 1025.0, -289.0 / 82.0, 2193.0 / 4100.0,
+     51.0 / 82.0, 33.0 / 164.0, 12.0 / 41.0, 0.0, 1.0}
+};
+
+// 8th-order weights; the 7th-order ones differ only in stages 0, 10, 11
+// and 12, so the error is 41/840 h (k0 + k10 - k11 - k12).
+static const double kB[13] = {
+    0.0, 0.0, 0.0, 0.0, 0.0, 34.0 / 105.0, 9.0 / 35.0, 9.0 / 35.0, 9.0 / 280.0, 9.0 / 280.0,
+    0.0, 41.0 / 840.0, 41.0 / 840.0
+};
+static constexpr double kErrorWeight = 41.0 / 840.0;
+
+// Error e ~ h^8: the controller exponents are 0.7/8 and 0.4/8.
+static constexpr double kAlpha = 0.7 / 8.0;
+static constexpr double kBeta = 0.4 / 8.0;
+static constexpr double kSafety = 0.9;
+static constexpr double kMinFactor = 0.2;
+static constexpr double kMaxFactor = 5.0;
+
+static constexpr size_t kGrain = 1024;
+
+void RungeKuttaFehlberg::reset(size_t n) {
+    m_n = n;
+    m_dt = 0.0;
+    m_prevError = 1.0;
+    m_x0.assign(3 * n, 0.0);
+    m_v0.assign(3 * n, 0.0);
+    for (int s = 0; s < kStages; ++s) {
+        m_kx[s].assign(3 * n, 0.0);
+        m_kv[s].assign(3 * n, 0.0);
+    }
+}
+
+double RungeKuttaFehlberg::estimateStep(const BodyStorage& bodies, double interval) const {
+    double step = interval;
+    for (size_t i = 0; i < m_n; ++i) {
+        const double v = glm::length(bodies.velocity(i));
+        const double a = glm::length(bodies.acceleration(i));
+        if (v > 0.0 && a > 0.0) step = std::min(step, 0.01 * v / a);
+    }
+    return step;
+}
+
+void RungeKuttaFehlberg::save(const BodyStorage& bodies) {
+    const size_t n = m_n;
+    std::copy(bodies.x.begin(), bodies.x.end(), m_x0.begin());
+    std::copy(bodies.y.begin(), bodies.y.end(), m_x0.begin() + n);
+    std::copy(bodies.z.begin(), bodies.z.end(), m_x0.begin() + 2 * n);
+    std::copy(bodies.vx.begin(), bodies.vx.end(), m_v0.begin());
+    std::copy(bodies.vy.begin(), bodies.vy.end(), m_v0.begin() + n);
+    std::copy(bodies.vz.begin(), bodies.vz.end(), m_v0.begin() + 2 * n);
+}
+
+void RungeKuttaFehlberg::restore(BodyStorage& bodies) const {
+    const size_t n = m_n;
+    std::copy(m_x0.begin(), m_x0.begin() + n, bodies.x.begin());
+    std::copy(m_x0.begin() + n, m_x0.begin() + 2 * n, bodies.y.begin());
+    std::copy(m_x0.begin() + 2 * n, m_x0.end(), bodies.z.begin());
+    std::copy(m_v0.begin(), m_v0.begin() + n, bodies.vx.begin());
+    std::copy(m_v0.begin() + n, m_v0.begin() + 2 * n, bodies.vy.begin());
+    std::copy(m_v0.begin() + 2 * n, m_v0.end(), bodies.vz.begin());
+}
+
+void RungeKuttaFehlberg::stage(BodyStorage& bodies, int s, double h, ThreadPool& pool) {
+    const size_t n = m_n;
+    double* pos[3] = {bodies.x.data(), bodies.y.data(), bodies.z.data()};
+    double* vel[3] = {bodies.vx.data(), bodies.vy.data(), bodies.vz.data()};
+    pool.parallelFor(0, 3 * n, kGrain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; ++k) {
+            double dx = 0.0, dv = 0.0;
+            for (int j = 0; j < s; ++j) {
+                dx += kA[s][j] * m_kx[j][k];
+                dv += kA[s][j] * m_kv[j][k];
+            }
+            pos[k / n][k % n] = m_x0[k] + h * dx;
+            vel[k / n][k % n] = m_v0[k] + h * dv;
+        }
+    });
+}
+
+void RungeKuttaFehlberg::store(const BodyStorage& bodies, int s) {
+    const size_t n = m_n;
+    std::copy(bodies.vx.begin(), bodies.vx.end(), m_kx[s].begin());
+    std::copy(bodies.vy.begin(), bodies.vy.end(), m_kx[s].begin() + n);
+    std::copy(bodies.vz.begin(), bodies.vz.end(), m_kx[s].begin() + 2 * n);
+    std::copy(bodies.ax.begin(), bodies.ax.end(), m_kv[s].begin());
+    std::copy(bodies.ay.begin(), bodies.ay.end(), m_kv[s].begin() + n);
+    std::copy(bodies.az.begin(), bodies.az.end(), m_kv[s].begin() + 2 * n);
+}
+
+double RungeKuttaFehlberg::finish(BodyStorage& bodies, double h, ThreadPool& pool) {
+    const size_t n = m_n;
+    double* pos[3] = {bodies.x.data(), bodies.y.data(), bodies.z.data()};
+    double* vel[3] = {bodies.vx.data(), bodies.vy.data(), bodies.vz.data()};
+    const size_t blocks = (n + kGrain - 1) / kGrain;
+    m_blockError.assign(blocks, 0.0);
+
+    // Per body, so each one is scaled by its own position and speed.
+    pool.parallelFor(0, blocks, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t b = begin; b < end; ++b) {
+            double worst = 0.0;
+            for (size_t i = b * kGrain; i < std::min(n, (b + 1) * kGrain); ++i) {
+                double errX2 = 0.0, errV2 = 0.0, r2 = 0.0, v2 = 0.0, a2 = 0.0;
+                for (int c = 0; c < 3; ++c) {
+                    const size_t k = c * n + i;
+                    double dx = 0.0, dv = 0.0;
+                    for (int s = 0; s < kStages; ++s) {
+                        dx += kB[s] * m_kx[s][k];
+                        dv += kB[s] * m_kv[s][k];
+                    }
+                    const double ex = kErrorWeight * h * (m_kx[0][k] + m_kx[10][k] - m_kx[11][k] - m_kx[12][k]);
+                    const double ev = kErrorWeight * h * (m_kv[0][k] + m_kv[10][k] - m_kv[11][k] - m_kv[12][k]);
+                    pos[c][i] = m_x0[k] + h * dx;
+                    vel[c][i] = m_v0[k] + h * dv;
+                    errX2 += ex * ex;
+                    errV2 += ev * ev;
+                    r2 += m_x0[k] * m_x0[k];
+                    v2 += m_v0[k] * m_v0[k];
+                    a2 += m_kv[0][k] * m_kv[0][k];
+                }
+                const double sx = std::sqrt(r2) + h * std::sqrt(v2);
+                const double sv = std::sqrt(v2) + h * std::sqrt(a2);
+                if (sx > 0.0) worst = std::max(worst, std::sqrt(errX2) / sx);
+                if (sv > 0.0) worst = std::max(worst, std::sqrt(errV2) / sv);
+            }
+            m_blockError[b] = worst;
+        }
+    });
+    return *std::max_element(m_blockError.begin(), m_blockError.end());
+}
+
+bool RungeKuttaFehlberg::control(double error, double h, bool clipped, const RkfParams& params) {
+    const double scaled = std::max(error / params.tolerance, 1e-10);
+    const bool floor = params.minStep > 0.0 && h <= params.minStep;
+
+    if (scaled > 1.0 && !floor) {
+        m_dt = h * std::max(kMinFactor, kSafety * std::pow(scaled, -1.0 / 8.0));
+        if (params.minStep > 0.0) m_dt = std::max(m_dt, params.minStep);
+        return false;
+    }
+
+    // A clipped step is shorter than the controller asked for; its error
+    // says nothing about the natural step, which carries over unchanged.
+    if (clipped) return true;
+
+    double factor = kSafety * std::pow(scaled, -kAlpha) * std::pow(m_prevError, kBeta);
+    factor = std::clamp(factor, kMinFactor, kMaxFactor);
+    m_prevError = scaled;
+    m_dt = h * factor;
+    if (params.minStep > 0.0) m_dt = std::max(m_dt, params.minStep);
+    if (params.maxStep > 0.0) m_dt = std::min(m_dt, params.maxStep);
+    return true;
+}
@@ -0,0 +1,6 @@
+// src/scalar_solver.cpp
+#include "physics/scalar_solver.hpp"
+
+template class BasicSolver<float>;
+template class BasicSolver<double>;
+template class BasicSolver<long double>;
@@ -1,45 +1,733 @@
 // src/solver.cpp
 #include "physics/solver.hpp"
+#include <algorithm>
 #include <cmath>
+#include <random>
+#include <thread>
+#include "utils/alloc_counter.hpp"
 
-Solver::Solver(double timestep) : dt(timestep) {}
+// Index ranges smaller than this are not worth waking the pool for.
+static constexpr size_t kStreamGrain = 4096;
+
+// Mixed chunks cover whole blocks, so each float conversion of the sources
+// is shared by kMixedBlock targets.
+static size_t roundUpToMixedBlock(size_t grain) {
+    return (grain + kernels::kMixedBlock - 1) / kernels::kMixedBlock * kernels::kMixedBlock;
+}
+
+static unsigned hardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+Solver::Solver(double timestep, GravityBackend backend)
+    : dt(timestep), backend(backend), pool(std::make_unique<ThreadPool>(hardwareThreads())) {}
 
 void Solver::addBody(const Body& body) {
-    bodies.push_back(body);
+    bodies.push(body);
 }
 
 
 void Solver::computeAccelerations() {
-    for (auto& body : bodies) body.acceleration = {0.0, 0.0, 0.0};
+    const size_t n = bodies.size();
 
-    for (size_t i = 0; i < bodies.size(); ++i) {
-        for (size_t j = 0; j < bodies.size(); ++j) {
-            if (i == j) continue;
+    if (backend == GravityBackend::BarnesHut) {
+        computeBarnesHut();
+        return;
+    }
+    if (backend == GravityBackend::FastMultipole) {
+        computeFmm();
+        return;
+    }
+    if (backend == GravityBackend::ParticleMesh) {
+        computeParticleMesh();
+        return;
+    }
+    if (backend == GravityBackend::P3M) {
+        computeP3m();
+        return;
+    }
+    // The symmetric kernel is double only; the other precisions run the
+    // per-target sum below whatever symmetricForces says.
+    if (symmetricForces && precision == ForcePrecision::Double) {
+        computeSymmetric();
+        return;
+    }
+
+    SourceSet src{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n};
+    TargetSet dst{bodies.x.data(), bodies.y.data(), bodies.z.data(),
+                  bodies.ax.data(), bodies.ay.data(), bodies.az.data()};
+
+    // Each chunk of targets costs O(n); aim for several chunks per worker
+    // so uneven cores still balance.
+    size_t grain = std::max<size_t>(16, n / (8 * pool->size()));
+    if (precision == ForcePrecision::Mixed) grain = roundUpToMixedBlock(grain);
+    pool->parallelFor(0, n, grain, [&](size_t begin, size_t end, unsigned) {
+        std::fill(dst.ax + begin, dst.ax + end, 0.0);
+        std::fill(dst.ay + begin, dst.ay + end, 0.0);
+        std::fill(dst.az + begin, dst.az + end, 0.0);
+        if (precision == ForcePrecision::Mixed)
+            kernels::accumulateMixed(forceKernel, src, dst, begin, end, G);
+        else if (precision == ForcePrecision::Bposit32)
+            kernels::accumulateBposit(forceKernel, src, dst, begin, end, G);
+        else if (precision == ForcePrecision::Exact)
+            kernels::accumulateExact(forceKernel, src, dst, begin, end, G);
+        else
+            kernels::accumulateTiled(forceKernel, src, dst, begin, end, G, tiles);
+    });
+    if (precision == ForcePrecision::Mixed || precision == ForcePrecision::Bposit32) estimatePrecisionError();
+}
+
+void Solver::estimatePrecisionError() {
+    const size_t n = bodies.size();
+    const size_t k = std::min(precisionSamples, n);
+    if (k == 0) return;
+
+    // Evenly spaced bodies, shifted by one each pass so every body gets
+    // sampled over time.
+    sample.picks.resize(k);
+    for (size_t s = 0; s < k; ++s) sample.picks[s] = uint32_t((precisionOffset + s * (n / k)) % n);
+    precisionOffset = (precisionOffset + 1) % n;
+    precisionError = compareWithReference(forceKernel);
+}
+
+void Solver::setForceKernel(ForceKernel kernel) {
+    forceKernel = kernel;
+}
+
+ForceKernel Solver::getForceKernel() const {
+    return forceKernel;
+}
+
+void Solver::setForcePrecision(ForcePrecision mode) {
+    precision = mode;
+    precisionError = ForceErrorStats{};
+}
 
-            glm::dvec3 r = bodies[j].position - bodies[i].position;
-            double distSqr = glm::dot(r, r); 
-            double dist = sqrt(distSqr);
-            glm::dvec3 forceDir = r / dist;
+ForcePrecision Solver::getForcePrecision() const {
+    return precision;
+}
+
+void Solver::setPrecisionSamples(size_t samples) {
+    precisionSamples = samples;
+}
+
+const ForceErrorStats& Solver::getPrecisionErrorEstimate() const {
+    return precisionError;
+}
+
+void Solver::setTileConfig(const TileConfig& config) {
+    tiles = config;
+}
+
+const TileConfig& Solver::getTileConfig() const {
+    return tiles;
+}
+
+void Solver::setSymmetricForces(bool enabled) {
+    symmetricForces = enabled;
+}
+
+void Solver::setThreadCount(unsigned threads) {
+    if (threads == 0) threads = hardwareThreads();
+    if (threads != pool->size()) pool = std::make_unique<ThreadPool>(threads);
+}
+
+unsigned Solver::getThreadCount() const {
+    return pool->size();
+}
+
+void Solver::computeSymmetric() {
+    const size_t n = bodies.size();
+    SourceSet src{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n};
+    AccelSet out{bodies.ax.data(), bodies.ay.data(), bodies.az.data()};
+
+    const size_t parts = std::min<size_t>(pool->size(), std::max<size_t>(n / 2, 1));
+    if (parts <= 1) {
+        std::fill(bodies.ax.begin(), bodies.ax.end(), 0.0);
+        std::fill(bodies.ay.begin(), bodies.ay.end(), 0.0);
+        std::fill(bodies.az.begin(), bodies.az.end(), 0.0);
+        kernels::accumulateSymmetric(forceKernel, src, out, 0, n, G);
+        return;
+    }
+
+    // Part 0 writes straight into the body columns; the others get private
+    // buffers so no two workers ever touch the same reaction term.
+    threadAccels.resize(parts);
+    for (size_t p = 1; p < parts; ++p) {
+        threadAccels[p].ax.resize(n);
+        threadAccels[p].ay.resize(n);
+        threadAccels[p].az.resize(n);
+    }
+
+    pool->parallelFor(0, parts, 1, [&](size_t first, size_t last, unsigned) {
+        for (size_t p = first; p < last; ++p) {
+            AccelSet acc = out;
+            if (p > 0) acc = {threadAccels[p].ax.data(), threadAccels[p].ay.data(), threadAccels[p].az.data()};
+            std::fill(acc.ax, acc.ax + n, 0.0);
+            std::fill(acc.ay, acc.ay + n, 0.0);
+            std::fill(acc.az, acc.az + n, 0.0);
+            kernels::accumulateSymmetric(forceKernel, src, acc,
+                                         kernels::triangleRowSplit(n, parts, p),
+                                         kernels::triangleRowSplit(n, parts, p + 1), G);
+        }
+    });
 
-            bodies[i].acceleration += G * bodies[j].mass / distSqr * forceDir;
+    pool->parallelFor(0, n, kStreamGrain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t p = 1; p < parts; ++p) {
+            const AccelBuffer& buf = threadAccels[p];
+            for (size_t i = begin; i < end; ++i) {
+                bodies.ax[i] += buf.ax[i];
+                bodies.ay[i] += buf.ay[i];
+                bodies.az[i] += buf.az[i];
+            }
         }
+    });
+}
+
+void Solver::computeBarnesHut() {
+    const size_t n = bodies.size();
+    SourceSet src{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n};
+    AccelSet out{bodies.ax.data(), bodies.ay.data(), bodies.az.data()};
+
+    bhTree.build(src, bhParams);
+    bhScratch.resize(pool->size());
+    pool->parallelFor(0, bhTree.leafCount(), 4, [&](size_t begin, size_t end, unsigned worker) {
+        for (size_t leaf = begin; leaf < end; ++leaf)
+            bhTree.evaluateLeaf(leaf, forceKernel, G, bhScratch[worker]);
+    });
+    pool->parallelFor(0, n, kStreamGrain, [&](size_t begin, size_t end, unsigned) {
+        bhTree.scatter(begin, end, out);
+    });
+}
+
+void Solver::computeFmm() {
+    SourceSet src{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), bodies.size()};
+    AccelSet out{bodies.ax.data(), bodies.ay.data(), bodies.az.data()};
+    fmm.evaluate(src, out, G, fmmParams, forceKernel, *pool);
+}
+
+void Solver::computeParticleMesh() {
+    SourceSet src{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), bodies.size()};
+    AccelSet out{bodies.ax.data(), bodies.ay.data(), bodies.az.data()};
+    pm.evaluate(src, out, G, pmParams, *pool);
+}
+
+void Solver::computeP3m() {
+    SourceSet src{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), bodies.size()};
+    AccelSet out{bodies.ax.data(), bodies.ay.data(), bodies.az.data()};
+    p3m.evaluate(src, out, G, p3mParams, forceKernel, *pool);
+}
+
+GravityBackend Solver::getBackend() const {
+    return backend;
+}
+
+void Solver::setBarnesHutParams(const BarnesHutParams& params) {
+    bhParams = params;
+}
+
+const BarnesHutParams& Solver::getBarnesHutParams() const {
+    return bhParams;
+}
+
+void Solver::setFmmParams(const FmmParams& params) {
+    fmmParams = params;
+}
+
+const FmmParams& Solver::getFmmParams() const {
+    return fmmParams;
+}
+
+void Solver::setParticleMeshParams(const ParticleMeshParams& params) {
+    pmParams = params;
+}
+
+const ParticleMeshParams& Solver::getParticleMeshParams() const {
+    return pmParams;
+}
+
+void Solver::setP3mParams(const P3mParams& params) {
+    p3mParams = params;
+}
+
+const P3mParams& Solver::getP3mParams() const {
+    return p3mParams;
+}
+
+ForceErrorStats Solver::checkForceAccuracy(size_t samples, unsigned seed) {
+    ForceErrorStats stats;
+    const size_t n = bodies.size();
+    if (n == 0 || samples == 0) return stats;
+
+    computeAccelerations();
+
+    std::vector<uint32_t>& picks = sample.picks;
+    picks.resize(n);
+    for (size_t i = 0; i < n; ++i) picks[i] = uint32_t(i);
+    std::mt19937 rng(seed);
+    std::shuffle(picks.begin(), picks.end(), rng);
+    picks.resize(std::min(samples, n));
+    return compareWithReference(ForceKernel::Scalar);
+}
+
+ForceErrorStats Solver::compareWithReference(ForceKernel reference) {
+    ForceErrorStats stats;
+    const size_t n = bodies.size();
+    const std::vector<uint32_t>& picks = sample.picks;
+    const size_t k = picks.size();
+    if (k == 0) return stats;
+
+    // Reference accelerations for the sampled targets only: O(k N). The
+    // scratch columns only grow, so the per-pass estimate of the Mixed and
+    // Bposit32 modes stays off the heap.
+    sample.x.resize(k);
+    sample.y.resize(k);
+    sample.z.resize(k);
+    sample.ax.assign(k, 0.0);
+    sample.ay.assign(k, 0.0);
+    sample.az.assign(k, 0.0);
+    sample.errors.resize(k);
+    for (size_t s = 0; s < k; ++s) {
+        sample.x[s] = bodies.x[picks[s]];
+        sample.y[s] = bodies.y[picks[s]];
+        sample.z[s] = bodies.z[picks[s]];
+    }
+    const double* rx = sample.ax.data();
+    const double* ry = sample.ay.data();
+    const double* rz = sample.az.data();
+    SourceSet src{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n};
+    TargetSet ref{sample.x.data(), sample.y.data(), sample.z.data(),
+                  sample.ax.data(), sample.ay.data(), sample.az.data()};
+    pool->parallelFor(0, k, 16, [&](size_t begin, size_t end, unsigned) {
+        kernels::accumulateDirect(reference, src, ref, begin, end, G);
+    });
+
+    std::vector<double>& errors = sample.errors;
+    double sumSq = 0.0;
+    for (size_t s = 0; s < k; ++s) {
+        glm::dvec3 exact(rx[s], ry[s], rz[s]);
+        double err = glm::length(bodies.acceleration(picks[s]) - exact);
+        double norm = glm::length(exact);
+        errors[s] = norm > 0.0 ? err / norm : err;
+        sumSq += errors[s] * errors[s];
+        stats.maxRelError = std::max(stats.maxRelError, errors[s]);
     }
+    std::nth_element(errors.begin(), errors.begin() + k / 2, errors.end());
+    stats.samples = k;
+    stats.rmsRelError = std::sqrt(sumSq / double(k));
+    stats.medianRelError = errors[k / 2];
+    return stats;
+}
+
+void Solver::setIntegrator(Integrator scheme) {
+    // Wisdom-Holman with correctors, IAS15 and RKF leave accelerations of
+    // intermediate positions behind; the other schemes need them for the
+    // bodies.
+    const bool stale = integrator == Integrator::WisdomHolman || integrator == Integrator::Ias15 ||
+                       integrator == Integrator::Rkf78;
+    if (stale && scheme != integrator && !bodies.empty())
+        computeAccelerations();
+    if (scheme != integrator) {
+        block.schedule.level.clear();
+        hermite.reset();
+        ias15.reset();
+        rkf.reset();
+        regularization.clear();
+    }
+    integrator = scheme;
+}
+
+Integrator Solver::getIntegrator() const {
+    return integrator;
+}
+
+void Solver::setWisdomHolmanParams(const WisdomHolmanParams& params) {
+    whParams = params;
+}
+
+const WisdomHolmanParams& Solver::getWisdomHolmanParams() const {
+    return whParams;
+}
+
+void Solver::setBlockTimestepParams(const BlockTimestepParams& params) {
+    blockParams = params;
+    blockParams.maxLevel = std::clamp(blockParams.maxLevel, 0, 30);
+    block.schedule.level.clear();
+}
+
+const BlockTimestepParams& Solver::getBlockTimestepParams() const {
+    return blockParams;
+}
+
+const BlockTimestepStats& Solver::getBlockTimestepStats() const {
+    return blockStats;
+}
+
+void Solver::setHermiteParams(const HermiteParams& params) {
+    hermiteParams = params;
+    hermite.reset();
+}
+
+const HermiteParams& Solver::getHermiteParams() const {
+    return hermiteParams;
+}
+
+void Solver::setIas15Params(const Ias15Params& params) {
+    ias15Params = params;
+}
+
+const Ias15Params& Solver::getIas15Params() const {
+    return ias15Params;
+}
+
+const Ias15Stats& Solver::getIas15Stats() const {
+    return ias15.stats();
+}
+
+void Solver::setRkfParams(const RkfParams& params) {
+    rkfParams = params;
+}
+
+const RkfParams& Solver::getRkfParams() const {
+    return rkfParams;
+}
+
+const RkfStats& Solver::getRkfStats() const {
+    return rkf.stats();
+}
+
+void Solver::setPararealParams(const PararealParams& params) {
+    pararealParams = params;
+    // Slices run a composition; schemes outside the leapfrog family have
+    // none and would silently become a single leapfrog stage.
+    if (!integrators::isComposition(pararealParams.fine)) pararealParams.fine = Integrator::Leapfrog;
+}
+
+const PararealParams& Solver::getPararealParams() const {
+    return pararealParams;
+}
+
+const PararealStats& Solver::getPararealStats() const {
+    return parareal.stats();
+}
+
+void Solver::setRegularizationParams(const RegularizationParams& params) {
+    regularizationParams = params;
+    regularization.clear();
+}
+
+const RegularizationParams& Solver::getRegularizationParams() const {
+    return regularizationParams;
+}
+
+const RegularizationStats& Solver::getRegularizationStats() const {
+    return regularization.stats();
 }
 
 void Solver::update() {
+    if (integrator == Integrator::VelocityVerlet && regularizationParams.radius <= 0.0)
+        stepVerlet(1);
+    else if (integrator == Integrator::BlockTimestep)
+        stepBlock();
+    else if (integrator == Integrator::Ias15)
+        ias15.advance(bodies, dt, ias15Params, [this] { computeAccelerations(); });
+    else if (integrator == Integrator::Rkf78)
+        rkf.advance(bodies, dt, rkfParams, *pool, [this] { computeAccelerations(); });
+    else if (integrator == Integrator::Hermite)
+        hermite.step(bodies, dt, G, hermiteParams, forceKernel, *pool, blockStats);
+    else if (integrator == Integrator::Hierarchical)
+        hierarchy.step(bodies, dt, G, *pool, [this] { computeAccelerations(); });
+    else if (integrator == Integrator::Parareal)
+        parareal.step(bodies, dt, G, pararealParams, forceKernel, *pool);
+    else if (integrator == Integrator::WisdomHolman)
+        wh.step(bodies, dt, G, whParams, *pool, [this] { computeAccelerations(); });
+    else
+        stepComposition(integrators::composition(integrator), 1);
+}
 
-std::vector<glm::dvec3> oldAccels(bodies.size());
-for (size_t i=0; i<bodies.size(); ++i) oldAccels[i] = bodies[i].acceleration;
+void Solver::advance(size_t steps) {
+    steadyStateAllocations = 0;
+    if (steps == 0) return;
 
+    // Regularized subsystems are re-selected every step, so only the plain
+    // leapfrog family can run several steps in one go.
+    const bool plain = regularizationParams.radius <= 0.0;
+    const bool composition = integrator == Integrator::Leapfrog || integrator == Integrator::Yoshida4 ||
+                             integrator == Integrator::Yoshida6;
+    if (plain && integrator == Integrator::VelocityVerlet) {
+        stepVerlet(steps);
+    } else if (plain && composition) {
+        stepComposition(integrators::composition(integrator), steps);
+    } else {
+        update();
+        const size_t mark = allocations::count();
+        for (size_t s = 1; s < steps; ++s) update();
+        steadyStateAllocations = allocations::count() - mark;
+    }
+}
 
-for (auto &b : bodies) {
-    b.position += b.velocity * dt + 0.5 * b.acceleration * dt * dt;
+size_t Solver::getSteadyStateAllocations() const {
+    return steadyStateAllocations;
 }
 
-    computeAccelerations();
-    
-    for (size_t i = 0; i < bodies.size(); ++i) {
-        bodies[i].velocity += 0.5 * (oldAccels[i] + bodies[i].acceleration) * dt;
+// Velocity Verlet with the kick of one step and the drift of the next in
+// a single pass. The previous accelerations live in prevAx/Ay/Az, so the
+// result is bitwise the same as `steps` separate steps.
+void Solver::stepVerlet(size_t steps) {
+    const size_t n = bodies.size();
+    if (prevAx.size() != n) {
+        prevAx.resize(n);
+        prevAy.resize(n);
+        prevAz.resize(n);
+    }
+
+    pool->parallelFor(0, n, kStreamGrain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            prevAx[i] = bodies.ax[i];
+            prevAy[i] = bodies.ay[i];
+            prevAz[i] = bodies.az[i];
+            bodies.x[i] += bodies.vx[i] * dt + 0.5 * bodies.ax[i] * dt * dt;
+            bodies.y[i] += bodies.vy[i] * dt + 0.5 * bodies.ay[i] * dt * dt;
+            bodies.z[i] += bodies.vz[i] * dt + 0.5 * bodies.az[i] * dt * dt;
+        }
+    });
+
+    size_t mark = 0;
+    for (size_t s = 0; s < steps; ++s) {
+        if (s == 1) mark = allocations::count();
+        computeAccelerations();
+
+        const bool last = s + 1 == steps;
+        pool->parallelFor(0, n, kStreamGrain, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) {
+                bodies.vx[i] += 0.5 * (prevAx[i] + bodies.ax[i]) * dt;
+                bodies.vy[i] += 0.5 * (prevAy[i] + bodies.ay[i]) * dt;
+                bodies.vz[i] += 0.5 * (prevAz[i] + bodies.az[i]) * dt;
+            }
+            if (last) return;
+            for (size_t i = begin; i < end; ++i) {
+                prevAx[i] = bodies.ax[i];
+                prevAy[i] = bodies.ay[i];
+                prevAz[i] = bodies.az[i];
+                bodies.x[i] += bodies.vx[i] * dt + 0.5 * bodies.ax[i] * dt * dt;
+                bodies.y[i] += bodies.vy[i] * dt + 0.5 * bodies.ay[i] * dt * dt;
+                bodies.z[i] += bodies.vz[i] * dt + 0.5 * bodies.az[i] * dt * dt;
+            }
+        });
+    }
+    if (steps > 1) steadyStateAllocations = allocations::count() - mark;
+}
+
+// KDK substeps of w_k dt with the closing half kick of one substep merged
+// into the opening half kick of the next, across step boundaries too.
+// Expects the accelerations of the current positions on entry and leaves
+// them valid on exit.
+void Solver::stepComposition(const Composition& scheme, size_t steps) {
+    regularization.select(bodies, G, regularizationParams);
+    const double* w = scheme.weights;
+    const bool regularized = regularization.active();
+    double pending = 0.5 * w[0] * dt;
+    size_t mark = 0;
+    for (size_t s = 0; s < steps; ++s) {
+        if (s == 1) mark = allocations::count();
+        for (size_t k = 0; k < scheme.stages; ++k) {
+            if (regularized) {
+                kick(pending);
+                drift(w[k] * dt);
+            } else {
+                kickDrift(pending, w[k] * dt);
+            }
+            computeAccelerations();
+            const double next = k + 1 < scheme.stages ? w[k + 1] : (s + 1 < steps ? w[0] : 0.0);
+            pending = 0.5 * (w[k] + next) * dt;
+        }
+    }
+    kick(pending);
+    if (steps > 1) steadyStateAllocations = allocations::count() - mark;
+}
+
+void Solver::drift(double h) {
+    const bool regularized = regularization.active();
+    if (regularized) regularization.gather(bodies);
+    pool->parallelFor(0, bodies.size(), kStreamGrain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            bodies.x[i] += bodies.vx[i] * h;
+            bodies.y[i] += bodies.vy[i] * h;
+            bodies.z[i] += bodies.vz[i] * h;
+        }
+    });
+    if (regularized) regularization.drift(bodies, h);
+}
+
+void Solver::kick(double h) {
+    pool->parallelFor(0, bodies.size(), kStreamGrain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            bodies.vx[i] += bodies.ax[i] * h;
+            bodies.vy[i] += bodies.ay[i] * h;
+            bodies.vz[i] += bodies.az[i] * h;
+        }
+    });
+    if (regularization.active()) regularization.cancelInternal(bodies, h);
+}
+
+// kick(kickH) then drift(driftH) in one pass; not for regularized steps.
+void Solver::kickDrift(double kickH, double driftH) {
+    pool->parallelFor(0, bodies.size(), kStreamGrain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            bodies.vx[i] += bodies.ax[i] * kickH;
+            bodies.vy[i] += bodies.ay[i] * kickH;
+            bodies.vz[i] += bodies.az[i] * kickH;
+            bodies.x[i] += bodies.vx[i] * driftH;
+            bodies.y[i] += bodies.vy[i] * driftH;
+            bodies.z[i] += bodies.vz[i] * driftH;
+        }
+    });
+}
+
+static double blockStep(double a2, double j2, double eta) {
+    return j2 > 0.0 ? eta * std::sqrt(a2 / j2) : HUGE_VAL;
+}
+
+// Levels from the analytic jerk sum_j G m_j [v_ij - 3 (r_ij.v_ij) r_ij / r^2] / r^3.
+void Solver::initBlock() {
+    const size_t n = bodies.size();
+    BlockSchedule& schedule = block.schedule;
+    schedule.maxLevel = blockParams.maxLevel;
+    schedule.level.assign(n, 0);
+    block.prevAx.assign(bodies.ax.begin(), bodies.ax.end());
+    block.prevAy.assign(bodies.ay.begin(), bodies.ay.end());
+    block.prevAz.assign(bodies.az.begin(), bodies.az.end());
+
+    const size_t grain = std::max<size_t>(16, n / (8 * pool->size()));
+    pool->parallelFor(0, n, grain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            double jx = 0.0, jy = 0.0, jz = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+                const double dx = bodies.x[j] - bodies.x[i], dy = bodies.y[j] - bodies.y[i], dz = bodies.z[j] - bodies.z[i];
+                const double r2 = dx * dx + dy * dy + dz * dz;
+                if (r2 == 0.0) continue;
+                const double dvx = bodies.vx[j] - bodies.vx[i], dvy = bodies.vy[j] - bodies.vy[i], dvz = bodies.vz[j] - bodies.vz[i];
+                const double inv3 = G * bodies.mass[j] / (r2 * std::sqrt(r2));
+                const double rv = 3.0 * (dx * dvx + dy * dvy + dz * dvz) / r2;
+                jx += inv3 * (dvx - rv * dx);
+                jy += inv3 * (dvy - rv * dy);
+                jz += inv3 * (dvz - rv * dz);
+            }
+            const double a2 = bodies.ax[i] * bodies.ax[i] + bodies.ay[i] * bodies.ay[i] + bodies.az[i] * bodies.az[i];
+            const double step = blockStep(a2, jx * jx + jy * jy + jz * jz, blockParams.eta);
+            schedule.level[i] = uint8_t(schedule.levelFor(step, dt));
+        }
+    });
+    schedule.sort();
+}
+
+// Accelerations of the first `count` bodies of the schedule order. The
+// direct backend gathers them as targets against every body; other
+// backends evaluate the whole set.
+void Solver::computeActive(size_t count) {
+    const size_t n = bodies.size();
+    if (count == n || backend != GravityBackend::Direct) {
+        computeAccelerations();
+        return;
+    }
+
+    const std::vector<uint32_t>& order = block.schedule.order;
+    for (auto* col : {&block.x, &block.y, &block.z, &block.ax, &block.ay, &block.az}) col->resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        const uint32_t i = order[k];
+        block.x[k] = bodies.x[i];
+        block.y[k] = bodies.y[i];
+        block.z[k] = bodies.z[i];
+    }
+
+    SourceSet src{bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), n};
+    TargetSet dst{block.x.data(), block.y.data(), block.z.data(),
+                  block.ax.data(), block.ay.data(), block.az.data()};
+    size_t grain = std::max<size_t>(16, count / (8 * pool->size()));
+    if (precision == ForcePrecision::Mixed) grain = roundUpToMixedBlock(grain);
+    pool->parallelFor(0, count, grain, [&](size_t begin, size_t end, unsigned) {
+        std::fill(dst.ax + begin, dst.ax + end, 0.0);
+        std::fill(dst.ay + begin, dst.ay + end, 0.0);
+        std::fill(dst.az + begin, dst.az + end, 0.0);
+        if (precision == ForcePrecision::Mixed)
+            kernels::accumulateMixed(forceKernel, src, dst, begin, end, G);
+        else if (precision == ForcePrecision::Bposit32)
+            kernels::accumulateBposit(forceKernel, src, dst, begin, end, G);
+        else if (precision == ForcePrecision::Exact)
+            kernels::accumulateExact(forceKernel, src, dst, begin, end, G);
+        else
+            kernels::accumulateTiled(forceKernel, src, dst, begin, end, G, tiles);
+    });
+
+    for (size_t k = 0; k < count; ++k) {
+        const uint32_t i = order[k];
+        bodies.ax[i] = block.ax[k];
+        bodies.ay[i] = block.ay[k];
+        bodies.az[i] = block.az[k];
+    }
+}
+
+// One solver step of dt in block ticks. Velocities are synchronised at
+// both ends; inside the step each body carries its opening half kick
+// until its own step closes.
+void Solver::stepBlock() {
+    const size_t n = bodies.size();
+    if (n == 0) return;
+    BlockSchedule& schedule = block.schedule;
+    if (schedule.level.size() != n) initBlock();
+
+    const uint64_t ticks = schedule.ticks();
+    const double tick = dt / double(ticks);
+    auto stepOf = [&](int level) { return tick * double(schedule.stepTicks(level)); };
+    blockStats = BlockTimestepStats{};
+
+    for (size_t i = 0; i < n; ++i) {
+        const double h = 0.5 * stepOf(schedule.level[i]);
+        bodies.vx[i] += bodies.ax[i] * h;
+        bodies.vy[i] += bodies.ay[i] * h;
+        bodies.vz[i] += bodies.az[i] * h;
+    }
+
+    uint64_t t = 0;
+    while (t < ticks) {
+        const uint64_t next = t + schedule.stepTicks(schedule.finest());
+        drift(double(next - t) * tick);
+        t = next;
+
+        const size_t count = schedule.dueAt(t);
+        computeActive(count);
+        ++blockStats.substeps;
+        blockStats.activeTargets += count;
+
+        bool moved = false;
+        for (size_t k = 0; k < count; ++k) {
+            const uint32_t i = schedule.order[k];
+            const int level = schedule.level[i];
+            const double h = stepOf(level);
+            bodies.vx[i] += 0.5 * h * bodies.ax[i];
+            bodies.vy[i] += 0.5 * h * bodies.ay[i];
+            bodies.vz[i] += 0.5 * h * bodies.az[i];
+
+            const double jx = (bodies.ax[i] - block.prevAx[i]) / h;
+            const double jy = (bodies.ay[i] - block.prevAy[i]) / h;
+            const double jz = (bodies.az[i] - block.prevAz[i]) / h;
+            block.prevAx[i] = bodies.ax[i];
+            block.prevAy[i] = bodies.ay[i];
+            block.prevAz[i] = bodies.az[i];
+            const double a2 = bodies.ax[i] * bodies.ax[i] + bodies.ay[i] * bodies.ay[i] + bodies.az[i] * bodies.az[i];
+            const int wanted = schedule.next(level, blockStep(a2, jx * jx + jy * jy + jz * jz, blockParams.eta), dt, t);
+            if (wanted != level) {
+                schedule.level[i] = uint8_t(wanted);
+                moved = true;
+            }
+            if (t < ticks) {
+                const double open = 0.5 * stepOf(wanted);
+                bodies.vx[i] += open * bodies.ax[i];
+                bodies.vy[i] += open * bodies.ay[i];
+                bodies.vz[i] += open * bodies.az[i];
+            }
+        }
+        if (moved) schedule.sort();
     }
 }
 
@@ -47,9 +735,9 @@ glm::dvec3 Solver::getBarycenter() const {
     glm::dvec3 totalPos(0.0);
     double totalMass = 0.0;
 
-    for (const auto& body : bodies) {
-        totalPos += body.mass * body.position;
-        totalMass += body.mass;
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        totalPos += bodies.mass[i] * bodies.position(i);
+        totalMass += bodies.mass[i];
     }
 
     if (totalMass == 0.0) return {0.0, 0.0, 0.0};
@@ -60,10 +748,11 @@ double Solver::totalEnergy() const {
     double KE = 0.0;
     double PE = 0.0;
     for (size_t i = 0; i < bodies.size(); ++i) {
-        KE += 0.5 * bodies[i].mass * glm::dot(bodies[i].velocity, bodies[i].velocity);
+        glm::dvec3 v = bodies.velocity(i);
+        KE += 0.5 * bodies.mass[i] * glm::dot(v, v);
         for (size_t j = i + 1; j < bodies.size(); ++j) {
-            double r = glm::length(bodies[i].position - bodies[j].position);
-            PE -= G * bodies[i].mass * bodies[j].mass / r;
+            double r = glm::length(bodies.position(i) - bodies.position(j));
+            PE -= G * bodies.mass[i] * bodies.mass[j] / r;
         }
     }
     return KE + PE;
@@ -71,16 +760,15 @@ double Solver::totalEnergy() const {
 
 glm::dvec3 Solver::totalMomentum() const {
     glm::dvec3 P(0.0);
-    for (const auto& b : bodies)
-        P += b.mass * b.velocity;
+    for (size_t i = 0; i < bodies.size(); ++i)
+        P += bodies.mass[i] * bodies.velocity(i);
     return P;
 }
-std::vector<Body>& Solver::getBodies() {
-    return bodies;
-}
 
-const std::vector<Body>& Solver::getBodies() const {
-    return bodies;
+BodyView Solver::getBodies() {
+    return BodyView(bodies);
 }
 
-
+ConstBodyView Solver::getBodies() const {
+    return ConstBodyView(bodies);
+}
@@ -0,0 +1,76 @@
+// src/thread_pool.cpp
+#include "physics/thread_pool.hpp"
+#include <algorithm>
+
+static thread_local bool t_insideJob = false;
+
+ThreadPool::ThreadPool(unsigned threads) {
+    const unsigned extra = threads > 1 ? threads - 1 : 0;
+    m_workers.reserve(extra);
+    for (unsigned i = 0; i < extra; ++i)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, i + 1);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& w : m_workers) w.join();
+}
+
+void ThreadPool::dispatch(size_t begin, size_t end, size_t grain, Trampoline fn, void* ctx) {
+    if (end <= begin) return;
+    grain = std::max<size_t>(grain, 1);
+
+    if (m_workers.empty() || end - begin <= grain || t_insideJob) {
+        fn(ctx, begin, end, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fn = fn;
+        m_ctx = ctx;
+        m_end = end;
+        m_grain = grain;
+        m_next.store(begin, std::memory_order_relaxed);
+        m_busy = unsigned(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    t_insideJob = true;
+    drain(0);
+    t_insideJob = false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+}
+
+void ThreadPool::drain(unsigned worker) {
+    for (;;) {
+        size_t b = m_next.fetch_add(m_grain, std::memory_order_relaxed);
+        if (b >= m_end) break;
+        m_fn(m_ctx, b, std::min(b + m_grain, m_end), worker);
+    }
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+    t_insideJob = true;
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+
+        drain(index);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy == 0) m_done.notify_one();
+    }
+}
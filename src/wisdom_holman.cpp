@@ -0,0 +1,285 @@
+// src/wisdom_holman.cpp
+#include "physics/wisdom_holman.hpp"
+#include <algorithm>
+#include <cmath>
+#include "utils/math.hpp"
+
+// Advances one body on its Kepler orbit about mass parameter mu by h, in
+// universal variables (valid for any eccentricity). Kepler's equation in
+// the universal anomaly s is solved with Laguerre-Conway iterations.
+void keplerDrift(double mu, double h, double& x, double& y, double& z,
+                 double& vx, double& vy, double& vz) {
+    const double r0 = std::sqrt(x * x + y * y + z * z);
+    const double v2 = vx * vx + vy * vy + vz * vz;
+    const double eta0 = x * vx + y * vy + z * vz;
+    const double beta = 2.0 * mu / r0 - v2;
+    const double zeta0 = mu - beta * r0;
+
+    // Whole periods of a bound orbit change nothing.
+    if (beta > 0.0) {
+        const double period = 2.0 * std::acos(-1.0) * mu / (beta * std::sqrt(beta));
+        if (std::fabs(h) > period) h = std::fmod(h, period);
+    }
+
+    double s = h / r0 - 0.5 * h * h * eta0 / (r0 * r0 * r0 * r0);
+    double c[4];
+    for (int it = 0; it < 50; ++it) {
+        stumpff(beta * s * s, c);
+        const double g1 = s * c[1], g2 = s * s * c[2], g3 = s * s * s * c[3];
+        const double f = r0 * g1 + eta0 * g2 + mu * g3 - h;
+        const double fp = r0 * c[0] + eta0 * g1 + mu * g2;
+        const double fpp = eta0 * c[0] + zeta0 * g1;
+        const double root = std::sqrt(std::fabs(16.0 * fp * fp - 20.0 * f * fpp));
+        const double ds = -5.0 * f / (fp + std::copysign(root, fp));
+        s += ds;
+        if (std::fabs(ds) <= 1e-15 * std::fabs(s)) break;
+    }
+
+    stumpff(beta * s * s, c);
+    const double g1 = s * c[1], g2 = s * s * c[2], g3 = s * s * s * c[3];
+    const double r = r0 * c[0] + eta0 * g1 + mu * g2;
+    const double f = -mu * g2 / r0;           // f - 1
+    const double g = h - mu * g3;
+    const double fd = -mu * g1 / (r0 * r);
+    const double gd = -mu * g2 / r;           // gdot - 1
+
+    const double px = x, py = y, pz = z;
+    x += f * px + g * vx;
+    y += f * py + g * vy;
+    z += f * pz + g * vz;
+    vx += fd * px + gd * vx;
+    vy += fd * py + gd * vy;
+    vz += fd * pz + gd * vz;
+}
+
+// Jacobi coordinates of one axis: q_k = x_k - (sum_{j<k} m_j x_j) / eta_{k-1},
+// with the barycentre in slot 0. Velocities and accelerations transform
+// the same way.
+static void toJacobi(const double* col, const uint32_t* index, const double* mass,
+                     const double* eta, size_t n, double* out) {
+    double sum = mass[0] * col[index[0]];
+    for (size_t k = 1; k < n; ++k) {
+        const double v = col[index[k]];
+        out[k] = v - sum / eta[k - 1];
+        sum += mass[k] * v;
+    }
+    out[0] = sum / eta[n - 1];
+}
+
+static void fromJacobi(const double* q, const uint32_t* index, const double* mass,
+                       const double* eta, size_t n, double* col) {
+    double sum = eta[n - 1] * q[0];
+    for (size_t k = n - 1; k > 0; --k) {
+        const double v = (sum + eta[k - 1] * q[k]) / eta[k];
+        col[index[k]] = v;
+        sum -= mass[k] * v;
+    }
+    col[index[0]] = sum / mass[0];
+}
+
+// Democratic heliocentric: positions relative to the central body,
+// velocities relative to the barycentre; slot 0 holds the barycentre.
+static void toHeliocentric(const double* pos, const double* vel, const uint32_t* index,
+                           const double* mass, double total, size_t n, double* q, double* v) {
+    double sumX = 0.0, sumV = 0.0;
+    for (size_t k = 0; k < n; ++k) {
+        sumX += mass[k] * pos[index[k]];
+        sumV += mass[k] * vel[index[k]];
+    }
+    q[0] = sumX / total;
+    v[0] = sumV / total;
+    const double centre = pos[index[0]];
+    for (size_t k = 1; k < n; ++k) {
+        q[k] = pos[index[k]] - centre;
+        v[k] = vel[index[k]] - v[0];
+    }
+}
+
+static void fromHeliocentricPositions(const double* q, const uint32_t* index, const double* mass,
+                                      double total, size_t n, double* pos) {
+    double sum = 0.0;
+    for (size_t k = 1; k < n; ++k) sum += mass[k] * q[k];
+    const double centre = q[0] - sum / total;
+    pos[index[0]] = centre;
+    for (size_t k = 1; k < n; ++k) pos[index[k]] = q[k] + centre;
+}
+
+static void fromHeliocentricVelocities(const double* v, const uint32_t* index, const double* mass,
+                                       size_t n, double* vel) {
+    double sum = 0.0;
+    for (size_t k = 1; k < n; ++k) {
+        sum += mass[k] * v[k];
+        vel[index[k]] = v[k] + v[0];
+    }
+    vel[index[0]] = v[0] - sum / mass[0];
+}
+
+bool WisdomHolman::resume(const BodyStorage& bodies, double dt, double G,
+                          const WisdomHolmanParams& params) const {
+    const size_t n = bodies.size();
+    if (n != m_index.size() || dt != m_dt || G != m_G) return false;
+    if (params.coordinates != m_params.coordinates || params.correctorOrder != m_params.correctorOrder)
+        return false;
+    for (size_t k = 0; k < n; ++k) {
+        const uint32_t i = m_index[k];
+        if (bodies.mass[i] != m_mass[k]) return false;
+    }
+    for (size_t i = 0; i < n; ++i)
+        if (bodies.x[i] != m_outX[i] || bodies.y[i] != m_outY[i] || bodies.z[i] != m_outZ[i] ||
+            bodies.vx[i] != m_outVx[i] || bodies.vy[i] != m_outVy[i] || bodies.vz[i] != m_outVz[i])
+            return false;
+    return true;
+}
+
+void WisdomHolman::load(const BodyStorage& bodies, double dt, double G, const WisdomHolmanParams& params) {
+    const size_t n = bodies.size();
+    m_params = params;
+    if (m_params.correctorOrder != 0 && m_params.correctorOrder != 3) m_params.correctorOrder = 5;
+    m_dt = dt;
+    m_G = G;
+
+    const size_t central = size_t(std::max_element(bodies.mass.begin(), bodies.mass.end()) - bodies.mass.begin());
+    m_index.resize(n);
+    m_index[0] = uint32_t(central);
+    for (size_t i = 0, k = 1; i < n; ++i)
+        if (i != central) m_index[k++] = uint32_t(i);
+
+    m_mass.resize(n);
+    m_eta.resize(n);
+    double eta = 0.0;
+    for (size_t k = 0; k < n; ++k) {
+        m_mass[k] = bodies.mass[m_index[k]];
+        eta += m_mass[k];
+        m_eta[k] = eta;
+    }
+
+    State& s = m_state;
+    for (auto* col : {&s.qx, &s.qy, &s.qz, &s.vx, &s.vy, &s.vz, &s.kx, &s.ky, &s.kz})
+        col->assign(n, 0.0);
+    if (m_params.coordinates == WhCoordinates::Jacobi) {
+        toJacobi(bodies.x.data(), m_index.data(), m_mass.data(), m_eta.data(), n, s.qx.data());
+        toJacobi(bodies.y.data(), m_index.data(), m_mass.data(), m_eta.data(), n, s.qy.data());
+        toJacobi(bodies.z.data(), m_index.data(), m_mass.data(), m_eta.data(), n, s.qz.data());
+        toJacobi(bodies.vx.data(), m_index.data(), m_mass.data(), m_eta.data(), n, s.vx.data());
+        toJacobi(bodies.vy.data(), m_index.data(), m_mass.data(), m_eta.data(), n, s.vy.data());
+        toJacobi(bodies.vz.data(), m_index.data(), m_mass.data(), m_eta.data(), n, s.vz.data());
+    } else {
+        const double total = m_eta[n - 1];
+        toHeliocentric(bodies.x.data(), bodies.vx.data(), m_index.data(), m_mass.data(), total, n, s.qx.data(), s.vx.data());
+        toHeliocentric(bodies.y.data(), bodies.vy.data(), m_index.data(), m_mass.data(), total, n, s.qy.data(), s.vy.data());
+        toHeliocentric(bodies.z.data(), bodies.vz.data(), m_index.data(), m_mass.data(), total, n, s.qz.data(), s.vz.data());
+    }
+}
+
+void WisdomHolman::record(const BodyStorage& bodies) {
+    m_outX.assign(bodies.x.begin(), bodies.x.end());
+    m_outY.assign(bodies.y.begin(), bodies.y.end());
+    m_outZ.assign(bodies.z.begin(), bodies.z.end());
+    m_outVx.assign(bodies.vx.begin(), bodies.vx.end());
+    m_outVy.assign(bodies.vy.begin(), bodies.vy.end());
+    m_outVz.assign(bodies.vz.begin(), bodies.vz.end());
+}
+
+void WisdomHolman::writePositions(BodyStorage& bodies) const {
+    const size_t n = m_index.size();
+    const State& s = m_state;
+    if (m_params.coordinates == WhCoordinates::Jacobi) {
+        fromJacobi(s.qx.data(), m_index.data(), m_mass.data(), m_eta.data(), n, bodies.x.data());
+        fromJacobi(s.qy.data(), m_index.data(), m_mass.data(), m_eta.data(), n, bodies.y.data());
+        fromJacobi(s.qz.data(), m_index.data(), m_mass.data(), m_eta.data(), n, bodies.z.data());
+    } else {
+        const double total = m_eta[n - 1];
+        fromHeliocentricPositions(s.qx.data(), m_index.data(), m_mass.data(), total, n, bodies.x.data());
+        fromHeliocentricPositions(s.qy.data(), m_index.data(), m_mass.data(), total, n, bodies.y.data());
+        fromHeliocentricPositions(s.qz.data(), m_index.data(), m_mass.data(), total, n, bodies.z.data());
+    }
+}
+
+void WisdomHolman::writeState(BodyStorage& bodies) const {
+    writePositions(bodies);
+    const size_t n = m_index.size();
+    const State& s = m_state;
+    if (m_params.coordinates == WhCoordinates::Jacobi) {
+        fromJacobi(s.vx.data(), m_index.data(), m_mass.data(), m_eta.data(), n, bodies.vx.data());
+        fromJacobi(s.vy.data(), m_index.data(), m_mass.data(), m_eta.data(), n, bodies.vy.data());
+        fromJacobi(s.vz.data(), m_index.data(), m_mass.data(), m_eta.data(), n, bodies.vz.data());
+    } else {
+        fromHeliocentricVelocities(s.vx.data(), m_index.data(), m_mass.data(), n, bodies.vx.data());
+        fromHeliocentricVelocities(s.vy.data(), m_index.data(), m_mass.data(), n, bodies.vy.data());
+        fromHeliocentricVelocities(s.vz.data(), m_index.data(), m_mass.data(), n, bodies.vz.data());
+    }
+}
+
+void WisdomHolman::kepler(double h, ThreadPool& pool) {
+    State& s = m_state;
+    const size_t n = m_index.size();
+    s.qx[0] += h * s.vx[0];
+    s.qy[0] += h * s.vy[0];
+    s.qz[0] += h * s.vz[0];
+
+    // Jacobi body k orbits the interior mass eta_k; heliocentric bodies all
+    // orbit the central mass.
+    const bool jacobi = m_params.coordinates == WhCoordinates::Jacobi;
+    pool.parallelFor(1, n, 64, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; ++k) {
+            const double mu = m_G * (jacobi ? m_eta[k] : m_mass[0]);
+            keplerDrift(mu, h, s.qx[k], s.qy[k], s.qz[k], s.vx[k], s.vy[k], s.vz[k]);
+        }
+    });
+}
+
+// Heliocentric positions move with the total momentum of the orbiting
+// bodies over the central mass.
+void WisdomHolman::jump(double h) {
+    State& s = m_state;
+    const size_t n = m_index.size();
+    double px = 0.0, py = 0.0, pz = 0.0;
+    for (size_t k = 1; k < n; ++k) {
+        px += m_mass[k] * s.vx[k];
+        py += m_mass[k] * s.vy[k];
+        pz += m_mass[k] * s.vz[k];
+    }
+    const double scale = h / m_mass[0];
+    for (size_t k = 1; k < n; ++k) {
+        s.qx[k] += scale * px;
+        s.qy[k] += scale * py;
+        s.qz[k] += scale * pz;
+    }
+}
+
+void WisdomHolman::kick(double h) {
+    State& s = m_state;
+    for (size_t k = 1; k < m_index.size(); ++k) {
+        s.vx[k] += h * s.kx[k];
+        s.vy[k] += h * s.ky[k];
+        s.vz[k] += h * s.kz[k];
+    }
+}
+
+void WisdomHolman::interaction(const BodyStorage& bodies) {
+    State& s = m_state;
+    const size_t n = m_index.size();
+    const bool jacobi = m_params.coordinates == WhCoordinates::Jacobi;
+    if (jacobi) {
+        toJacobi(bodies.ax.data(), m_index.data(), m_mass.data(), m_eta.data(), n, s.kx.data());
+        toJacobi(bodies.ay.data(), m_index.data(), m_mass.data(), m_eta.data(), n, s.ky.data());
+        toJacobi(bodies.az.data(), m_index.data(), m_mass.data(), m_eta.data(), n, s.kz.data());
+    } else {
+        for (size_t k = 1; k < n; ++k) {
+            const uint32_t i = m_index[k];
+            s.kx[k] = bodies.ax[i];
+            s.ky[k] = bodies.ay[i];
+            s.kz[k] = bodies.az[i];
+        }
+    }
+
+    // Take out the Kepler part that the drift already integrates.
+    for (size_t k = 1; k < n; ++k) {
+        const double r2 = s.qx[k] * s.qx[k] + s.qy[k] * s.qy[k] + s.qz[k] * s.qz[k];
+        const double mu = m_G * (jacobi ? m_eta[k] : m_mass[0]);
+        const double scale = mu / (r2 * std::sqrt(r2));
+        s.kx[k] += scale * s.qx[k];
+        s.ky[k] += scale * s.qy[k];
+        s.kz[k] += scale * s.qz[k];
+    }
+}
@@ -0,0 +1,47 @@
+// tools/alloc_check.cpp
+// Runs Solver::advance for the fused integrators and every direct-sum
+// precision and fails if any step after the first touched the heap. Built
+// with NBODY_COUNT_ALLOCATIONS, where the counter is live; nothing else
+// runs in this process, so the process-wide count is the solver's own.
+#include <cstdio>
+#include <random>
+#include "physics/solver.hpp"
+#include "utils/alloc_counter.hpp"
+
+int main() {
+    if (!allocations::enabled()) {
+        std::printf("alloc_check: built without NBODY_COUNT_ALLOCATIONS, nothing to check\n");
+        return 0;
+    }
+
+    const ForcePrecision precisions[] = {ForcePrecision::Double, ForcePrecision::Mixed,
+                                         ForcePrecision::Bposit32, ForcePrecision::Exact};
+    const Integrator integrators[] = {Integrator::VelocityVerlet, Integrator::Leapfrog,
+                                      Integrator::Yoshida4, Integrator::Yoshida6};
+    int failures = 0;
+    for (ForcePrecision precision : precisions) {
+        for (Integrator integrator : integrators) {
+            Solver solver(60.0);
+            solver.setThreadCount(2);
+            solver.setForcePrecision(precision);
+            solver.setIntegrator(integrator);
+
+            std::mt19937_64 rng(7);
+            std::uniform_real_distribution<double> pos(-1.0e11, 1.0e11), vel(-1.0e3, 1.0e3);
+            for (int i = 0; i < 256; ++i) {
+                Body body;
+                body.mass = 1.0e24;
+                body.position = {pos(rng), pos(rng), pos(rng)};
+                body.velocity = {vel(rng), vel(rng), vel(rng)};
+                solver.addBody(body);
+            }
+            solver.computeAccelerations();
+            solver.advance(8);
+
+            const size_t count = solver.getSteadyStateAllocations();
+            std::printf("precision %d integrator %d: %zu allocations\n", int(precision), int(integrator), count);
+            if (count != 0) ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}